@@ -0,0 +1,1073 @@
+/**
+ * @file
+ * Dieses Modul misst den Durchsatz der Komprimierung und Dekomprimierung.
+ *
+ * Es erzeugt synthetische Testdaten unterschiedlicher Art und Größe,
+ * ergänzt um die Dateien aus testfiles/, und komprimiert und dekomprimiert
+ * jede Datei mit jedem Level. Jede Messung läuft in einem eigenen
+ * Kindprozess, damit der maximale Speicherbedarf (peak RSS) je Messung
+ * bestimmt werden kann. Zusätzlich wird je Datei allein das Zählen der
+ * Häufigkeiten (histogram_count) im Speicher gemessen. Die Ergebnisse
+ * werden als Tabelle sowie wahlweise als CSV und JSON ausgegeben.
+ *
+ * Aufruf: bench [-l<levels>] [-s<sizes>] [-r<repeats>] [-t<threads>]
+ *               [-d <dir>] [-csv <file>] [-json <file>] [file...]
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "huffman_common.h"
+#include "huffman.h"
+#include "histogram.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Maximale Anzahl der Dateien, die gemessen werden */
+#define MAX_CORPORA 64
+
+/** Maximale Anzahl der Level */
+#define MAX_LEVELS 7
+
+/** Maximale Anzahl der Größen synthetischer Testdaten */
+#define MAX_SIZES 8
+
+/** Maximale Länge eines Pfads */
+#define MAX_PATH 512
+
+/** Verzeichnis für Testdaten und Zwischenergebnisse */
+#define STD_DATA_DIR "bench_data"
+
+/** Verzeichnis mit den Testdateien des Projekts */
+#define TESTFILES_DIR "testfiles"
+
+/** Anzahl der Wiederholungen je Messung, die schnellste zählt */
+#define STD_REPEATS 3
+
+/** Startwert des Zufallsgenerators, damit die Testdaten gleich bleiben */
+#define RANDOM_SEED 0x9E3779B97F4A7C15ull
+
+/** Anzahl der Wörter im Vokabular der Textdaten */
+#define VOCABULARY_SIZE 512
+
+/** Fehlermeldung bei ungültigen Parametern */
+#define EMSG_INVALID_OPTION "Ungueltige Option."
+
+/** Fehlermeldung, wenn eine Datei nicht geschrieben werden kann */
+#define EMSG_WRITE_FAILED "Datei kann nicht geschrieben werden."
+
+/** Fehlermeldung, wenn eine Datei nicht gelesen werden kann */
+#define EMSG_READ_FAILED "Datei kann nicht gelesen werden."
+
+/** Fehlermeldung, wenn ein Kindprozess nicht gestartet werden kann */
+#define EMSG_FORK_FAILED "Messprozess kann nicht gestartet werden."
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Erzeugt synthetische Testdaten.
+ *
+ * @param data      zu füllender Puffer
+ * @param size      Anzahl der Zeichen
+ * @param state     Zustand des Zufallsgenerators
+ */
+typedef void (*GENERATOR)(unsigned char data[], size_t size, uint64_t *state);
+
+/**
+ * Art synthetischer Testdaten
+ */
+typedef struct
+{
+    /** Name der Art */
+    const char *name;
+
+    /** Funktion, die die Daten erzeugt */
+    GENERATOR generate;
+} CORPUS_KIND;
+
+/**
+ * Eine zu messende Datei
+ */
+typedef struct
+{
+    /** Name in der Ausgabe */
+    char name[64];
+
+    /** Pfad der Datei */
+    char path[MAX_PATH];
+
+    /** Größe in Byte */
+    uint64_t size;
+
+    /** schnellste Laufzeit von histogram_count in Sekunden, -1 bei Fehler */
+    double histogram_seconds;
+} CORPUS;
+
+/**
+ * Ergebnis einer Messung im Kindprozess
+ */
+typedef struct
+{
+    /** schnellste Laufzeit in Sekunden */
+    double seconds;
+
+    /** maximaler Speicherbedarf in KiB */
+    long peak_rss_kib;
+} MEASUREMENT;
+
+/**
+ * Ergebnis für eine Datei und ein Level
+ */
+typedef struct
+{
+    /** gemessene Datei */
+    const CORPUS *corpus;
+
+    /** Level der Komprimierung */
+    int level;
+
+    /** Größe der komprimierten Datei in Byte */
+    uint64_t compressed_size;
+
+    /** Messung der Komprimierung */
+    MEASUREMENT compress;
+
+    /** Messung der Dekomprimierung */
+    MEASUREMENT decompress;
+
+    /** true, wenn die dekomprimierte Datei der Eingabe gleicht */
+    bool ok;
+} RESULT;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Liest die Parameter des Aufrufs.
+ *
+ * @param argc  Anzahl der Argumente
+ * @param argv  Argumente
+ * @return      false bei einem ungültigen Parameter
+ */
+static bool read_arguments(int argc, char **argv);
+
+/**
+ * Liest eine Liste von Zahlen ("1,3,5" oder "1-7").
+ *
+ * @param text      zu lesender Text
+ * @param values    gelesene Zahlen (Ausgabe)
+ * @param max_count maximale Anzahl der Zahlen
+ * @return          Anzahl der gelesenen Zahlen, 0 bei einem Fehler
+ */
+static int parse_list(const char *text, long values[], int max_count);
+
+/**
+ * Legt die synthetischen Testdaten an, sofern sie noch nicht vorhanden
+ * sind, und ergänzt die Dateien aus testfiles/ und der Kommandozeile.
+ */
+static void prepare_corpora(void);
+
+/**
+ * Fügt eine Datei zu den zu messenden Dateien hinzu.
+ *
+ * @param name      Name in der Ausgabe
+ * @param path      Pfad der Datei
+ */
+static void add_corpus(const char *name, const char *path);
+
+/**
+ * Misst, wie lange das Zählen der Häufigkeiten einer Datei im Speicher
+ * dauert (schnellste von repeats Messungen).
+ *
+ * @param corpus    zu messende Datei
+ * @return          Laufzeit in Sekunden, -1 wenn die Datei nicht gelesen
+ *                  werden kann
+ */
+static double measure_histogram(const CORPUS *corpus);
+
+/**
+ * Misst Komprimierung und Dekomprimierung einer Datei mit einem Level.
+ *
+ * @param corpus    zu messende Datei
+ * @param level     Level der Komprimierung
+ * @param result    Ergebnis (Ausgabe)
+ */
+static void run_benchmark(const CORPUS *corpus, int level, RESULT *result);
+
+/**
+ * Führt repeats-mal die Komprimierung bzw. Dekomprimierung in einem
+ * Kindprozess aus.
+ *
+ * @param compress      true: komprimieren, false: dekomprimieren
+ * @param in_filename   Eingabedatei
+ * @param out_filename  Ausgabedatei
+ * @param options       Einstellungen
+ * @param measurement   Ergebnis (Ausgabe)
+ */
+static void measure(bool compress, char in_filename[], char out_filename[],
+                    const HUFFMAN_OPTIONS *options, MEASUREMENT *measurement);
+
+/**
+ * Vergleicht den Inhalt zweier Dateien.
+ *
+ * @param a         erste Datei
+ * @param b         zweite Datei
+ * @return          true, wenn beide Dateien gleich sind
+ */
+static bool files_equal(const char *a, const char *b);
+
+/**
+ * Liefert die Größe einer Datei.
+ *
+ * @param path      Pfad der Datei
+ * @return          Größe in Byte, 0 wenn die Datei nicht existiert
+ */
+static uint64_t file_size(const char *path);
+
+/**
+ * Gibt die Ergebnisse als Tabelle aus.
+ *
+ * @param out       Ausgabestrom
+ */
+static void print_table(FILE *out);
+
+/**
+ * Gibt die Ergebnisse im CSV-Format aus.
+ *
+ * @param out       Ausgabestrom
+ */
+static void print_csv(FILE *out);
+
+/**
+ * Gibt die Ergebnisse im JSON-Format aus.
+ *
+ * @param out       Ausgabestrom
+ */
+static void print_json(FILE *out);
+
+/**
+ * Berechnet den Durchsatz in MB/s (10^6 Byte je Sekunde).
+ *
+ * @param size      Anzahl der unkomprimierten Zeichen
+ * @param seconds   Laufzeit in Sekunden
+ * @return          Durchsatz
+ */
+static double megabytes_per_second(uint64_t size, double seconds);
+
+/**
+ * Liefert die nächste Zufallszahl (xorshift64*).
+ *
+ * @param state     Zustand des Zufallsgenerators
+ * @return          Zufallszahl
+ */
+static uint64_t next_random(uint64_t *state);
+
+/**
+ * Zufällige Zeichen aus 64 gleich häufigen Symbolen
+ */
+static void generate_random(unsigned char data[], size_t size,
+                            uint64_t *state);
+
+/**
+ * Zufällige Zeichen, deren Häufigkeit geometrisch abnimmt
+ */
+static void generate_skewed(unsigned char data[], size_t size,
+                            uint64_t *state);
+
+/**
+ * Text aus Wörtern eines festen Vokabulars mit Zipf-ähnlicher Häufigkeit
+ */
+static void generate_text(unsigned char data[], size_t size, uint64_t *state);
+
+/**
+ * Folgen gleicher Zeichen mit zufälliger Länge
+ */
+static void generate_runs(unsigned char data[], size_t size, uint64_t *state);
+
+/**
+ * Zufällige Zeichen aus allen 256 Bytewerten
+ */
+static void generate_incompressible(unsigned char data[], size_t size,
+                                    uint64_t *state);
+
+
+/* ============================================================================
+ * Globale Variablen
+ * ========================================================================= */
+
+/** Arten der synthetischen Testdaten */
+static const CORPUS_KIND kinds[] =
+{
+    {"random", generate_random},
+    {"skewed", generate_skewed},
+    {"text", generate_text},
+    {"runs", generate_runs},
+    {"incompressible", generate_incompressible}
+};
+
+/** Anzahl der Arten */
+#define KIND_COUNT ((int) (sizeof (kinds) / sizeof (kinds[0])))
+
+/** zu messende Level */
+static long levels[MAX_LEVELS] = {1, 2, 3, 4, 5, 6, 7};
+
+/** Anzahl der zu messenden Level */
+static int level_count = MAX_LEVELS;
+
+/** Größen der synthetischen Testdaten in KiB */
+static long sizes_kib[MAX_SIZES] = {64, 1024, 16384};
+
+/** Anzahl der Größen */
+static int size_count = 3;
+
+/** Anzahl der Wiederholungen je Messung */
+static int repeats = STD_REPEATS;
+
+/** Anzahl der Threads, 0 für die Standardeinstellung */
+static int threads = 0;
+
+/** Verzeichnis für Testdaten und Zwischenergebnisse */
+static const char *data_dir = STD_DATA_DIR;
+
+/** Datei für die Ausgabe im CSV-Format, NULL wenn keine */
+static const char *csv_filename = NULL;
+
+/** Datei für die Ausgabe im JSON-Format, NULL wenn keine */
+static const char *json_filename = NULL;
+
+/** weitere zu messende Dateien von der Kommandozeile */
+static char **extra_files = NULL;
+
+/** Anzahl der weiteren Dateien */
+static int extra_count = 0;
+
+/** zu messende Dateien */
+static CORPUS corpora[MAX_CORPORA];
+
+/** Anzahl der zu messenden Dateien */
+static int corpus_count = 0;
+
+/** Ergebnisse aller Messungen */
+static RESULT results[MAX_CORPORA * MAX_LEVELS];
+
+/** Anzahl der Ergebnisse */
+static int result_count = 0;
+
+
+/* ============================================================================
+ * Funktionsdefinitionen
+ * ========================================================================= */
+
+/**
+ * Hauptfunktion des Benchmarks
+ *
+ * @param argc  Anzahl der Argumente
+ * @param argv  Argumente
+ * @return      EXIT_SUCCESS, wenn alle Dateien fehlerfrei verarbeitet wurden
+ */
+int main(int argc, char **argv)
+{
+    bool all_ok = true;
+    int c;
+    int l;
+
+    if (!read_arguments(argc, argv))
+    {
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_OPTION);
+        fprintf(stderr, "Usage: bench [-l<levels>] [-s<sizes in KiB>] "
+                "[-r<repeats>] [-t<threads>]\n"
+                "             [-d <dir>] [-csv <file>] [-json <file>] "
+                "[file...]\n"
+                "  levels and sizes as list, e.g. -l1,3,5 or -l1-7\n");
+        return EXIT_OPTION_ERROR;
+    }
+
+    prepare_corpora();
+
+    for (c = 0; c < corpus_count; c++)
+    {
+        corpora[c].histogram_seconds = measure_histogram(&corpora[c]);
+        if (corpora[c].histogram_seconds < 0)
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_READ_FAILED,
+                    corpora[c].path);
+            all_ok = false;
+        }
+        for (l = 0; l < level_count; l++)
+        {
+            RESULT *result = &results[result_count++];
+
+            run_benchmark(&corpora[c], (int) levels[l], result);
+            all_ok &= result->ok;
+            fprintf(stderr, "  %-24s l%d  %s\n", corpora[c].name,
+                    (int) levels[l], result->ok ? "ok" : "FAILED");
+        }
+    }
+
+    print_table(stdout);
+    if (csv_filename != NULL)
+    {
+        FILE *csv = fopen(csv_filename, "w");
+
+        if (csv == NULL)
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_WRITE_FAILED, csv_filename);
+            return EXIT_IO_ERROR;
+        }
+        print_csv(csv);
+        fclose(csv);
+    }
+    if (json_filename != NULL)
+    {
+        FILE *json = fopen(json_filename, "w");
+
+        if (json == NULL)
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_WRITE_FAILED,
+                    json_filename);
+            return EXIT_IO_ERROR;
+        }
+        print_json(json);
+        fclose(json);
+    }
+
+    return all_ok ? EXIT_SUCCESS : EXIT_DC_ERROR;
+}
+
+static bool read_arguments(int argc, char **argv)
+{
+    int i;
+    int k;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strncmp(argv[i], "-l", 2) == 0)
+        {
+            level_count = parse_list(argv[i] + 2, levels, MAX_LEVELS);
+            for (k = 0; k < level_count; k++)
+            {
+                if (levels[k] < 1 || levels[k] > MAX_LEVELS)
+                {
+                    return false;
+                }
+            }
+            if (level_count == 0)
+            {
+                return false;
+            }
+        }
+        else if (strncmp(argv[i], "-s", 2) == 0)
+        {
+            size_count = parse_list(argv[i] + 2, sizes_kib, MAX_SIZES);
+            if (size_count == 0)
+            {
+                return false;
+            }
+        }
+        else if (strncmp(argv[i], "-r", 2) == 0)
+        {
+            repeats = atoi(argv[i] + 2);
+            if (repeats < 1)
+            {
+                return false;
+            }
+        }
+        else if (strncmp(argv[i], "-t", 2) == 0)
+        {
+            threads = atoi(argv[i] + 2);
+            if (threads < 1)
+            {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc)
+        {
+            data_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-csv") == 0 && i + 1 < argc)
+        {
+            csv_filename = argv[++i];
+        }
+        else if (strcmp(argv[i], "-json") == 0 && i + 1 < argc)
+        {
+            json_filename = argv[++i];
+        }
+        else if (argv[i][0] != '-')
+        {
+            /* Die übrigen Argumente sind weitere zu messende Dateien */
+            extra_files = argv + i;
+            extra_count = argc - i;
+            break;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int parse_list(const char *text, long values[], int max_count)
+{
+    int count = 0;
+    char *end;
+
+    while (*text != '\0')
+    {
+        long first = strtol(text, &end, 10);
+        long last = first;
+
+        if (end == text || first < 0)
+        {
+            return 0;
+        }
+        text = end;
+        if (*text == '-')
+        {
+            last = strtol(text + 1, &end, 10);
+            if (end == text + 1 || last < first)
+            {
+                return 0;
+            }
+            text = end;
+        }
+        for (; first <= last; first++)
+        {
+            if (count == max_count)
+            {
+                return 0;
+            }
+            values[count++] = first;
+        }
+        if (*text == ',')
+        {
+            text++;
+        }
+        else if (*text != '\0')
+        {
+            return 0;
+        }
+    }
+
+    return count;
+}
+
+/* ----------------------------------------------------------------------------
+ * Testdaten
+ * ------------------------------------------------------------------------- */
+
+static void prepare_corpora(void)
+{
+    char name[64];
+    char path[MAX_PATH];
+    int k;
+    int s;
+    int i;
+
+    if (mkdir(data_dir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_WRITE_FAILED, data_dir);
+        exit(EXIT_IO_ERROR);
+    }
+
+    /* Synthetische Daten nur erzeugen, wenn sie noch nicht vorhanden sind */
+    for (k = 0; k < KIND_COUNT; k++)
+    {
+        for (s = 0; s < size_count; s++)
+        {
+            size_t size = (size_t) sizes_kib[s] * 1024;
+
+            snprintf(name, sizeof (name), "%s-%ldk", kinds[k].name,
+                     sizes_kib[s]);
+            snprintf(path, sizeof (path), "%s/%s", data_dir, name);
+            if (file_size(path) != size)
+            {
+                uint64_t state = RANDOM_SEED + (uint64_t) k;
+                unsigned char *data = (unsigned char *) malloc(size > 0 ? size : 1);
+                FILE *file = fopen(path, "wb");
+
+                if (data == NULL || file == NULL)
+                {
+                    fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_WRITE_FAILED, path);
+                    exit(EXIT_IO_ERROR);
+                }
+                kinds[k].generate(data, size, &state);
+                if (fwrite(data, 1, size, file) != size)
+                {
+                    fprintf(stderr, "[ERROR]: %s: %s\n", EMSG_WRITE_FAILED, path);
+                    exit(EXIT_IO_ERROR);
+                }
+                fclose(file);
+                free(data);
+            }
+            add_corpus(name, path);
+        }
+    }
+
+    /* Testdateien des Projekts und Dateien von der Kommandozeile */
+    snprintf(path, sizeof (path), "%s/gross.txt", TESTFILES_DIR);
+    if (file_size(path) > 0)
+    {
+        add_corpus("testfiles/gross.txt", path);
+    }
+    snprintf(path, sizeof (path), "%s/in.txt", TESTFILES_DIR);
+    if (file_size(path) > 0)
+    {
+        add_corpus("testfiles/in.txt", path);
+    }
+    for (i = 0; i < extra_count; i++)
+    {
+        const char *base = strrchr(extra_files[i], '/');
+
+        add_corpus(base != NULL ? base + 1 : extra_files[i], extra_files[i]);
+    }
+}
+
+static void add_corpus(const char *name, const char *path)
+{
+    CORPUS *corpus;
+
+    if (corpus_count == MAX_CORPORA)
+    {
+        return;
+    }
+    corpus = &corpora[corpus_count++];
+    snprintf(corpus->name, sizeof (corpus->name), "%s", name);
+    snprintf(corpus->path, sizeof (corpus->path), "%s", path);
+    corpus->size = file_size(path);
+}
+
+static uint64_t next_random(uint64_t *state)
+{
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+
+    return *state * 0x2545F4914F6CDD1Dull;
+}
+
+static void generate_random(unsigned char data[], size_t size,
+                            uint64_t *state)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        data[i] = (unsigned char) ('0' + (next_random(state) >> 58));
+    }
+}
+
+static void generate_skewed(unsigned char data[], size_t size,
+                            uint64_t *state)
+{
+    size_t i;
+
+    /* Symbol k mit Wahrscheinlichkeit 2^-(k+1): Anzahl der 0-Bits vor
+     * dem ersten 1-Bit einer Zufallszahl */
+    for (i = 0; i < size; i++)
+    {
+        uint64_t r = next_random(state) | ((uint64_t) 1 << 40);
+        int k = 0;
+
+        while ((r & 1) == 0)
+        {
+            r >>= 1;
+            k++;
+        }
+        data[i] = (unsigned char) ('a' + k);
+    }
+}
+
+static void generate_text(unsigned char data[], size_t size, uint64_t *state)
+{
+    static const char letters[] = "etaoinshrdlucmfwypvbgkqjxz";
+    char words[VOCABULARY_SIZE][16];
+    size_t pos = 0;
+    int column = 0;
+    int w;
+
+    for (w = 0; w < VOCABULARY_SIZE; w++)
+    {
+        int len = 2 + (int) (next_random(state) % 9);
+        int c;
+
+        /* häufige Buchstaben häufiger wählen */
+        for (c = 0; c < len; c++)
+        {
+            uint64_t r = next_random(state);
+
+            words[w][c] = letters[(r % 26) * ((r >> 32) % 26) / 26];
+        }
+        words[w][len] = '\0';
+    }
+
+    while (pos < size)
+    {
+        /* Zipf-ähnlich: kleine Indizes sind deutlich häufiger */
+        uint64_t r = next_random(state);
+        int index = (int) ((r % VOCABULARY_SIZE)
+                           * ((r >> 32) % VOCABULARY_SIZE) / VOCABULARY_SIZE);
+        const char *word = words[index];
+
+        while (*word != '\0' && pos < size)
+        {
+            data[pos++] = (unsigned char) *word++;
+            column++;
+        }
+        if (pos < size)
+        {
+            data[pos++] = (unsigned char) ((column > 70) ? '\n' : ' ');
+            column = (column > 70) ? 0 : column + 1;
+        }
+    }
+}
+
+static void generate_runs(unsigned char data[], size_t size, uint64_t *state)
+{
+    size_t pos = 0;
+
+    while (pos < size)
+    {
+        uint64_t r = next_random(state);
+        size_t len = 1 + (size_t) (r % 64);
+        unsigned char c = (unsigned char) (r >> 56);
+
+        for (; len > 0 && pos < size; len--)
+        {
+            data[pos++] = c;
+        }
+    }
+}
+
+static void generate_incompressible(unsigned char data[], size_t size,
+                                    uint64_t *state)
+{
+    size_t i = 0;
+
+    while (i < size)
+    {
+        uint64_t r = next_random(state);
+        int b;
+
+        for (b = 0; b < 8 && i < size; b++, i++)
+        {
+            data[i] = (unsigned char) (r >> (8 * b));
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Messung
+ * ------------------------------------------------------------------------- */
+
+static double measure_histogram(const CORPUS *corpus)
+{
+    uint64_t freq[HISTOGRAM_SYMBOLS];
+    size_t size = (size_t) corpus->size;
+    unsigned char *data = (unsigned char *) malloc(size > 0 ? size : 1);
+    FILE *file = fopen(corpus->path, "rb");
+    double best = -1;
+    int r;
+
+    if (data != NULL && file != NULL
+            && fread(data, 1, size, file) == size)
+    {
+        for (r = 0; r < repeats; r++)
+        {
+            struct timespec start;
+            struct timespec end;
+            double seconds;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            histogram_count(data, size, freq);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            seconds = (double) (end.tv_sec - start.tv_sec)
+                    + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+            if (best < 0 || seconds < best)
+            {
+                best = seconds;
+            }
+        }
+    }
+    if (file != NULL)
+    {
+        fclose(file);
+    }
+    free(data);
+
+    return best;
+}
+
+static void run_benchmark(const CORPUS *corpus, int level, RESULT *result)
+{
+    HUFFMAN_OPTIONS options;
+    char in_filename[MAX_PATH];
+    char hc_filename[MAX_PATH];
+    char hd_filename[MAX_PATH + 4];
+    char name[sizeof (corpus->name)];
+    char *c;
+
+    init_options(&options);
+    options.level = level;
+    if (threads > 0)
+    {
+        options.threads = threads;
+    }
+
+    snprintf(in_filename, sizeof (in_filename), "%s", corpus->path);
+    /* Verzeichnisse im Namen der Datei nicht nachbilden */
+    snprintf(name, sizeof (name), "%s", corpus->name);
+    for (c = name; *c != '\0'; c++)
+    {
+        *c = (*c == '/') ? '_' : *c;
+    }
+    snprintf(hc_filename, sizeof (hc_filename), "%s/%s.l%d.hc", data_dir,
+             name, level);
+    snprintf(hd_filename, sizeof (hd_filename), "%s.hd", hc_filename);
+
+    result->corpus = corpus;
+    result->level = level;
+    measure(true, in_filename, hc_filename, &options, &result->compress);
+    measure(false, hc_filename, hd_filename, &options, &result->decompress);
+    result->compressed_size = file_size(hc_filename);
+    result->ok = result->compress.seconds >= 0
+            && result->decompress.seconds >= 0
+            && files_equal(in_filename, hd_filename);
+
+    remove(hc_filename);
+    remove(hd_filename);
+}
+
+static void measure(bool compress, char in_filename[], char out_filename[],
+                    const HUFFMAN_OPTIONS *options, MEASUREMENT *measurement)
+{
+    struct rusage usage;
+    int channel[2];
+    int status;
+    pid_t pid;
+
+    measurement->seconds = -1;
+    measurement->peak_rss_kib = 0;
+
+    /*
+     * Die Messung läuft in einem Kindprozess: Sein maximaler Speicherbedarf
+     * ist unabhängig von den vorherigen Messungen, und ein Abbruch des
+     * Programms bei einem Fehler beendet nur die Messung. Die Laufzeit
+     * misst das Kind selbst und schickt sie über eine Pipe.
+     */
+    fflush(stdout);
+    fflush(stderr);
+    if (pipe(channel) != 0 || (pid = fork()) < 0)
+    {
+        fprintf(stderr, "[ERROR]: %s\n", EMSG_FORK_FAILED);
+        exit(EXIT_FAILURE);
+    }
+    if (pid == 0)
+    {
+        double best = -1;
+        int r;
+
+        close(channel[0]);
+        for (r = 0; r < repeats; r++)
+        {
+            struct timespec start;
+            struct timespec end;
+            double seconds;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            if (compress)
+            {
+                compress_with_options(in_filename, out_filename, options);
+            }
+            else
+            {
+                decompress_with_options(in_filename, out_filename, options);
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            seconds = (double) (end.tv_sec - start.tv_sec)
+                    + (double) (end.tv_nsec - start.tv_nsec) / 1e9;
+            if (best < 0 || seconds < best)
+            {
+                best = seconds;
+            }
+        }
+        if (write(channel[1], &best, sizeof (best)) != sizeof (best))
+        {
+            _exit(EXIT_FAILURE);
+        }
+        _exit(EXIT_SUCCESS);
+    }
+
+    close(channel[1]);
+    if (read(channel[0], &measurement->seconds, sizeof (measurement->seconds))
+            != sizeof (measurement->seconds))
+    {
+        measurement->seconds = -1;
+    }
+    close(channel[0]);
+    if (wait4(pid, &status, 0, &usage) == pid)
+    {
+        measurement->peak_rss_kib = usage.ru_maxrss;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS)
+        {
+            measurement->seconds = -1;
+        }
+    }
+}
+
+static bool files_equal(const char *a, const char *b)
+{
+    FILE *fa = fopen(a, "rb");
+    FILE *fb = fopen(b, "rb");
+    bool equal = fa != NULL && fb != NULL;
+
+    while (equal)
+    {
+        unsigned char buffer_a[65536];
+        unsigned char buffer_b[65536];
+        size_t na = fread(buffer_a, 1, sizeof (buffer_a), fa);
+        size_t nb = fread(buffer_b, 1, sizeof (buffer_b), fb);
+
+        equal = na == nb && memcmp(buffer_a, buffer_b, na) == 0;
+        if (na == 0)
+        {
+            break;
+        }
+    }
+    if (fa != NULL)
+    {
+        fclose(fa);
+    }
+    if (fb != NULL)
+    {
+        fclose(fb);
+    }
+
+    return equal;
+}
+
+static uint64_t file_size(const char *path)
+{
+    struct stat attribut;
+
+    return (stat(path, &attribut) == 0) ? (uint64_t) attribut.st_size : 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Ausgabe
+ * ------------------------------------------------------------------------- */
+
+static double megabytes_per_second(uint64_t size, double seconds)
+{
+    return (seconds > 0) ? (double) size / 1e6 / seconds : 0;
+}
+
+static void print_table(FILE *out)
+{
+    int i;
+
+    fprintf(out, "\nhistogram kernel: %s\n", histogram_kernel_name());
+    fprintf(out, "%-24s %5s %12s %12s %7s %10s %10s %10s %9s %9s %s\n",
+            "corpus", "level", "size", "compressed", "ratio", "comp MB/s",
+            "dec MB/s", "hist MB/s", "comp KiB", "dec KiB", "ok");
+    for (i = 0; i < result_count; i++)
+    {
+        const RESULT *r = &results[i];
+
+        fprintf(out, "%-24s %5d %12llu %12llu %7.3f %10.1f %10.1f %10.1f "
+                "%9ld %9ld %s\n",
+                r->corpus->name, r->level,
+                (unsigned long long) r->corpus->size,
+                (unsigned long long) r->compressed_size,
+                (r->corpus->size > 0)
+                ? (double) r->compressed_size / (double) r->corpus->size : 0,
+                megabytes_per_second(r->corpus->size, r->compress.seconds),
+                megabytes_per_second(r->corpus->size, r->decompress.seconds),
+                megabytes_per_second(r->corpus->size,
+                                     r->corpus->histogram_seconds),
+                r->compress.peak_rss_kib, r->decompress.peak_rss_kib,
+                r->ok ? "yes" : "NO");
+    }
+}
+
+static void print_csv(FILE *out)
+{
+    int i;
+
+    fprintf(out, "corpus,level,size,compressed_size,ratio,compress_mb_s,"
+            "decompress_mb_s,histogram_kernel,histogram_mb_s,"
+            "compress_peak_rss_kib,decompress_peak_rss_kib,ok\n");
+    for (i = 0; i < result_count; i++)
+    {
+        const RESULT *r = &results[i];
+
+        fprintf(out, "%s,%d,%llu,%llu,%.5f,%.2f,%.2f,%s,%.2f,%ld,%ld,%d\n",
+                r->corpus->name, r->level,
+                (unsigned long long) r->corpus->size,
+                (unsigned long long) r->compressed_size,
+                (r->corpus->size > 0)
+                ? (double) r->compressed_size / (double) r->corpus->size : 0,
+                megabytes_per_second(r->corpus->size, r->compress.seconds),
+                megabytes_per_second(r->corpus->size, r->decompress.seconds),
+                histogram_kernel_name(),
+                megabytes_per_second(r->corpus->size,
+                                     r->corpus->histogram_seconds),
+                r->compress.peak_rss_kib, r->decompress.peak_rss_kib,
+                r->ok ? 1 : 0);
+    }
+}
+
+static void print_json(FILE *out)
+{
+    int i;
+
+    fprintf(out, "[\n");
+    for (i = 0; i < result_count; i++)
+    {
+        const RESULT *r = &results[i];
+
+        fprintf(out, "  {\"corpus\": \"%s\", \"level\": %d, \"size\": %llu, "
+                "\"compressed_size\": %llu, \"ratio\": %.5f, "
+                "\"compress_mb_s\": %.2f, \"decompress_mb_s\": %.2f, "
+                "\"histogram_kernel\": \"%s\", \"histogram_mb_s\": %.2f, "
+                "\"compress_peak_rss_kib\": %ld, "
+                "\"decompress_peak_rss_kib\": %ld, \"ok\": %s}%s\n",
+                r->corpus->name, r->level,
+                (unsigned long long) r->corpus->size,
+                (unsigned long long) r->compressed_size,
+                (r->corpus->size > 0)
+                ? (double) r->compressed_size / (double) r->corpus->size : 0,
+                megabytes_per_second(r->corpus->size, r->compress.seconds),
+                megabytes_per_second(r->corpus->size, r->decompress.seconds),
+                histogram_kernel_name(),
+                megabytes_per_second(r->corpus->size,
+                                     r->corpus->histogram_seconds),
+                r->compress.peak_rss_kib, r->decompress.peak_rss_kib,
+                r->ok ? "true" : "false", (i + 1 < result_count) ? "," : "");
+    }
+    fprintf(out, "]\n");
+}
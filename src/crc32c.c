@@ -0,0 +1,219 @@
+/**
+ * @file
+ * In diesem Modul wird die Prüfsumme CRC32C berechnet.
+ *
+ * Die Tabellenvariante verarbeitet acht Bytes je Schritt (slicing-by-8):
+ * Tabelle k enthält den Rest eines Bytes, dem k Nullbytes folgen. Die
+ * Tabellen werden beim ersten Aufruf einmalig berechnet. Der Befehl crc32
+ * aus SSE4.2 rechnet mit demselben Polynom und ersetzt die Tabellen.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <string.h>
+#include <pthread.h>
+
+#include "huffman_common.h"
+#include "crc32c.h"
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(S_SPLINT_S)
+#include <nmmintrin.h>
+#define CRC32C_X86
+#endif
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Castagnoli-Polynom in bitweise umgekehrter Darstellung */
+#define CRC32C_POLY 0x82F63B78u
+
+/** Anzahl der Tabellen der Tabellenvariante */
+#define CRC32C_TABLES 8
+
+
+/* ============================================================================
+ * Globale Variablen
+ * ========================================================================= */
+
+/** Tabellen der Tabellenvariante */
+static uint32_t crc_table[CRC32C_TABLES][256];
+
+/** Sorgt dafür, dass die Tabellen genau einmal berechnet werden */
+static pthread_once_t crc_table_once = PTHREAD_ONCE_INIT;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Berechnet die Tabellen der Tabellenvariante.
+ */
+static void build_tables(void);
+
+/**
+ * Setzt eine Prüfsumme mit Hilfe der Tabellen fort. Die Invertierung zu
+ * Beginn und am Ende übernimmt der Aufrufer.
+ *
+ * @param crc       invertierte Prüfsumme der vorangehenden Bytes
+ * @param data      weitere Bytes
+ * @param size      Anzahl der Bytes
+ * @return          invertierte Prüfsumme aller Bytes
+ */
+static uint32_t update_table(uint32_t crc, const unsigned char data[],
+                             size_t size);
+
+#ifdef CRC32C_X86
+/**
+ * Setzt eine Prüfsumme mit dem Befehl crc32 aus SSE4.2 fort. Die
+ * Invertierung zu Beginn und am Ende übernimmt der Aufrufer.
+ *
+ * @param crc       invertierte Prüfsumme der vorangehenden Bytes
+ * @param data      weitere Bytes
+ * @param size      Anzahl der Bytes
+ * @return          invertierte Prüfsumme aller Bytes
+ */
+static uint32_t update_sse42(uint32_t crc, const unsigned char data[],
+                             size_t size);
+
+/**
+ * Prüft, ob der Prozessor SSE4.2 unterstützt.
+ *
+ * @return  true, wenn der Befehl crc32 verwendet werden kann
+ */
+static bool has_sse42(void);
+#endif
+
+
+/* ============================================================================
+ * Funktionsdefinitionen
+ * ========================================================================= */
+
+extern uint32_t crc32c_update(uint32_t crc, const unsigned char data[],
+                              size_t size)
+{
+#ifdef CRC32C_X86
+    if (has_sse42())
+    {
+        return ~update_sse42(~crc, data, size);
+    }
+#endif
+    pthread_once(&crc_table_once, build_tables);
+
+    return ~update_table(~crc, data, size);
+}
+
+extern const char *crc32c_kernel_name(void)
+{
+#ifdef CRC32C_X86
+    if (has_sse42())
+    {
+        return "sse4.2";
+    }
+#endif
+    return "table";
+}
+
+/* ----------------------------------------------------------------------------
+ * Tabellenvariante
+ * ------------------------------------------------------------------------- */
+
+static void build_tables(void)
+{
+    uint32_t crc;
+    int table;
+    int i;
+    int bit;
+
+    for (i = 0; i < 256; i++)
+    {
+        crc = (uint32_t) i;
+        for (bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+        }
+        crc_table[0][i] = crc;
+    }
+    for (i = 0; i < 256; i++)
+    {
+        crc = crc_table[0][i];
+        for (table = 1; table < CRC32C_TABLES; table++)
+        {
+            crc = (crc >> 8) ^ crc_table[0][crc & 0xFF];
+            crc_table[table][i] = crc;
+        }
+    }
+}
+
+static uint32_t update_table(uint32_t crc, const unsigned char data[],
+                             size_t size)
+{
+    size_t i = 0;
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+    && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    for (; i + 8 <= size; i += 8)
+    {
+        uint32_t low;
+        uint32_t high;
+
+        memcpy(&low, data + i, sizeof(low));
+        memcpy(&high, data + i + 4, sizeof(high));
+        low ^= crc;
+        crc = crc_table[7][low & 0xFF]
+                ^ crc_table[6][(low >> 8) & 0xFF]
+                ^ crc_table[5][(low >> 16) & 0xFF]
+                ^ crc_table[4][low >> 24]
+                ^ crc_table[3][high & 0xFF]
+                ^ crc_table[2][(high >> 8) & 0xFF]
+                ^ crc_table[1][(high >> 16) & 0xFF]
+                ^ crc_table[0][high >> 24];
+    }
+#endif
+    for (; i < size; i++)
+    {
+        crc = (crc >> 8) ^ crc_table[0][(crc ^ data[i]) & 0xFF];
+    }
+
+    return crc;
+}
+
+/* ----------------------------------------------------------------------------
+ * SSE4.2
+ * ------------------------------------------------------------------------- */
+
+#ifdef CRC32C_X86
+__attribute__((target("sse4.2")))
+static uint32_t update_sse42(uint32_t crc, const unsigned char data[],
+                             size_t size)
+{
+    uint64_t crc64 = crc;
+    uint64_t word;
+    size_t i = 0;
+
+    for (; i + 8 <= size; i += 8)
+    {
+        memcpy(&word, data + i, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+    }
+    crc = (uint32_t) crc64;
+    for (; i < size; i++)
+    {
+        crc = _mm_crc32_u8(crc, data[i]);
+    }
+
+    return crc;
+}
+
+static bool has_sse42(void)
+{
+    return __builtin_cpu_supports("sse4.2") != 0;
+}
+#endif
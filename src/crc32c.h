@@ -0,0 +1,50 @@
+/**
+ * @file
+ * In diesem Modul wird die Prüfsumme CRC32C (Castagnoli-Polynom) über einen
+ * Puffer berechnet. Sofern vorhanden, wird der Befehl crc32 aus SSE4.2
+ * genutzt, sonst eine Tabelle mit acht Bytes je Schritt.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef CRC32C_H
+#define CRC32C_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stddef.h>
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Setzt eine Prüfsumme mit weiteren Bytes fort. Die Prüfsumme eines leeren
+ * Puffers ist 0, so dass crc32c_update(0, data, size) die Prüfsumme von
+ * data liefert.
+ *
+ * @param crc       Prüfsumme der vorangehenden Bytes
+ * @param data      weitere Bytes
+ * @param size      Anzahl der Bytes
+ * @return          Prüfsumme aller Bytes
+ */
+extern uint32_t crc32c_update(uint32_t crc, const unsigned char data[],
+                              size_t size);
+
+/**
+ * Liefert den Namen der Variante, mit der crc32c_update auf diesem
+ * Prozessor rechnet ("sse4.2" oder "table").
+ *
+ * @return  Name der Variante
+ */
+extern const char *crc32c_kernel_name(void);
+
+/* ------------------------------------------------------------------------- */
+#endif /* CRC32C_H */
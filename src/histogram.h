@@ -0,0 +1,59 @@
+/**
+ * @file
+ * In diesem Modul wird die Häufigkeit der Bytewerte in einem Puffer
+ * gezählt. Die Zählung verteilt aufeinanderfolgende Bytes auf mehrere
+ * Zähltabellen und zählt Abschnitte aus lauter gleichen Bytes auf einmal.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef HISTOGRAM_H
+#define HISTOGRAM_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stddef.h>
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/**
+ * Anzahl der unterschiedlichen Bytewerte
+ */
+#define HISTOGRAM_SYMBOLS 256
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Zählt, wie oft jeder Bytewert im Puffer vorkommt. Die bisherigen Werte in
+ * freq werden überschrieben.
+ *
+ * @param data      zu zählende Bytes
+ * @param size      Anzahl der Bytes
+ * @param freq      Häufigkeit je Bytewert (Ausgabe)
+ */
+extern void histogram_count(const unsigned char data[], size_t size,
+                            uint64_t freq[HISTOGRAM_SYMBOLS]);
+
+/**
+ * Liefert den Namen des Zählverfahrens von histogram_count. Er wird mit
+ * den Messwerten ausgegeben, damit Messungen verschiedener Stände
+ * vergleichbar bleiben.
+ *
+ * @return  Name der Variante
+ */
+extern const char *histogram_kernel_name(void);
+
+/* ------------------------------------------------------------------------- */
+#endif /* HISTOGRAM_H */
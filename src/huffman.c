@@ -2,70 +2,5344 @@
  * Includes
  * ========================================================================= */
 
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <setjmp.h>
+#include <time.h>
+
 #include "huffman_common.h"
 #include "io.h"
+#include "histogram.h"
+#include "crc32c.h"
+#include "tans.h"
+#include "lz77.h"
+#include "pool.h"
+#include "trap.h"
 #include "huffman.h"
 
 
 /* ============================================================================
- * Funktions-Prototypen
+ * Symbolische Konstanten
  * ========================================================================= */
 
+/** Anzahl der unterschiedlichen Symbole (alle Werte eines Bytes) */
+#define SYMBOL_COUNT 256
+
+/** Maximale Länge eines Codeworts in Bit */
+#define MAX_CODE_LEN 20
+
+/** Anzahl der Bits, mit denen die Primärtabelle des Dekodierers indiziert wird */
+#define DECODE_TABLE_BITS 11
+
+/** Kennung am Anfang einer komprimierten Datei */
+#define FILE_MAGIC "HC"
+
+/** Länge der Kennung */
+#define FILE_MAGIC_LEN 2
+
+/** Version des Dateiformats */
+#define FORMAT_VERSION 3
+
+/** Länge eines Blockkopfs (unkomprimierte und komprimierte Länge) */
+#define BLOCK_HEADER_LEN 8
+
+/** Blockinhalt: Codetabelle und ein Bitstrom */
+#define BLOCK_HUFFMAN 0
+
+/** Blockinhalt: Codetabelle, Sprungtabelle und STREAM_COUNT Bitströme */
+#define BLOCK_HUFFMAN_X4 1
+
+/** Anzahl der verschränkten Bitströme eines Blocks */
+#define STREAM_COUNT 4
+
+/** Länge der Sprungtabelle: Länge aller Bitströme außer dem letzten */
+#define JUMP_TABLE_LEN (4 * (STREAM_COUNT - 1))
+
+/** Blockinhalt: mit tANS kodierte Zeichen (siehe tans.h) */
+#define BLOCK_TANS 2
+
+/**
+ * Blockinhalt: Zuordnung der Kontexte (vorheriges Zeichen) zu Codetabellen,
+ * die Codetabellen und ein Bitstrom
+ */
+#define BLOCK_CONTEXT 3
+
+/** Maximale Anzahl der Codetabellen im Kontextmodell */
+#define MAX_CONTEXT_TABLES 8
+
+/** Länge der Zuordnung der Kontexte zu Codetabellen (4 Bit je Kontext) */
+#define CONTEXT_MAP_LEN (SYMBOL_COUNT / 2)
+
+/** Anzahl der Durchläufe beim Zusammenfassen der Kontexte */
+#define CLUSTER_ROUNDS 4
+
+/** Kontextmodell erst für Blöcke ab dieser Größe prüfen */
+#define MIN_CONTEXT_SIZE 4096
+
+/**
+ * Blockinhalt: Anzahl der Literale und Sequenzen, die Literale als
+ * eingebetteter Blockinhalt, die Codetabellen der Literallängen,
+ * Wiederholungslängen und Abstände und ein Bitstrom mit den Sequenzen
+ */
+#define BLOCK_LZ77 4
+
+/**
+ * Anzahl der Codes für Längen und Abstände: je Zweierpotenz vier Codes,
+ * gefolgt von Zusatzbits (siehe lz77_value_code)
+ */
+#define LZ77_CODE_COUNT 124
+
+/** LZ77-Zerlegung erst für Blöcke ab dieser Größe prüfen */
+#define MIN_LZ77_SIZE 64
+
+/** Blockinhalt: die unveränderten Zeichen */
+#define BLOCK_STORED 5
+
+/**
+ * Ein Block gilt als nicht komprimierbar, wenn die Entropie seiner Zeichen
+ * weniger als 1/STORED_MIN_SAVING unter 8 Bit je Zeichen liegt
+ */
+#define STORED_MIN_SAVING 64
+
+/**
+ * Anteil eines nicht komprimierbaren Blocks, der sich mindestens
+ * wiederholen muss, damit er mit LZ77-Zerlegung kodiert wird
+ */
+#define MIN_REPEAT_SHARE (1.0 / 16)
+
+/**
+ * Blockinhalt: Prüfsumme CRC32C der unkomprimierten Zeichen, gefolgt vom
+ * eigentlichen Blockinhalt
+ */
+#define BLOCK_CHECKED 6
+
+/** Länge der Kennung und Prüfsumme vor einem geprüften Blockinhalt */
+#define CHECKSUM_LEN 5
+
+/**
+ * Blockinhalt: Kennung eines Wörterbuchs, gefolgt von den mit dessen
+ * Codetabelle kodierten Zeichen (ab MIN_INTERLEAVED_SIZE Zeichen wie bei
+ * BLOCK_HUFFMAN_X4 in STREAM_COUNT Bitströmen)
+ */
+#define BLOCK_DICTIONARY 7
+
+/** Länge der Art und Kennung vor den Bitströmen eines Wörterbuchblocks */
+#define DICTIONARY_REF_LEN 5
+
+/** Kennung am Anfang einer Wörterbuchdatei */
+#define DICTIONARY_MAGIC "HCD"
+
+/** Länge der Kennung einer Wörterbuchdatei */
+#define DICTIONARY_MAGIC_LEN 3
+
+/** Version des Formats der Wörterbuchdatei */
+#define DICTIONARY_VERSION 2
+
+/** Maximale Anzahl gleichzeitig geladener Wörterbücher */
+#define MAX_DICTIONARIES 16
+
+/**
+ * Codetabelle aus Paaren von Symbol und Länge: höchstens so viele Paare,
+ * das erste Zeichen der Tabelle ist ihre Anzahl minus 1
+ */
+#define MAX_SPARSE_SYMBOLS 128
+
+/** Codetabelle: lauflängenkodierte Codelängen mit einem Hilfscode */
+#define TABLE_RLE 0xFF
+
+/** Codetabelle: dieselbe Tabelle wie im vorherigen Block */
+#define TABLE_REUSE 0xFE
+
+/**
+ * Maximale Länge einer geschriebenen Codetabelle; lauflängenkodiert
+ * kostet keine Codelänge mehr als RLE_MAX_CODE_LEN Bit
+ */
+#define MAX_TABLE_LEN (1 + 2 * MAX_SPARSE_SYMBOLS)
+
+/** Anfang eines Blockinhalts, der seine Codetabelle sicher enthält */
+#define TABLE_PREFIX_LEN (CHECKSUM_LEN + 1 + MAX_TABLE_LEN)
+
+/** Lauflänge: vorherige Codelänge 3- bis 6-mal wiederholen (2 Zusatzbits) */
+#define RLE_REPEAT (MAX_CODE_LEN + 1)
+
+/** Lauflänge: 3 bis 10 nicht vorkommende Symbole (3 Zusatzbits) */
+#define RLE_ZEROS (MAX_CODE_LEN + 2)
+
+/** Lauflänge: 11 bis 138 nicht vorkommende Symbole (7 Zusatzbits) */
+#define RLE_LONG_ZEROS (MAX_CODE_LEN + 3)
+
+/** Anzahl der Symbole des Hilfscodes: Codelängen 0 bis MAX_CODE_LEN, Läufe */
+#define RLE_SYMBOL_COUNT (MAX_CODE_LEN + 4)
+
+/** Maximale Länge eines Codeworts des Hilfscodes */
+#define RLE_MAX_CODE_LEN 7
+
+/** Anzahl der Bits, mit denen eine Codelänge des Hilfscodes gespeichert wird */
+#define RLE_LENGTH_BITS 3
+
+/** Blöcke ab dieser Größe werden in STREAM_COUNT Bitströme aufgeteilt */
+#define MIN_INTERLEAVED_SIZE 256
+
+/** Kennung am Ende einer komprimierten Datei hinter dem Blockverzeichnis */
+#define INDEX_MAGIC "HCIX"
+
+/** Länge der Kennung des Blockverzeichnisses */
+#define INDEX_MAGIC_LEN 4
+
+/** Länge eines Eintrags im Blockverzeichnis */
+#define INDEX_ENTRY_LEN 16
+
+/** Länge des Dateiendes: Position des Blockverzeichnisses und Kennung */
+#define TRAILER_LEN (8 + INDEX_MAGIC_LEN)
+
+/** Anzahl der Aufträge je Thread, die gleichzeitig in Bearbeitung sind */
+#define JOBS_PER_THREAD 2
+
+/** Maximale Anzahl der Halbierungen eines Blocks beim Aufteilen */
+#define MAX_SPLIT_DEPTH 3
+
+/** Maximale Anzahl der Teilblöcke, in die ein Block aufgeteilt wird */
+#define MAX_SPLIT_PARTS (1 << MAX_SPLIT_DEPTH)
+
+/** Minimale Größe eines Teilblocks beim Aufteilen */
+#define MIN_SPLIT_SIZE (16 * 1024)
+
 /**
- * Kopiert den Inhalt der Eingabedatei in die Ausgabedatei (byteweise)
+ * Kleinere Blöcke werden zu Aufträgen dieser Größe (höchstens
+ * MAX_SPLIT_PARTS Blöcke) zusammengefasst, damit sie Codetabellen teilen
  */
-static void do_copy_chars(void);
+#define MIN_JOB_SIZE (256 * 1024)
+
+/** Fehlermeldung bei unbekanntem Dateiformat */
+#define EMSG_INVALID_FILE "Die Datei wurde nicht mit diesem Programm komprimiert."
+
+/** Fehlermeldung bei fehlerhaftem Dateikopf */
+#define EMSG_INVALID_HEADER "Ungueltiger Dateikopf der komprimierten Datei."
+
+/** Fehlermeldung bei vorzeitigem Dateiende */
+#define EMSG_UNEXPECTED_EOF "Unerwartetes Ende der komprimierten Datei."
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
+/** Fehlermeldung bei ungueltigem Codewort */
+#define EMSG_INVALID_CODE "Ungueltiges Codewort in der komprimierten Datei."
+
+/** Fehlermeldung bei falscher Prüfsumme eines Blocks */
+#define EMSG_CHECKSUM "Falsche Pruefsumme in der komprimierten Datei."
+
+/** Fehlermeldung bei fehlerhafter Wörterbuchdatei */
+#define EMSG_INVALID_DICTIONARY "Ungueltige Woerterbuchdatei."
+
+/** Fehlermeldung, wenn das benötigte Wörterbuch nicht geladen ist */
+#define EMSG_MISSING_DICTIONARY "Das benoetigte Woerterbuch wurde nicht geladen."
+
+/** Fehlermeldung, wenn zu viele Wörterbücher geladen werden */
+#define EMSG_TOO_MANY_DICTIONARIES "Es sind zu viele Woerterbuecher geladen."
+
+
+/* ============================================================================
+ * Makros
+ * ========================================================================= */
 
 /**
- * Kopiert den Inhalt der Eingabedatei in die Ausgabedatei (bitweise)
+ * Aufbau eines Eintrags der Dekodiertabelle (32 Bit):
+ * Bit 0-7 erstes Symbol, Bit 8-15 zweites Symbol, Bit 16-20 Anzahl der
+ * Bits beider Codewörter, Bit 21-25 Anzahl der Bits des ersten Codeworts,
+ * Bit 26-27 Anzahl der Symbole. Ist die Anzahl der Symbole 0, enthalten
+ * Bit 0-15 den Beginn der Sekundärtabelle und Bit 16-20 die Anzahl der
+ * Bits, mit denen sie indiziert wird. Der Wert 0 kennzeichnet ein
+ * ungültiges Codewort.
  */
-static void do_copy_bits(void);
+#define ENTRY(SYM0, SYM1, BITS, FIRST_BITS, COUNT) \
+    ((uint32_t) (SYM0) | (uint32_t) (SYM1) << 8 | (uint32_t) (BITS) << 16 \
+     | (uint32_t) (FIRST_BITS) << 21 | (uint32_t) (COUNT) << 26)
+
+/** Eintrag, der auf eine Sekundärtabelle verweist */
+#define ENTRY_LINK(OFFSET, BITS) ((uint32_t) (OFFSET) | (uint32_t) (BITS) << 16)
+
+/** Erstes Symbol eines Eintrags */
+#define ENTRY_SYM0(E) ((unsigned char) (E))
+
+/** Zweites Symbol eines Eintrags */
+#define ENTRY_SYM1(E) ((unsigned char) ((E) >> 8))
+
+/** Beginn der Sekundärtabelle eines Eintrags */
+#define ENTRY_OFFSET(E) ((E) & 0xFFFF)
+
+/** Anzahl der Bits beider Codewörter bzw. der Sekundärtabelle */
+#define ENTRY_BITS(E) ((int) ((E) >> 16) & 0x1F)
+
+/** Anzahl der Bits des ersten Codeworts */
+#define ENTRY_FIRST_BITS(E) ((int) ((E) >> 21) & 0x1F)
+
+/** Anzahl der Symbole eines Eintrags */
+#define ENTRY_COUNT(E) ((int) ((E) >> 26) & 0x03)
 
 
 /* ============================================================================
- * Funktions-Definitionen
+ * Datentypen
  * ========================================================================= */
 
-extern void compress(char in_filename[], char out_filename[])
+/**
+ * Einstellungen einer Kompressionsstufe
+ */
+typedef struct
 {
-    open_infile(in_filename);
-    open_outfile(out_filename);
-    
-    do_copy_chars();
-    
-    close_infile();
-    close_outfile();
-}
+    /** Maximale Länge eines Codeworts in Bit */
+    int max_code_len;
 
-extern void decompress(char in_filename[], char out_filename[])
+    /**
+     * true: optimale längenbegrenzte Codelängen (Package-Merge),
+     * false: Häufigkeiten halbieren, bis die Codewörter passen
+     */
+    bool optimal;
+
+    /**
+     * Wie oft ein Block höchstens halbiert wird, um die Aufteilung mit der
+     * kleinsten komprimierten Länge zu suchen
+     */
+    int split_depth;
+
+    /** true: tANS verwenden, wenn der Block damit kleiner wird */
+    bool tans;
+
+    /**
+     * true: Codetabellen abhängig vom vorherigen Zeichen verwenden, wenn
+     * der Block damit kleiner wird
+     */
+    bool context;
+
+    /**
+     * Einstellungen der LZ77-Zerlegung, die verwendet wird, wenn der Block
+     * damit kleiner wird
+     */
+    LZ77_PARAMS lz77;
+
+    /**
+     * Wörterbuch, dessen Codetabelle verwendet wird, wenn der Block damit
+     * kleiner wird, NULL für keins
+     */
+    const struct DICTIONARY *dictionary;
+} LEVEL;
+
+/**
+ * Kontextmodell erster Ordnung: Das vorherige Zeichen wählt eine von
+ * table_count Codetabellen aus.
+ */
+typedef struct
 {
-    open_infile(in_filename);
-    open_outfile(out_filename);
-    
-    do_copy_bits();
-    
-    close_infile();
-    close_outfile();
-}
+    /** Anzahl der Codetabellen */
+    int table_count;
+
+    /** Codetabelle je Kontext */
+    unsigned char map[SYMBOL_COUNT];
+
+    /** Codelänge je Codetabelle und Symbol */
+    unsigned char lengths[MAX_CONTEXT_TABLES][SYMBOL_COUNT];
+} CONTEXT_MODEL;
 
-static void do_copy_chars(void)
+/**
+ * Tabelle für das Dekodieren. Die Primärtabelle wird mit den nächsten
+ * DECODE_TABLE_BITS Bits indiziert. Ein Eintrag liefert entweder ein oder
+ * zwei vollständige Symbole oder verweist für längere Codewörter auf eine
+ * Sekundärtabelle (siehe ENTRY_* Makros).
+ */
+typedef struct
 {
-    unsigned char c;
-    
-    while (has_next_char())
-    {
-        c = read_char();
-        write_char(c);
-    }
-}
+    /** Primärtabelle */
+    uint32_t primary[1 << DECODE_TABLE_BITS];
+
+    /** Sekundärtabellen für Codewörter mit mehr als DECODE_TABLE_BITS Bits */
+    uint32_t *secondary;
+} DECODE_TABLE;
 
-static void do_copy_bits(void)
+/**
+ * Geladenes Wörterbuch: eine trainierte Codetabelle für alle Symbole.
+ * Codewörter und Dekodiertabelle werden beim Laden einmal berechnet und
+ * danach von allen Threads nur gelesen.
+ */
+typedef struct DICTIONARY
 {
-    int bit;
-    
-    while (has_next_bit())
-    {
-        bit = read_bit();    
-        write_bit(bit);
-    }
+    /** Kennung, mit der Blöcke auf das Wörterbuch verweisen */
+    uint32_t id;
+
+    /** Codelänge je Symbol */
+    unsigned char lengths[SYMBOL_COUNT];
+
+    /** Codewort je Symbol */
+    uint32_t codes[SYMBOL_COUNT];
+
+    /** Dekodiertabelle */
+    DECODE_TABLE table;
+} DICTIONARY;
+
+/**
+ * Codetabelle des zuletzt kodierten bzw. dekodierten Blocks, auf die der
+ * folgende Block mit TABLE_REUSE verweisen kann
+ */
+typedef struct
+{
+    /** true: der Block hatte eine Codetabelle für BLOCK_HUFFMAN(_X4) */
+    bool valid;
+
+    /** Codelänge je Symbol */
+    unsigned char lengths[SYMBOL_COUNT];
+} TABLE_HISTORY;
+
+/**
+ * Lauflängenkodierte Codelängen einer Codetabelle. Die Symbole der
+ * Lauflängenkodierung werden mit einem kleinen Huffman-Code, dem Hilfscode,
+ * geschrieben.
+ */
+typedef struct
+{
+    /** Letztes vorkommendes Symbol; kodiert werden die Längen 0 bis last */
+    int last;
+
+    /** Anzahl der Symbole der Lauflängenkodierung */
+    int count;
+
+    /** Symbole der Lauflängenkodierung, kleiner als RLE_SYMBOL_COUNT */
+    unsigned char symbols[SYMBOL_COUNT];
+
+    /** Wert der Zusatzbits je Symbol */
+    unsigned char extra[SYMBOL_COUNT];
+
+    /** Codelänge je Symbol des Hilfscodes */
+    unsigned char lengths[SYMBOL_COUNT];
+
+    /** Länge der geschriebenen Codetabelle in Byte */
+    size_t size;
+} RLE_TABLE;
+
+/**
+ * Bitweises Lesen einer lauflängenkodierten Codetabelle. Es wird nur
+ * zeichenweise nachgeladen, so dass nichts hinter der Tabelle verbraucht
+ * wird.
+ */
+typedef struct
+{
+    /** Eingabestrom */
+    READER *in;
+
+    /** Gelesene, noch nicht verbrauchte Bits in den count niederwertigsten */
+    uint32_t bits;
+
+    /** Anzahl der noch nicht verbrauchten Bits */
+    int count;
+} TABLE_READER;
+
+/**
+ * Bitstrom im Speicher, aus dem der Dekodierer liest. Die Bits stehen
+ * linksbündig im Akkumulator, hinter dem Ende werden 0-Bits ergänzt.
+ */
+typedef struct
+{
+    /** nächstes zu ladendes Zeichen */
+    const unsigned char *next;
+
+    /** Ende des Bitstroms */
+    const unsigned char *end;
+
+    /** gepufferte Bits, das nächste Bit ist das höchstwertige */
+    uint64_t bits;
+
+    /** Anzahl der gültigen Bits, negativ nach Lesen über das Ende hinaus */
+    int count;
+} BIT_STREAM;
+
+/**
+ * Auftrag zum Komprimieren eines Blocks der Eingabedatei
+ */
+typedef struct
+{
+    /** Verwaltung des Auftrags im Thread-Pool */
+    POOL_JOB job;
+
+    /**
+     * Unkomprimierte Daten des Blocks: ein Ausschnitt der eingeblendeten
+     * Eingabedatei oder buffer
+     */
+    const unsigned char *input;
+
+    /** Puffer für die Daten des Blocks, wenn die Eingabe gepuffert wird */
+    unsigned char *buffer;
+
+    /** Anzahl der unkomprimierten Zeichen */
+    size_t input_size;
+
+    /**
+     * Größe der Blöcke, in die der Auftrag fest geteilt wird, wenn er
+     * mehrere kleine Blöcke zusammenfasst; 0: Aufteilung mit plan_parts
+     */
+    size_t block_size;
+
+    /** Komprimierte Daten des Blocks (ohne Blockkopf) */
+    unsigned char *output;
+
+    /** Anzahl der komprimierten Zeichen */
+    size_t output_size;
+
+    /** Kompressionsstufe, ggf. mit abweichendem Suchfenster */
+    LEVEL level;
+
+    /** Anzahl der Teilblöcke, die output nacheinander enthält */
+    int part_count;
+
+    /** Anzahl der unkomprimierten Zeichen je Teilblock */
+    uint32_t part_raw[MAX_SPLIT_PARTS];
+
+    /** Anzahl der komprimierten Zeichen je Teilblock */
+    uint32_t part_payload[MAX_SPLIT_PARTS];
+
+    /**
+     * true: der Block wird unverändert aus input geschrieben (ein Teilblock,
+     * output ist NULL)
+     */
+    bool stored;
+
+    /** true: jedem Teilblock die Prüfsumme seiner Zeichen voranstellen */
+    bool checksum;
+
+    /** Prüfsumme des gespeicherten Blocks, wenn checksum gesetzt ist */
+    uint32_t crc;
+
+    /** true: Laufzeiten der Abschnitte erfassen */
+    bool timed;
+
+    /** Laufzeit je Abschnitt beim Komprimieren des Blocks */
+    double phase_seconds[PHASE_COUNT];
+} BLOCK_JOB;
+
+/**
+ * Ring der Aufträge beim Komprimieren (siehe compress_stream). Der Ring
+ * wird der Fehlerfalle als Ganzes übergeben, damit nach einem Fehler auch
+ * die Puffer und Ergebnisse der Aufträge freigegeben werden.
+ */
+typedef struct
+{
+    /** die Aufträge */
+    BLOCK_JOB *jobs;
+
+    /** Anzahl der Aufträge */
+    size_t count;
+} BLOCK_RING;
+
+/**
+ * Eintrag des Blockverzeichnisses, das am Ende der komprimierten Datei
+ * steht
+ */
+typedef struct
+{
+    /** Position des Blockkopfs in der komprimierten Datei */
+    uint64_t offset;
+
+    /** Anzahl der unkomprimierten Zeichen */
+    uint32_t raw_size;
+
+    /** Anzahl der komprimierten Zeichen (ohne Blockkopf) */
+    uint32_t payload_size;
+
+    /**
+     * Position der unkomprimierten Zeichen in den ursprünglichen Daten
+     * (wird beim Lesen berechnet, nicht gespeichert)
+     */
+    uint64_t raw_offset;
+} INDEX_ENTRY;
+
+/**
+ * Blockverzeichnis
+ */
+typedef struct
+{
+    /** Einträge in der Reihenfolge der Blöcke */
+    INDEX_ENTRY *entries;
+
+    /** Anzahl der Einträge */
+    size_t count;
+
+    /** Anzahl der Einträge, für die Speicher reserviert ist */
+    size_t capacity;
+} BLOCK_INDEX;
+
+/**
+ * Auftrag zum Dekomprimieren eines Blocks mit bekannter Position in Ein-
+ * und Ausgabedatei
+ */
+typedef struct
+{
+    /** Verwaltung des Auftrags im Thread-Pool */
+    POOL_JOB job;
+
+    /** Eingabestrom, aus dem positionsweise gelesen wird */
+    READER *in;
+
+    /** Ausgabestrom, in den positionsweise geschrieben wird */
+    WRITER *out;
+
+    /** Eintrag des Blocks im Blockverzeichnis */
+    INDEX_ENTRY entry;
+
+    /** Blockverzeichnis, um die Codetabelle vorheriger Blöcke zu lesen */
+    const BLOCK_INDEX *index;
+
+    /** Nummer des Blocks im Blockverzeichnis */
+    size_t block;
+
+    /** Anzahl der Zeichen am Blockanfang, die nicht ausgegeben werden */
+    uint32_t skip;
+
+    /** Anzahl der auszugebenden Zeichen ab skip */
+    uint32_t keep;
+
+    /** Position der auszugebenden Zeichen in der Ausgabedatei */
+    uint64_t out_offset;
+
+    /** true: Laufzeiten der Abschnitte erfassen */
+    bool timed;
+
+    /** Laufzeit je Abschnitt beim Dekomprimieren des Blocks */
+    double phase_seconds[PHASE_COUNT];
+} DECODE_JOB;
+
+/**
+ * Auftrag zum Komprimieren oder Dekomprimieren einer ganzen Datei im
+ * Stapelbetrieb
+ */
+typedef struct
+{
+    /** Verwaltung des Auftrags im Thread-Pool */
+    POOL_JOB job;
+
+    /** Name der Eingabedatei */
+    char *in_filename;
+
+    /** Name der Ausgabedatei */
+    char *out_filename;
+
+    /** true: komprimieren, false: dekomprimieren */
+    bool compress;
+
+    /** Einstellungen mit einem Thread je Datei und eigener Statistik */
+    HUFFMAN_OPTIONS options;
+
+    /** Statistik der Datei */
+    HUFFMAN_STATS stats;
+
+    /** EXIT_*-Code der Datei */
+    int status;
+} FILE_JOB;
+
+
+/* ============================================================================
+ * Globale Variablen
+ * ========================================================================= */
+
+/**
+ * Einstellungen der Kompressionsstufen 1 bis 7. Niedrige Stufen begrenzen
+ * die Codewörter so, dass die Primärtabelle des Dekodierers (bzw. wenige
+ * kleine Sekundärtabellen) genügen, hohe Stufen berechnen optimale Codes
+ * und suchen zusätzlich die günstigste Aufteilung der Blöcke, das
+ * günstigere Kodierverfahren und zuletzt Codetabellen je Kontext. Die
+ * Suche nach Wiederholungen prüft mit jeder Stufe mehr Kandidaten in einem
+ * größeren Fenster.
+ */
+static const LEVEL levels[] =
+{
+    {DECODE_TABLE_BITS, false, 0, false, false, {1, 16, 16, false}, NULL},
+    {15, false, 0, false, false, {4, 18, 32, false}, NULL},
+    {15, true, 0, false, false, {8, 20, 64, false}, NULL},
+    {MAX_CODE_LEN, true, 0, false, false, {16, 20, 128, true}, NULL},
+    {MAX_CODE_LEN, true, 1, true, false, {32, 22, 256, true}, NULL},
+    {MAX_CODE_LEN, true, 2, true, true, {64, 22, 1024, true}, NULL},
+    {MAX_CODE_LEN, true, MAX_SPLIT_DEPTH, true, true,
+     {256, LZ77_MAX_WINDOW_LOG, 4096, true}, NULL}
+};
+
+/** Anzahl der Kompressionsstufen */
+#define LEVEL_COUNT ((int) (sizeof (levels) / sizeof (levels[0])))
+
+/**
+ * Laufzeiten je Abschnitt, zu denen der aktuelle Thread addiert, NULL wenn
+ * keine erfasst werden. Jeder Thread addiert zu eigenen Werten (die seines
+ * Auftrags), so dass keine Synchronisation nötig ist.
+ */
+static __thread double *phase_seconds = NULL;
+
+/**
+ * true, solange der aktuelle Thread einen Abschnitt misst. Abschnitte in
+ * einem gemessenen Abschnitt (z.B. der Aufbau der Codetabellen im
+ * Kontextmodell) werden dem äußeren zugerechnet.
+ */
+static __thread bool phase_active = false;
+
+/**
+ * Geladene Wörterbücher. Sie werden vor dem Komprimieren bzw.
+ * Dekomprimieren geladen und danach von allen Threads nur gelesen.
+ */
+static DICTIONARY *dictionaries[MAX_DICTIONARIES];
+
+/** Anzahl der geladenen Wörterbücher */
+static int dictionary_count = 0;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Führt einen Auftrag zum Komprimieren eines Blocks aus (im Thread-Pool).
+ *
+ * @param arg   der Auftrag (BLOCK_JOB)
+ */
+static void compress_block_task(void *arg);
+
+/**
+ * Führt einen Auftrag zum Dekomprimieren eines Blocks aus (im Thread-Pool).
+ *
+ * @param arg   der Auftrag (DECODE_JOB)
+ */
+static void decompress_block_task(void *arg);
+
+/**
+ * Führt einen Auftrag zum Komprimieren oder Dekomprimieren einer Datei aus
+ * (im Thread-Pool).
+ *
+ * @param arg   der Auftrag (FILE_JOB)
+ */
+static void file_task(void *arg);
+
+/**
+ * Komprimiert oder dekomprimiert mehrere Dateien. Der Thread-Pool
+ * bearbeitet die Dateien nebeneinander, jede Datei in einem Thread.
+ *
+ * @param in_filenames  Namen der Eingabedateien
+ * @param out_filenames Namen der Ausgabedateien
+ * @param count         Anzahl der Dateien
+ * @param options       Einstellungen
+ * @param compress      true: komprimieren, false: dekomprimieren
+ * @return              EXIT_SUCCESS oder der Code der ersten Datei, die
+ *                      nicht bearbeitet werden konnte
+ */
+static int process_batch(char *in_filenames[], char *out_filenames[],
+                         size_t count, const HUFFMAN_OPTIONS *options,
+                         bool compress);
+
+/**
+ * Komprimiert den Eingabestrom blockweise in den Ausgabestrom: Dateikopf,
+ * Blöcke, Endekennung und auf Wunsch das Blockverzeichnis.
+ *
+ * @param in            Eingabestrom
+ * @param out           Ausgabestrom
+ * @param options       Einstellungen
+ * @param with_index    true: das Blockverzeichnis anhängen
+ * @return              Anzahl der geschriebenen Bytes
+ */
+static uint64_t compress_stream(READER *in, WRITER *out,
+                                const HUFFMAN_OPTIONS *options,
+                                bool with_index);
+
+/**
+ * Dekomprimiert den Eingabestrom in den Ausgabestrom (bzw. den in options
+ * gewählten Ausschnitt). Mit Blockverzeichnis und positionsweise
+ * beschreibbarer Ausgabe werden die Blöcke parallel dekomprimiert.
+ *
+ * @param in            Eingabestrom
+ * @param out           Ausgabestrom
+ * @param options       Einstellungen
+ * @return              Anzahl der gelesenen Bytes (ohne Blockverzeichnis)
+ */
+static uint64_t decompress_stream(READER *in, WRITER *out,
+                                  const HUFFMAN_OPTIONS *options);
+
+/**
+ * Dekomprimiert Blöcke aus einem Speicherbereich direkt in den
+ * Zielbereich. Fehler im Format der Daten brechen über die Fehlerfalle ab.
+ *
+ * @param src           komprimierte Daten mit Dateikopf
+ * @param src_size      Anzahl der komprimierten Bytes
+ * @param dst           Zielbereich
+ * @param dst_capacity  Größe des Zielbereichs
+ * @param dst_size      Anzahl der dekomprimierten Bytes (Ausgabe)
+ * @return              EXIT_SUCCESS oder EXIT_DST_TOO_SMALL, wenn der
+ *                      Zielbereich zu klein ist
+ */
+static int decompress_memory(const unsigned char src[], size_t src_size,
+                             unsigned char dst[], size_t dst_capacity,
+                             size_t *dst_size);
+
+/**
+ * Dekomprimiert die Blöcke nacheinander in der Reihenfolge der Datei und
+ * gibt die Zeichen von range_start bis vor range_end aus. Blöcke vor dem
+ * Bereich werden übersprungen, ohne sie zu dekodieren; hinter dem Bereich
+ * wird nicht weitergelesen.
+ *
+ * @param in            Eingabestrom hinter dem Dateikopf
+ * @param out           Ausgabestrom
+ * @param index         Blockverzeichnis, über das direkt zum ersten
+ *                      benötigten Block gesprungen wird; leer, wenn keins
+ *                      vorhanden ist
+ * @param range_start   Position des ersten auszugebenden Zeichens
+ * @param range_end     Position hinter dem letzten auszugebenden Zeichen
+ * @param stats         Statistik, NULL wenn keine erfasst wird
+ * @return              Anzahl der gelesenen Bytes
+ */
+static uint64_t decompress_sequential(READER *in, WRITER *out,
+                                      const BLOCK_INDEX *index,
+                                      uint64_t range_start, uint64_t range_end,
+                                      HUFFMAN_STATS *stats);
+
+/**
+ * Dekomprimiert die Blöcke, die den Bereich von range_start bis vor
+ * range_end berühren, anhand des Blockverzeichnisses parallel. Jeder Block
+ * wird direkt an seine Position in der Ausgabedatei geschrieben.
+ *
+ * @param in            Eingabestrom
+ * @param out           Ausgabestrom
+ * @param index         Blockverzeichnis
+ * @param range_start   Position des ersten auszugebenden Zeichens
+ * @param range_end     Position hinter dem letzten auszugebenden Zeichen
+ * @param threads       Anzahl der Threads
+ * @param stats         Statistik, NULL wenn keine erfasst wird
+ */
+static void decompress_parallel(READER *in, WRITER *out,
+                                const BLOCK_INDEX *index,
+                                uint64_t range_start, uint64_t range_end,
+                                int threads, HUFFMAN_STATS *stats);
+
+/**
+ * Beginnt die Messung der Laufzeiten eines Auftrags im aktuellen Thread.
+ *
+ * @param seconds   Laufzeiten des Auftrags (werden auf 0 gesetzt), NULL
+ *                  wenn keine erfasst werden
+ * @param caller    bisherige Laufzeiten des Threads (Ausgabe), die
+ *                  end_task_timing wiederherstellt
+ * @return          Startzeit des Auftrags
+ */
+static double begin_task_timing(double seconds[], double **caller);
+
+/**
+ * Beendet die Messung der Laufzeiten eines Auftrags. Die nicht einem
+ * anderen Abschnitt zugerechnete Zeit gilt als Kodieren bzw. Dekodieren.
+ *
+ * @param start     Startzeit des Auftrags
+ * @param caller    wiederherzustellende Laufzeiten des Threads
+ */
+static void end_task_timing(double start, double *caller);
+
+/**
+ * Beginnt die Messung eines Abschnitts im aktuellen Thread.
+ *
+ * @return          Startzeit, negativ wenn nicht gemessen wird
+ */
+static double phase_start(void);
+
+/**
+ * Beendet die Messung eines Abschnitts und addiert seine Laufzeit.
+ *
+ * @param phase     Abschnitt
+ * @param start     Rückgabe von phase_start
+ */
+static void phase_stop(HUFFMAN_PHASE phase, double start);
+
+/**
+ * Liefert die Zeit einer monotonen Uhr.
+ *
+ * @return          Zeit in Sekunden
+ */
+static double now_seconds(void);
+
+/**
+ * Hängt einen Eintrag an das Blockverzeichnis an.
+ *
+ * @param index     Blockverzeichnis
+ * @param entry     anzuhängender Eintrag
+ */
+static void add_index_entry(BLOCK_INDEX *index, const INDEX_ENTRY *entry);
+
+/**
+ * Schreibt das Blockverzeichnis und das Dateiende.
+ *
+ * @param out       Ausgabestrom
+ * @param index     Blockverzeichnis
+ * @param offset    Position des Blockverzeichnisses in der Ausgabedatei
+ */
+static void write_index(WRITER *out, const BLOCK_INDEX *index,
+                        uint64_t offset);
+
+/**
+ * Liest das Blockverzeichnis vom Ende der Eingabedatei und prüft es auf
+ * Vollständigkeit.
+ *
+ * @param in        Eingabestrom (reguläre Datei)
+ * @param index     gelesenes Blockverzeichnis (Ausgabe)
+ * @return          false, wenn die Datei kein gültiges Blockverzeichnis
+ *                  enthält oder nicht positionsweise gelesen werden kann
+ */
+static bool read_index(READER *in, BLOCK_INDEX *index);
+
+/**
+ * Sucht den Block, der das Zeichen an einer Position der ursprünglichen
+ * Daten enthält.
+ *
+ * @param index     Blockverzeichnis
+ * @param position  Position in den ursprünglichen Daten
+ * @return          Nummer des Blocks, index->count hinter dem letzten Block
+ */
+static size_t find_block(const BLOCK_INDEX *index, uint64_t position);
+
+/**
+ * Prüft anhand der Entropie der Zeichen, ob sich das Kodieren eines Blocks
+ * voraussichtlich nicht lohnt.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @return          true, wenn der Block unverändert gespeichert werden soll
+ */
+static bool is_incompressible(const unsigned char data[], size_t size);
+
+/**
+ * Stellt einen Auftrag auf einen unverändert gespeicherten Block um.
+ *
+ * @param job       Auftrag, dessen Ergebnis verworfen wird
+ */
+static void store_block(BLOCK_JOB *job);
+
+/**
+ * Kopiert einen unverändert gespeicherten Block direkt von der Eingabe-
+ * in die Ausgabedatei.
+ *
+ * @param job       Auftrag zum Dekomprimieren des Blocks
+ * @return          false, wenn der Block nicht gespeichert ist
+ */
+static bool copy_stored_block(DECODE_JOB *job);
+
+/**
+ * Liest die Codetabelle, auf die ein Block mit TABLE_REUSE verweist: die
+ * des nächsten vorherigen Blocks, der eine eigene Codetabelle hat.
+ *
+ * @param job       Auftrag zum Dekomprimieren des verweisenden Blocks
+ * @param history   Codetabelle des vorherigen Blocks (Ausgabe)
+ */
+static void load_table_history(const DECODE_JOB *job, TABLE_HISTORY *history);
+
+/**
+ * Liefert das erste Zeichen der Codetabelle am Anfang eines Blockinhalts,
+ * das ihre Art angibt.
+ *
+ * @param payload   Blockinhalt bzw. sein Anfang
+ * @param size      Anzahl der vorhandenen Zeichen
+ * @return          erstes Zeichen der Codetabelle, z.B. TABLE_REUSE; -1,
+ *                  wenn der Blockinhalt keine Codetabelle hat
+ */
+static int block_table_kind(const unsigned char payload[], size_t size);
+
+/**
+ * Übernimmt die Codetabelle eines Blockinhalts in history, ohne den Block
+ * zu dekodieren. Verweist der Block selbst auf seinen Vorgänger, bleibt
+ * history unverändert.
+ *
+ * @param payload   Blockinhalt bzw. sein Anfang (höchstens
+ *                  TABLE_PREFIX_LEN Zeichen werden benötigt)
+ * @param size      Anzahl der vorhandenen Zeichen
+ * @param history   Codetabelle des vorherigen Blocks (wird aktualisiert)
+ */
+static void read_block_table(const unsigned char payload[], size_t size,
+                             TABLE_HISTORY *history);
+
+/**
+ * Komprimiert die Teilblöcke eines Blocks hintereinander. Ein Teilblock
+ * kann die Codetabelle seines Vorgängers übernehmen; ein Teilblock, der
+ * sich nicht komprimieren lässt, wird unverändert gespeichert.
+ *
+ * @param input         unkomprimierte Daten
+ * @param part_count    Anzahl der Teilblöcke
+ * @param part_raw      Anzahl der unkomprimierten Zeichen je Teilblock
+ * @param part_payload  Anzahl der komprimierten Zeichen je Teilblock
+ *                      (Ausgabe)
+ * @param level         Kompressionsstufe
+ * @param checksum      true: jedem Teilblock die Prüfsumme voranstellen
+ * @param size          Anzahl der komprimierten Zeichen insgesamt (Ausgabe)
+ * @return              komprimierte Daten, mit free freizugeben
+ */
+static unsigned char *encode_parts(const unsigned char input[], int part_count,
+                                   const uint32_t part_raw[],
+                                   uint32_t part_payload[], const LEVEL *level,
+                                   bool checksum, size_t *size);
+
+/**
+ * Komprimiert einen Block: mit LZ77-Zerlegung, wenn er dadurch kleiner
+ * wird, sonst zeichenweise (siehe encode_literals).
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param out       Ausgabestrom
+ * @param level     Kompressionsstufe
+ * @param history   Codetabelle des vorherigen Blocks (wird aktualisiert),
+ *                  NULL für eingebettete Blockinhalte
+ */
+static void encode_block(const unsigned char data[], size_t size,
+                         WRITER *out, const LEVEL *level,
+                         TABLE_HISTORY *history);
+
+/**
+ * Kodiert die Zeichen eines Blocks einzeln mit dem Verfahren, das die
+ * kürzeste Ausgabe verspricht: Codetabelle und kodierte Zeichen, tANS oder
+ * Kontextmodell.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param out       Ausgabestrom
+ * @param level     Kompressionsstufe
+ * @param history   Codetabelle des vorherigen Blocks (wird aktualisiert),
+ *                  NULL für eingebettete Blockinhalte
+ */
+static void encode_literals(const unsigned char data[], size_t size,
+                            WRITER *out, const LEVEL *level,
+                            TABLE_HISTORY *history);
+
+/**
+ * Teilt einen Block in Teilblöcke auf, wenn die Kompressionsstufe es
+ * vorsieht und die geschätzte komprimierte Länge dadurch sinkt.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param level     Kompressionsstufe
+ * @param part_raw  Anzahl der Zeichen je Teilblock (Ausgabe)
+ * @return          Anzahl der Teilblöcke
+ */
+static int plan_parts(const unsigned char data[], size_t size,
+                      const LEVEL *level, uint32_t part_raw[]);
+
+/**
+ * Wählt für einen Bereich gleich großer Abschnitte, ob er als ein Block
+ * oder als die Teilblöcke seiner beiden Hälften komprimiert wird.
+ *
+ * @param freq          Häufigkeiten je Abschnitt
+ * @param leaf_size     Anzahl der Zeichen je Abschnitt
+ * @param first         erster Abschnitt des Bereichs
+ * @param count         Anzahl der Abschnitte des Bereichs
+ * @param level         Kompressionsstufe
+ * @param part_raw      Anzahl der Zeichen je Teilblock (wird ergänzt)
+ * @param part_count    Anzahl der Teilblöcke (wird erhöht)
+ * @return              geschätzte komprimierte Länge in Bit
+ */
+static uint64_t choose_parts(const uint64_t freq[][SYMBOL_COUNT],
+                             const size_t leaf_size[], int first, int count,
+                             const LEVEL *level, uint32_t part_raw[],
+                             int *part_count);
+
+/**
+ * Schätzt die Länge eines komprimierten Blocks mit Blockkopf und
+ * Codetabelle.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param level     Kompressionsstufe
+ * @return          geschätzte Länge in Bit
+ */
+static uint64_t estimate_block_bits(const uint64_t freq[], const LEVEL *level);
+
+/**
+ * Berechnet die Länge eines mit Huffman kodierten Blockinhalts.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param lengths   Codelänge je Symbol
+ * @return          Länge in Bit ohne Auffüllen auf ganze Zeichen
+ */
+static uint64_t huffman_block_bits(const uint64_t freq[],
+                                   const unsigned char lengths[]);
+
+/**
+ * Berechnet die Länge eines Blockinhalts, der die Codetabelle des
+ * vorherigen Blocks übernimmt.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param history   Codetabelle des vorherigen Blocks, NULL für keine
+ * @return          Länge in Bit ohne Auffüllen auf ganze Zeichen,
+ *                  UINT64_MAX, wenn die Tabelle nicht alle Symbole enthält
+ */
+static uint64_t reuse_block_bits(const uint64_t freq[],
+                                 const TABLE_HISTORY *history);
+
+/**
+ * Berechnet die Länge eines mit der Codetabelle eines Wörterbuchs
+ * kodierten Blockinhalts.
+ *
+ * @param freq          Häufigkeit je Symbol
+ * @param dictionary    Wörterbuch, NULL für keins
+ * @return              Länge in Bit ohne Auffüllen auf ganze Zeichen,
+ *                      UINT64_MAX ohne Wörterbuch
+ */
+static uint64_t dictionary_block_bits(const uint64_t freq[],
+                                      const DICTIONARY *dictionary);
+
+/**
+ * Sucht ein geladenes Wörterbuch.
+ *
+ * @param id        Kennung des Wörterbuchs
+ * @return          das Wörterbuch, NULL wenn es nicht geladen ist
+ */
+static const DICTIONARY *find_dictionary(uint32_t id);
+
+/**
+ * Berechnet die Kennung einer Codetabelle (Prüfsumme CRC32C der
+ * Codelängen, niemals 0).
+ *
+ * @param lengths   Codelänge je Symbol
+ * @return          Kennung
+ */
+static uint32_t dictionary_id(const unsigned char lengths[]);
+
+/**
+ * Dekomprimiert einen Block.
+ *
+ * @param in        Eingabestrom im Speicher mit den komprimierten Daten
+ *                  des Blocks
+ * @param dst       Speicher für die unkomprimierten Zeichen (Ausgabe)
+ * @param size      Anzahl der unkomprimierten Zeichen des Blocks
+ * @param history   Codetabelle des vorherigen Blocks (wird aktualisiert),
+ *                  NULL für eingebettete Blockinhalte
+ */
+static void decode_block(READER *in, unsigned char dst[], uint32_t size,
+                         TABLE_HISTORY *history);
+
+/**
+ * Baut ein Kontextmodell erster Ordnung auf. Die 256 Kontexte werden zu
+ * höchstens MAX_CONTEXT_TABLES Gruppen zusammengefasst, die sich jeweils
+ * eine Codetabelle teilen.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param level     Kompressionsstufe
+ * @param model     aufgebautes Modell (Ausgabe)
+ * @return          Länge des Blockinhalts in Bit
+ */
+static uint64_t build_context_model(const unsigned char data[], size_t size,
+                                    const LEVEL *level, CONTEXT_MODEL *model);
+
+/**
+ * Schreibt Kontextmodell und kodierte Zeichen.
+ *
+ * @param data      zu kodierende Daten
+ * @param size      Anzahl der Zeichen
+ * @param out       Ausgabestrom
+ * @param model     Kontextmodell
+ */
+static void encode_context(const unsigned char data[], size_t size,
+                           WRITER *out, const CONTEXT_MODEL *model);
+
+/**
+ * Liest das Kontextmodell und dekodiert die Zeichen eines Blocks.
+ *
+ * @param in        Eingabestrom hinter der Art des Blockinhalts
+ * @param dst       dekodierte Zeichen (Ausgabe)
+ * @param size      Anzahl der zu dekodierenden Zeichen
+ */
+static void decode_context(READER *in, unsigned char dst[], uint32_t size);
+
+/**
+ * Zerlegt einen Block mit LZ77 und schreibt ihn, wenn er dadurch voraus-
+ * sichtlich kürzer wird als bei zeichenweiser Kodierung.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param out       Ausgabestrom
+ * @param level     Kompressionsstufe
+ * @return          true, wenn der Block geschrieben wurde
+ */
+static bool encode_lz77(const unsigned char data[], size_t size,
+                        WRITER *out, const LEVEL *level);
+
+/**
+ * Schätzt die Länge eines mit LZ77 zerlegten Blockinhalts und berechnet
+ * dabei die Codetabellen der Literallängen, Längen und Abstände.
+ *
+ * @param parse         LZ77-Zerlegung des Blocks
+ * @param level         Kompressionsstufe
+ * @param code_lengths  Codelänge je Code der drei Tabellen (Ausgabe)
+ * @return              geschätzte Länge in Bit ohne Blockkopf
+ */
+static uint64_t lz77_parse_bits(const LZ77_PARSE *parse, const LEVEL *level,
+                                unsigned char code_lengths[][SYMBOL_COUNT]);
+
+/**
+ * Prüft für einen Block, den is_incompressible gespeichert hätte, an
+ * Stichproben, ob er sich so oft innerhalb des Suchfensters wiederholt,
+ * dass die LZ77-Zerlegung ihn voraussichtlich kürzer macht als den
+ * gespeicherten Block.
+ *
+ * @param data      unkomprimierte Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param level     Kompressionsstufe
+ * @return          true, wenn der Block trotzdem kodiert werden soll
+ */
+static bool lz77_beats_stored(const unsigned char data[], size_t size,
+                              const LEVEL *level);
+
+/**
+ * Liest Literale und Sequenzen eines mit LZ77 zerlegten Blocks und setzt
+ * die Zeichen zusammen.
+ *
+ * @param in        Eingabestrom hinter der Art des Blockinhalts
+ * @param dst       dekodierte Zeichen (Ausgabe)
+ * @param size      Anzahl der zu dekodierenden Zeichen
+ */
+static void decode_lz77(READER *in, unsigned char dst[], uint32_t size);
+
+/**
+ * Bestimmt Code und Zusatzbits einer Länge bzw. eines Abstands. Werte
+ * unter 4 sind ihr eigener Code. Größere Werte werden durch die Position
+ * ihres höchsten Bits und die beiden folgenden Bits kodiert, die übrigen
+ * Bits folgen unverändert als Zusatzbits.
+ *
+ * @param value         zu kodierender Wert
+ * @param extra_bits    Anzahl der Zusatzbits (Ausgabe)
+ * @return              Code, kleiner als LZ77_CODE_COUNT
+ */
+static int lz77_value_code(uint32_t value, int *extra_bits);
+
+/**
+ * Liest Code und Zusatzbits einer Länge bzw. eines Abstands.
+ *
+ * @param table     Dekodiertabelle der Codes
+ * @param stream    Bitstrom
+ * @return          gelesener Wert
+ */
+static uint32_t read_lz77_value(const DECODE_TABLE *table, BIT_STREAM *stream);
+
+/**
+ * Liest eine Codetabelle für Längen- bzw. Abstandscodes.
+ *
+ * @param in        Eingabestrom
+ * @param lengths   Codelänge je Code (Ausgabe)
+ */
+static void read_lz77_table(READER *in, unsigned char lengths[]);
+
+/**
+ * Bestimmt den Zweierlogarithmus des Suchfensters zu einer Fenstergröße.
+ *
+ * @param window_size   gewünschte Fenstergröße in Byte
+ * @return              abgerundeter, auf die zulässigen Fenster begrenzter
+ *                      Zweierlogarithmus
+ */
+static int window_log(uint32_t window_size);
+
+/**
+ * Zählt die Häufigkeiten aller Zeichen eines Blocks.
+ *
+ * @param data      zu zählende Daten
+ * @param size      Anzahl der Zeichen
+ * @param freq      Häufigkeit je Symbol (Ausgabe)
+ */
+static void count_frequencies(const unsigned char data[], size_t size,
+                              uint64_t freq[]);
+
+/**
+ * Berechnet aus den Häufigkeiten die Codelängen eines Huffman-Codes, deren
+ * Länge durch die Kompressionsstufe begrenzt ist.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param lengths   Codelänge je Symbol, 0 für nicht vorkommende Symbole
+ * @param level     Kompressionsstufe
+ */
+static void build_code_lengths(const uint64_t freq[], unsigned char lengths[],
+                               const LEVEL *level);
+
+/**
+ * Berechnet die Codelängen eines Huffman-Codes. Ist ein Codewort länger als
+ * max_len, werden die Häufigkeiten halbiert und die Berechnung wiederholt.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param lengths   Codelänge je Symbol, 0 für nicht vorkommende Symbole
+ * @param max_len   maximale Länge eines Codeworts
+ */
+static void build_scaled_lengths(const uint64_t freq[], unsigned char lengths[],
+                                 int max_len);
+
+/**
+ * Berechnet mit dem Package-Merge-Verfahren optimale Codelängen, die
+ * höchstens max_len Bit lang sind.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param lengths   Codelänge je Symbol, 0 für nicht vorkommende Symbole
+ * @param max_len   maximale Länge eines Codeworts, höchstens MAX_CODE_LEN
+ */
+static void build_optimal_lengths(const uint64_t freq[], unsigned char lengths[],
+                                  int max_len);
+
+/**
+ * Berechnet die Codelängen eines Huffman-Codes ohne Längenbegrenzung.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param lengths   Codelänge je Symbol (Ausgabe)
+ * @return          größte Codelänge
+ */
+static int build_huffman_lengths(const uint64_t freq[], unsigned char lengths[]);
+
+/**
+ * Weist den Symbolen anhand ihrer Codelängen kanonische Codewörter zu.
+ *
+ * @param lengths   Codelänge je Symbol
+ * @param codes     Codewort je Symbol (Ausgabe)
+ */
+static void assign_canonical_codes(const unsigned char lengths[],
+                                   uint32_t codes[]);
+
+/**
+ * Schreibt die Codetabelle in der kürzeren der beiden Formen: als Paare aus
+ * Symbol und Länge (bis MAX_SPARSE_SYMBOLS Symbole) oder lauflängenkodiert
+ * (siehe build_rle_table).
+ *
+ * @param out       Ausgabestrom
+ * @param lengths   Codelänge je Symbol
+ */
+static void write_table(WRITER *out, const unsigned char lengths[]);
+
+/**
+ * Berechnet die Länge der Codetabelle, die write_table schreibt.
+ *
+ * @param lengths   Codelänge je Symbol
+ * @return          Länge in Byte
+ */
+static size_t table_size(const unsigned char lengths[]);
+
+/**
+ * Kodiert die Codelängen 0 bis zum letzten vorkommenden Symbol mit Läufen
+ * wie DEFLATE (RFC 1951, Abschnitt 3.2.7) und berechnet den Hilfscode für
+ * die Symbole der Lauflängenkodierung.
+ *
+ * @param lengths   Codelänge je Symbol
+ * @param rle       lauflängenkodierte Tabelle (Ausgabe)
+ */
+static void build_rle_table(const unsigned char lengths[], RLE_TABLE *rle);
+
+/**
+ * Liest die Codetabelle und prüft die Codelängen auf Gültigkeit.
+ *
+ * @param in        Eingabestrom
+ * @param lengths   Codelänge je Symbol (Ausgabe)
+ * @param history   Codetabelle des vorherigen Blocks für TABLE_REUSE, NULL
+ *                  wenn die Tabelle nicht übernommen werden darf
+ */
+static void read_table(READER *in, unsigned char lengths[],
+                       const TABLE_HISTORY *history);
+
+/**
+ * Liest die Codelängen einer lauflängenkodierten Codetabelle.
+ *
+ * @param in        Eingabestrom hinter der Art der Codetabelle
+ * @param lengths   Codelänge je Symbol (Ausgabe, mit 0 vorbelegt)
+ */
+static void read_rle_table(READER *in, unsigned char lengths[]);
+
+/**
+ * Liest ein mit dem Hilfscode kodiertes Symbol der Lauflängenkodierung.
+ *
+ * @param reader    Bitweises Lesen der Codetabelle
+ * @param count     Anzahl der Codewörter je Länge des Hilfscodes
+ * @param sorted    Symbole in der Reihenfolge ihrer kanonischen Codewörter
+ * @return          Symbol, kleiner als RLE_SYMBOL_COUNT
+ */
+static int read_rle_symbol(TABLE_READER *reader, const int count[],
+                           const int sorted[]);
+
+/**
+ * Liest die nächsten n Bits einer Codetabelle.
+ *
+ * @param reader    Bitweises Lesen der Codetabelle
+ * @param n         Anzahl der Bits (1 bis 8)
+ * @return          gelesene Bits, das erste im höchstwertigen
+ */
+static uint32_t read_table_bits(TABLE_READER *reader, int n);
+
+/**
+ * Liefert die Anzahl der Zusatzbits eines Symbols der Lauflängenkodierung.
+ *
+ * @param symbol    Symbol, kleiner als RLE_SYMBOL_COUNT
+ * @return          Anzahl der Zusatzbits
+ */
+static int rle_extra_bits(int symbol);
+
+/**
+ * Kodiert die Zeichen mit den übergebenen Codewörtern.
+ *
+ * @param data      zu kodierende Daten
+ * @param size      Anzahl der Zeichen
+ * @param out       Ausgabestrom
+ * @param lengths   Codelänge je Symbol
+ * @param codes     Codewort je Symbol
+ */
+static void encode_symbols(const unsigned char data[], size_t size,
+                           WRITER *out, const unsigned char lengths[],
+                           const uint32_t codes[]);
+
+/**
+ * Kodiert die Zeichen reihum in STREAM_COUNT Bitströme (Zeichen i in
+ * Bitstrom i % STREAM_COUNT) und schreibt Sprungtabelle und Bitströme.
+ *
+ * @param data      zu kodierende Daten
+ * @param size      Anzahl der Zeichen
+ * @param out       Ausgabestrom
+ * @param lengths   Codelänge je Symbol
+ * @param codes     Codewort je Symbol
+ */
+static void encode_interleaved(const unsigned char data[], size_t size,
+                               WRITER *out, const unsigned char lengths[],
+                               const uint32_t codes[]);
+
+/**
+ * Baut die Dekodiertabelle aus den Codelängen auf. Die Sekundärtabellen
+ * werden dynamisch angelegt und müssen mit free_decode_table freigegeben
+ * werden.
+ *
+ * @param lengths   Codelänge je Symbol
+ * @param table     aufzubauende Tabelle (Ausgabe)
+ */
+static void build_decode_table(const unsigned char lengths[],
+                               DECODE_TABLE *table);
+
+/**
+ * Gibt die Sekundärtabellen einer Dekodiertabelle frei.
+ *
+ * @param table     freizugebende Tabelle
+ */
+static void free_decode_table(DECODE_TABLE *table);
+
+/**
+ * Dekodiert size Symbole aus stream_count Bitströmen, wobei Symbol i aus
+ * Bitstrom i % stream_count stammt. Bei STREAM_COUNT Bitströmen werden
+ * alle Bitströme in einer Schleife nebeneinander dekodiert.
+ *
+ * @param table         Dekodiertabelle
+ * @param streams       Bitströme
+ * @param stream_count  Anzahl der Bitströme (1 oder STREAM_COUNT)
+ * @param dst           dekodierte Symbole (Ausgabe)
+ * @param size          Anzahl der zu dekodierenden Symbole
+ */
+static void decode_streams(const DECODE_TABLE *table, BIT_STREAM streams[],
+                           int stream_count, unsigned char dst[],
+                           uint32_t size);
+
+/**
+ * Dekodiert zwei aufeinanderfolgende Symbole eines Bitstroms. Der
+ * Bitstrom muss mindestens 2 * MAX_CODE_LEN Bits gepuffert haben.
+ *
+ * @param table     Dekodiertabelle
+ * @param stream    Bitstrom
+ * @param first     erstes Symbol (Ausgabe)
+ * @param second    zweites Symbol (Ausgabe)
+ * @return          false bei einem ungültigen Codewort
+ */
+static bool decode_pair(const DECODE_TABLE *table, BIT_STREAM *stream,
+                        unsigned char *first, unsigned char *second);
+
+/**
+ * Sucht den Eintrag der Dekodiertabelle für die nächsten Bits.
+ *
+ * @param table     Dekodiertabelle
+ * @param bits      linksbündige Bits
+ * @return          Eintrag mit mindestens einem Symbol, 0 bei einem
+ *                  ungültigen Codewort
+ */
+static uint32_t lookup_entry(const DECODE_TABLE *table, uint64_t bits);
+
+/**
+ * Initialisiert einen Bitstrom im Speicher.
+ *
+ * @param stream    zu initialisierender Bitstrom
+ * @param data      Beginn der Daten
+ * @param size      Anzahl der Zeichen
+ */
+static void stream_open(BIT_STREAM *stream, const unsigned char data[],
+                        size_t size);
+
+/**
+ * Füllt den Akkumulator eines Bitstroms auf mindestens 56 Bits auf,
+ * solange Daten vorhanden sind.
+ *
+ * @param stream    Bitstrom
+ */
+static void stream_refill(BIT_STREAM *stream);
+
+/**
+ * Schreibt eine 32-Bit-Zahl, höchstwertiges Byte zuerst.
+ *
+ * @param out       Ausgabestrom
+ * @param value     zu schreibende Zahl
+ */
+static void write_u32(WRITER *out, uint32_t value);
+
+/**
+ * Liest eine 32-Bit-Zahl, höchstwertiges Byte zuerst.
+ *
+ * @param in        Eingabestrom
+ * @return          gelesene Zahl
+ */
+static uint32_t read_u32(READER *in);
+
+/**
+ * Schreibt eine 64-Bit-Zahl, höchstwertiges Byte zuerst.
+ *
+ * @param out       Ausgabestrom
+ * @param value     zu schreibende Zahl
+ */
+static void write_u64(WRITER *out, uint64_t value);
+
+/**
+ * Liest eine 64-Bit-Zahl, höchstwertiges Byte zuerst.
+ *
+ * @param in        Eingabestrom
+ * @return          gelesene Zahl
+ */
+static uint64_t read_u64(READER *in);
+
+/**
+ * Liest das nächste Zeichen des Dateikopfs oder bricht das Programm ab,
+ * wenn die Datei vorzeitig endet.
+ *
+ * @param in    Eingabestrom
+ * @return      gelesenes Zeichen
+ */
+static unsigned char read_header_char(READER *in);
+
+/**
+ * Liest eine 32-Bit-Zahl aus dem Speicher, höchstwertiges Byte zuerst.
+ *
+ * @param data      erstes Byte
+ * @return          gelesene Zahl
+ */
+static uint32_t load_u32(const unsigned char data[]);
+
+/**
+ * Gibt den Ring der Aufträge beim Komprimieren samt Puffern und
+ * Ergebnissen frei.
+ *
+ * @param ring  der Ring (BLOCK_RING)
+ */
+static void release_block_ring(void *ring);
+
+/**
+ * Schliesst nach einem Fehler die Ein- und Ausgabedatei und löscht die
+ * unvollständige Ausgabedatei.
+ *
+ * @param in            Eingabestrom, stream ist NULL wenn nicht geöffnet
+ * @param out           Ausgabestrom, stream ist NULL wenn nicht geöffnet
+ * @param out_filename  Name der Ausgabedatei
+ * @param created       true, wenn die Ausgabedatei angelegt wurde
+ */
+static void discard_files(READER *in, WRITER *out, const char out_filename[],
+                          bool created);
+
+/**
+ * Reserviert Speicher wie allocate. Ist eine Fehlerfalle gesetzt, wird der
+ * Speicher bei einem Abbruch über die Falle freigegeben.
+ *
+ * @param size  Anzahl der Bytes
+ * @return      reservierter Speicher
+ */
+static void *allocate_owned(size_t size);
+
+/**
+ * Gibt mit allocate_owned reservierten Speicher frei.
+ *
+ * @param memory    freizugebender Speicher oder NULL
+ */
+static void free_owned(void *memory);
+
+/**
+ * Reserviert Speicher oder meldet einen Fehler (trap_raise), wenn nicht
+ * genügend Speicher vorhanden ist.
+ *
+ * @param size  Anzahl der Bytes
+ * @return      reservierter Speicher
+ */
+static void *allocate(size_t size);
+
+/**
+ * Gibt einen Fehler beim Dekomprimieren aus und bricht das Programm ab.
+ * Ist eine Fehlerfalle gesetzt, wird stattdessen zu ihr zurückgesprungen
+ * (trap_raise).
+ *
+ * @param message   auszugebende Fehlermeldung
+ */
+static void report_format_error_and_exit(const char *message);
+
+
+/* ============================================================================
+ * Funktions-Definitionen
+ * ========================================================================= */
+
+extern void init_options(HUFFMAN_OPTIONS *options)
+{
+    options->level = HUFFMAN_STD_LEVEL;
+    options->block_size = HUFFMAN_STD_BLOCK_SIZE;
+    options->threads = pool_cpu_count();
+    options->window_size = 0;
+    options->checksum = false;
+    options->range_offset = 0;
+    options->range_length = UINT64_MAX;
+    options->dictionary = 0;
+    options->stats = NULL;
+}
+
+extern void init_stats(HUFFMAN_STATS *stats)
+{
+    memset(stats, 0, sizeof (HUFFMAN_STATS));
+}
+
+extern void add_stats(HUFFMAN_STATS *sum, const HUFFMAN_STATS *stats)
+{
+    int phase;
+
+    for (phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        sum->phase_seconds[phase] += stats->phase_seconds[phase];
+    }
+    sum->in_bytes += stats->in_bytes;
+    sum->out_bytes += stats->out_bytes;
+    sum->blocks += stats->blocks;
+}
+
+extern void compress(char in_filename[], char out_filename[])
+{
+    HUFFMAN_OPTIONS options;
+
+    init_options(&options);
+    compress_with_options(in_filename, out_filename, &options);
+}
+
+extern void decompress(char in_filename[], char out_filename[])
+{
+    HUFFMAN_OPTIONS options;
+
+    init_options(&options);
+    decompress_with_options(in_filename, out_filename, &options);
+}
+
+extern void compress_with_options(char in_filename[], char out_filename[],
+                                  const HUFFMAN_OPTIONS *options)
+{
+    READER in;
+    WRITER out;
+    TRAP trap;
+    bool streaming = strcmp(in_filename, STDIO_FILENAME) == 0
+            || strcmp(out_filename, STDIO_FILENAME) == 0;
+    HUFFMAN_STATS *stats = options->stats;
+    double *caller_seconds = phase_seconds;
+    volatile bool created = false;
+    double start;
+    uint64_t size;
+
+    /* Lesen und Schreiben misst dieser Thread, die Blöcke ihr Auftrag */
+    phase_seconds = (stats != NULL) ? stats->phase_seconds : NULL;
+
+    /*
+     * Nach einem Fehler werden die Dateien geschlossen und die
+     * unvollständige Ausgabe gelöscht, bevor der Fehler weitergemeldet wird
+     */
+    in.stream = NULL;
+    out.stream = NULL;
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        start = phase_start();
+        reader_open(&in, in_filename);
+        phase_stop(PHASE_READ, start);
+        writer_open(&out, out_filename);
+        created = true;
+
+        /*
+         * Beim Lesen oder Schreiben über Standardein- und -ausgabe entfällt
+         * das Blockverzeichnis, damit der Speicherbedarf unabhängig von der
+         * Länge der Eingabe bleibt; solche Dateien werden nacheinander
+         * dekomprimiert.
+         */
+        size = compress_stream(&in, &out, options, !streaming);
+
+        start = phase_start();
+        writer_close(&out);
+        phase_stop(PHASE_WRITE, start);
+        reader_close(&in);
+
+        if (stats != NULL)
+        {
+            stats->out_bytes += size;
+        }
+    }
+    phase_active = false;
+    phase_seconds = caller_seconds;
+    if (trap_clear(&trap) != EXIT_SUCCESS)
+    {
+        discard_files(&in, &out, out_filename, created);
+        trap_raise(trap.status, trap.message);
+    }
+}
+
+static uint64_t compress_stream(READER *in, WRITER *out,
+                                const HUFFMAN_OPTIONS *options,
+                                bool with_index)
+{
+    POOL *pool;
+    BLOCK_RING *ring;
+    BLOCK_JOB *jobs;
+    BLOCK_INDEX index = {NULL, 0, 0};
+    size_t job_count;
+    uint64_t submitted = 0;
+    uint64_t written = 0;
+    uint64_t offset = FILE_MAGIC_LEN + 1;
+    bool end_of_input = false;
+    const unsigned char *span;
+    size_t span_size = 0;
+    size_t span_pos = 0;
+    HUFFMAN_STATS *stats = options->stats;
+    const DICTIONARY *dictionary = NULL;
+    size_t blocks_per_job;
+    size_t job_size;
+    int threads;
+    double start;
+    size_t i;
+
+    if (options->dictionary != 0)
+    {
+        dictionary = find_dictionary(options->dictionary);
+        if (dictionary == NULL)
+        {
+            report_format_error_and_exit(EMSG_MISSING_DICTIONARY);
+        }
+    }
+
+    /* Eingeblendete Dateien werden ohne Kopie blockweise bearbeitet */
+    span = reader_span(in, &span_size);
+
+    writer_write(out, (const unsigned char *) FILE_MAGIC, FILE_MAGIC_LEN);
+    writer_write_char(out, FORMAT_VERSION);
+
+    /*
+     * Die Blöcke werden reihum in einem Ring von Aufträgen bearbeitet.
+     * Ist der Ring voll, wird der älteste Auftrag abgewartet und sein
+     * Ergebnis geschrieben, so dass die Blöcke in der Reihenfolge der
+     * Eingabe in der Ausgabedatei stehen und der Speicherbedarf begrenzt
+     * bleibt.
+     */
+    /*
+     * Kleine Blöcke werden zu einem Auftrag zusammengefasst, damit ein Block
+     * die Codetabelle seines Vorgängers übernehmen kann. In der Datei
+     * bleiben es Blöcke der gewählten Größe.
+     */
+    blocks_per_job = MIN_JOB_SIZE / options->block_size;
+    blocks_per_job = (blocks_per_job < 1) ? 1
+            : (blocks_per_job > MAX_SPLIT_PARTS) ? MAX_SPLIT_PARTS
+            : blocks_per_job;
+    job_size = blocks_per_job * options->block_size;
+
+    /*
+     * Passt die Eingabe in einen Auftrag, wird sie ohne Threads im
+     * aufrufenden Thread komprimiert; das spart bei kleinen Puffern und
+     * Dateien das Anlegen der Threads
+     */
+    threads = (span != NULL && span_size <= job_size) ? 1 : options->threads;
+    job_count = (size_t) (threads > 1 ? threads : 1) * JOBS_PER_THREAD;
+
+    /*
+     * Der Ring wird vor dem Pool an die Fehlerfalle übergeben; nach einem
+     * Fehler wird also zuerst der Pool beendet und erst dann der Speicher
+     * freigegeben, den seine Threads noch verwenden.
+     */
+    ring = (BLOCK_RING *) allocate(sizeof (BLOCK_RING));
+    ring->jobs = NULL;
+    ring->count = 0;
+    trap_own(ring, release_block_ring);
+    jobs = (BLOCK_JOB *) allocate(job_count * sizeof (BLOCK_JOB));
+    ring->jobs = jobs;
+    for (i = 0; i < job_count; i++)
+    {
+        jobs[i].buffer = NULL;
+        jobs[i].output = NULL;
+        jobs[i].timed = (stats != NULL);
+        jobs[i].checksum = options->checksum;
+        jobs[i].block_size = (blocks_per_job > 1) ? options->block_size : 0;
+        jobs[i].level = levels[(options->level < 1) ? 0
+                               : (options->level > LEVEL_COUNT)
+                               ? LEVEL_COUNT - 1 : options->level - 1];
+        if (options->window_size > 0)
+        {
+            jobs[i].level.lz77.window_log = window_log(options->window_size);
+        }
+        jobs[i].level.dictionary = dictionary;
+    }
+    ring->count = job_count;
+    pool = pool_create(threads);
+
+    while (!end_of_input || written < submitted)
+    {
+        if (!end_of_input && submitted - written < job_count)
+        {
+            BLOCK_JOB *job = &jobs[submitted % job_count];
+
+            if (span != NULL)
+            {
+                job->input = span + span_pos;
+                job->input_size = (span_size - span_pos < job_size)
+                        ? span_size - span_pos : job_size;
+                span_pos += job->input_size;
+            }
+            else
+            {
+                if (job->buffer == NULL)
+                {
+                    job->buffer = (unsigned char *) allocate(job_size);
+                }
+                job->input = job->buffer;
+                start = phase_start();
+                job->input_size = reader_read(in, job->buffer, job_size);
+                phase_stop(PHASE_READ, start);
+            }
+            if (job->input_size == 0)
+            {
+                end_of_input = true;
+            }
+            else
+            {
+                if (stats != NULL)
+                {
+                    stats->in_bytes += job->input_size;
+                }
+                pool_submit(pool, &job->job, compress_block_task, job);
+                submitted++;
+            }
+        }
+        else
+        {
+            BLOCK_JOB *job = &jobs[written % job_count];
+            const unsigned char *payload;
+            INDEX_ENTRY entry;
+            int part;
+            int phase;
+
+            pool_wait(pool, &job->job);
+            if (stats != NULL)
+            {
+                for (phase = 0; phase < PHASE_COUNT; phase++)
+                {
+                    stats->phase_seconds[phase] += job->phase_seconds[phase];
+                }
+                stats->blocks += (uint64_t) job->part_count;
+            }
+
+            start = phase_start();
+            payload = job->output;
+            for (part = 0; part < job->part_count; part++)
+            {
+                write_u32(out, job->part_raw[part]);
+                write_u32(out, job->part_payload[part]);
+                if (job->stored)
+                {
+                    /* ohne Kopie direkt aus der Eingabe */
+                    if (job->checksum)
+                    {
+                        writer_write_char(out, BLOCK_CHECKED);
+                        write_u32(out, job->crc);
+                    }
+                    writer_write_char(out, BLOCK_STORED);
+                    writer_write(out, job->input, job->input_size);
+                }
+                else
+                {
+                    writer_write(out, payload, job->part_payload[part]);
+                    payload += job->part_payload[part];
+                }
+
+                if (with_index)
+                {
+                    entry.offset = offset;
+                    entry.raw_size = job->part_raw[part];
+                    entry.payload_size = job->part_payload[part];
+                    add_index_entry(&index, &entry);
+                }
+                offset += BLOCK_HEADER_LEN + job->part_payload[part];
+            }
+            phase_stop(PHASE_WRITE, start);
+            free(job->output);
+            job->output = NULL;
+            written++;
+        }
+    }
+
+    /*
+     * Ein Block der Länge 0 kennzeichnet das Ende, danach folgt das
+     * Verzeichnis. Bei nur einem Block entfällt es, weil es weder parallel
+     * noch ausschnittweise etwas zu sparen gäbe, kleine Dateien aber
+     * deutlich verlängerte.
+     */
+    start = phase_start();
+    write_u32(out, 0);
+    offset += 4;
+    if (with_index && index.count > 1)
+    {
+        write_index(out, &index, offset);
+        offset += index.count * INDEX_ENTRY_LEN + TRAILER_LEN;
+    }
+    phase_stop(PHASE_WRITE, start);
+    free_owned(index.entries);
+
+    pool_destroy(pool);
+    trap_disown(ring);
+    release_block_ring(ring);
+
+    return offset;
+}
+
+
+extern void decompress_with_options(char in_filename[], char out_filename[],
+                                    const HUFFMAN_OPTIONS *options)
+{
+    READER in;
+    WRITER out;
+    TRAP trap;
+    uint64_t in_size;
+    uint64_t consumed;
+    HUFFMAN_STATS *stats = options->stats;
+    double *caller_seconds = phase_seconds;
+    volatile bool created = false;
+    double start;
+
+    phase_seconds = (stats != NULL) ? stats->phase_seconds : NULL;
+
+    /* Fehler werden wie beim Komprimieren behandelt */
+    in.stream = NULL;
+    out.stream = NULL;
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        start = phase_start();
+        reader_open(&in, in_filename);
+        phase_stop(PHASE_READ, start);
+        writer_open(&out, out_filename);
+        created = true;
+        consumed = decompress_stream(&in, &out, options);
+
+        if (stats != NULL)
+        {
+            stats->in_bytes += reader_size(&in, &in_size)
+                    ? in_size : consumed;
+        }
+
+        reader_close(&in);
+        start = phase_start();
+        writer_close(&out);
+        phase_stop(PHASE_WRITE, start);
+    }
+    phase_active = false;
+    phase_seconds = caller_seconds;
+    if (trap_clear(&trap) != EXIT_SUCCESS)
+    {
+        discard_files(&in, &out, out_filename, created);
+        trap_raise(trap.status, trap.message);
+    }
+}
+static uint64_t decompress_stream(READER *in, WRITER *out,
+                                  const HUFFMAN_OPTIONS *options)
+{
+    BLOCK_INDEX index = {NULL, 0, 0};
+    unsigned char header[FILE_MAGIC_LEN + 1];
+    uint64_t range_start = options->range_offset;
+    uint64_t range_end;
+    uint64_t consumed = 0;
+
+    if (reader_read(in, header, sizeof (header)) != sizeof (header)
+            || memcmp(header, FILE_MAGIC, FILE_MAGIC_LEN) != 0
+            || header[FILE_MAGIC_LEN] != FORMAT_VERSION)
+    {
+        report_format_error_and_exit(EMSG_INVALID_FILE);
+    }
+
+    range_end = (options->range_length > UINT64_MAX - range_start)
+            ? UINT64_MAX : range_start + options->range_length;
+
+    /*
+     * Mit Blockverzeichnis und positionsweise beschreibbarer Ausgabedatei
+     * werden die Blöcke parallel dekomprimiert, sonst nacheinander.
+     */
+    if (read_index(in, &index) && index.count > 0)
+    {
+        const INDEX_ENTRY *last = &index.entries[index.count - 1];
+        uint64_t raw_total = last->raw_offset + last->raw_size;
+
+        if (range_end > raw_total)
+        {
+            range_end = raw_total;
+        }
+        if (range_start > range_end)
+        {
+            range_start = range_end;
+        }
+    }
+    if (index.count > 0 && writer_set_size(out, range_end - range_start))
+    {
+        decompress_parallel(in, out, &index, range_start, range_end,
+                            options->threads, options->stats);
+    }
+    else
+    {
+        consumed = decompress_sequential(in, out, &index, range_start,
+                                         range_end, options->stats);
+    }
+    free_owned(index.entries);
+
+    return sizeof (header) + consumed;
+}
+
+extern int compress_batch(char *in_filenames[], char *out_filenames[],
+                          size_t count, const HUFFMAN_OPTIONS *options)
+{
+    return process_batch(in_filenames, out_filenames, count, options, true);
+}
+
+extern int decompress_batch(char *in_filenames[], char *out_filenames[],
+                            size_t count, const HUFFMAN_OPTIONS *options)
+{
+    return process_batch(in_filenames, out_filenames, count, options, false);
+}
+
+extern size_t compress_bound(size_t size, const HUFFMAN_OPTIONS *options)
+{
+    size_t block_size = (options != NULL && options->block_size > 0)
+            ? options->block_size : HUFFMAN_STD_BLOCK_SIZE;
+    size_t blocks = (size + block_size - 1) / block_size;
+    size_t block_len = BLOCK_HEADER_LEN + 1;
+
+    if (options != NULL && options->checksum)
+    {
+        block_len += CHECKSUM_LEN;
+    }
+
+    /* Kein Block wird länger als gespeichert (siehe compress_block_task) */
+    return FILE_MAGIC_LEN + 1 + size + blocks * block_len + 4;
+}
+
+extern int compress_buffer(const unsigned char src[], size_t src_size,
+                           unsigned char dst[], size_t dst_capacity,
+                           size_t *dst_size, const HUFFMAN_OPTIONS *options)
+{
+    HUFFMAN_OPTIONS defaults;
+    READER in;
+    WRITER out;
+    TRAP trap;
+    size_t size;
+    double *caller_seconds = phase_seconds;
+    uint64_t written = 0;
+    bool complete = false;
+
+    if ((src == NULL && src_size > 0) || dst == NULL || dst_size == NULL)
+    {
+        return EXIT_OPTION_ERROR;
+    }
+    if (options == NULL)
+    {
+        init_options(&defaults);
+        options = &defaults;
+    }
+    if (options->dictionary != 0 && find_dictionary(options->dictionary) == NULL)
+    {
+        return EXIT_OPTION_ERROR;
+    }
+
+    /*
+     * Ohne Blockverzeichnis, es dient nur dem Lesen aus Dateien. Fehlen
+     * Speicher oder Threads, springt der Fehler (auch aus den Threads des
+     * Pools) hierher zurück, statt das Programm abzubrechen.
+     */
+    phase_seconds = (options->stats != NULL)
+            ? options->stats->phase_seconds : NULL;
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        reader_open_memory(&in, src, src_size);
+        writer_open_buffer(&out, dst, dst_capacity);
+        written = compress_stream(&in, &out, options, false);
+        complete = writer_close_buffer(&out, &size);
+    }
+    phase_active = false;
+    phase_seconds = caller_seconds;
+    if (trap_clear(&trap) != EXIT_SUCCESS)
+    {
+        return trap.status;
+    }
+
+    if (options->stats != NULL)
+    {
+        options->stats->out_bytes += written;
+    }
+    if (!complete)
+    {
+        return EXIT_DST_TOO_SMALL;
+    }
+    *dst_size = size;
+
+    return EXIT_SUCCESS;
+}
+
+extern int decompressed_size(const unsigned char src[], size_t src_size,
+                             uint64_t *size)
+{
+    size_t pos = FILE_MAGIC_LEN + 1;
+    uint64_t total = 0;
+
+    if (src == NULL || size == NULL)
+    {
+        return EXIT_OPTION_ERROR;
+    }
+    if (src_size < pos || memcmp(src, FILE_MAGIC, FILE_MAGIC_LEN) != 0
+            || src[FILE_MAGIC_LEN] != FORMAT_VERSION)
+    {
+        return EXIT_DC_ERROR;
+    }
+
+    /* Nur die Blockköpfe lesen und die unkomprimierten Längen addieren */
+    while (src_size - pos >= 4 && load_u32(src + pos) != 0)
+    {
+        uint32_t payload_size;
+
+        if (src_size - pos < BLOCK_HEADER_LEN)
+        {
+            return EXIT_DC_ERROR;
+        }
+        total += load_u32(src + pos);
+        payload_size = load_u32(src + pos + 4);
+        pos += BLOCK_HEADER_LEN;
+        if (payload_size > src_size - pos)
+        {
+            return EXIT_DC_ERROR;
+        }
+        pos += payload_size;
+    }
+    if (src_size - pos < 4)
+    {
+        return EXIT_DC_ERROR;
+    }
+    *size = total;
+
+    return EXIT_SUCCESS;
+}
+
+extern int decompress_buffer(const unsigned char src[], size_t src_size,
+                             unsigned char dst[], size_t dst_capacity,
+                             size_t *dst_size)
+{
+    TRAP trap;
+    int status = EXIT_SUCCESS;
+
+    if (src == NULL || (dst == NULL && dst_capacity > 0) || dst_size == NULL)
+    {
+        return EXIT_OPTION_ERROR;
+    }
+
+    /*
+     * Fehler im Format der Daten springen hierher zurück, statt das
+     * Programm abzubrechen. Der Speicher der gerade dekodierten Blöcke
+     * wird dabei freigegeben.
+     */
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        status = decompress_memory(src, src_size, dst, dst_capacity, dst_size);
+    }
+    if (trap_clear(&trap) != EXIT_SUCCESS)
+    {
+        return trap.status;
+    }
+
+    return status;
+}
+
+extern uint32_t train_dictionary(char *sample_filenames[], size_t count,
+                                 char dictionary_filename[],
+                                 const HUFFMAN_OPTIONS *options)
+{
+    uint64_t freq[SYMBOL_COUNT] = {0};
+    uint64_t chunk_freq[SYMBOL_COUNT];
+    unsigned char lengths[SYMBOL_COUNT];
+    unsigned char *buffer;
+    const LEVEL *level;
+    READER in;
+    WRITER out;
+    uint32_t id;
+    size_t size;
+    size_t i;
+    int k;
+
+    level = &levels[(options->level < 1) ? 0
+                    : (options->level > LEVEL_COUNT)
+                    ? LEVEL_COUNT - 1 : options->level - 1];
+
+    /* Häufigkeiten über alle Beispieldateien */
+    buffer = (unsigned char *) allocate(options->block_size);
+    for (i = 0; i < count; i++)
+    {
+        reader_open(&in, sample_filenames[i]);
+        while ((size = reader_read(&in, buffer, options->block_size)) > 0)
+        {
+            count_frequencies(buffer, size, chunk_freq);
+            for (k = 0; k < SYMBOL_COUNT; k++)
+            {
+                freq[k] += chunk_freq[k];
+            }
+        }
+        reader_close(&in);
+    }
+    free(buffer);
+
+    /*
+     * Jedes Symbol erhält ein Codewort, auch wenn es in den Beispielen
+     * nicht vorkommt, damit sich jeder Block mit dem Wörterbuch kodieren
+     * lässt
+     */
+    for (k = 0; k < SYMBOL_COUNT; k++)
+    {
+        freq[k]++;
+    }
+    build_code_lengths(freq, lengths, level);
+    id = dictionary_id(lengths);
+
+    writer_open(&out, dictionary_filename);
+    writer_write(&out, (const unsigned char *) DICTIONARY_MAGIC,
+                 DICTIONARY_MAGIC_LEN);
+    writer_write_char(&out, DICTIONARY_VERSION);
+    write_u32(&out, id);
+    write_table(&out, lengths);
+    writer_close(&out);
+
+    return id;
+}
+
+extern uint32_t load_dictionary(char dictionary_filename[])
+{
+    DICTIONARY *dictionary;
+    unsigned char magic[DICTIONARY_MAGIC_LEN];
+    READER in;
+    uint32_t id;
+    int i;
+
+    reader_open(&in, dictionary_filename);
+    for (i = 0; i < DICTIONARY_MAGIC_LEN; i++)
+    {
+        magic[i] = read_header_char(&in);
+    }
+    if (memcmp(magic, DICTIONARY_MAGIC, DICTIONARY_MAGIC_LEN) != 0
+            || read_header_char(&in) != DICTIONARY_VERSION)
+    {
+        report_format_error_and_exit(EMSG_INVALID_DICTIONARY);
+    }
+    id = read_u32(&in);
+    dictionary = (DICTIONARY *) allocate(sizeof (DICTIONARY));
+    read_table(&in, dictionary->lengths, NULL);
+    reader_close(&in);
+
+    /* Alle Symbole brauchen ein Codewort, die Kennung muss passen */
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (dictionary->lengths[i] == 0)
+        {
+            report_format_error_and_exit(EMSG_INVALID_DICTIONARY);
+        }
+    }
+    if (dictionary_id(dictionary->lengths) != id)
+    {
+        report_format_error_and_exit(EMSG_INVALID_DICTIONARY);
+    }
+
+    /* Ein bereits geladenes Wörterbuch wird weiterverwendet */
+    if (find_dictionary(id) != NULL)
+    {
+        free(dictionary);
+        return id;
+    }
+    if (dictionary_count == MAX_DICTIONARIES)
+    {
+        report_format_error_and_exit(EMSG_TOO_MANY_DICTIONARIES);
+    }
+
+    dictionary->id = id;
+    assign_canonical_codes(dictionary->lengths, dictionary->codes);
+    build_decode_table(dictionary->lengths, &dictionary->table);
+    dictionaries[dictionary_count++] = dictionary;
+
+    return id;
+}
+
+extern void unload_dictionaries(void)
+{
+    while (dictionary_count > 0)
+    {
+        DICTIONARY *dictionary = dictionaries[--dictionary_count];
+
+        free_decode_table(&dictionary->table);
+        free(dictionary);
+    }
+}
+
+static int process_batch(char *in_filenames[], char *out_filenames[],
+                         size_t count, const HUFFMAN_OPTIONS *options,
+                         bool compress)
+{
+    FILE_JOB *jobs;
+    POOL *pool;
+    int status = EXIT_SUCCESS;
+    size_t i;
+
+    /*
+     * Die Dateien sind unabhängig voneinander. Statt die Blöcke einer
+     * Datei zu verteilen, bearbeitet jeder Thread eine ganze Datei; so
+     * überlappen sich auch Öffnen, Lesen und Schreiben der Dateien. Jede
+     * Datei erfasst ihre eigene Statistik, die zum Schluss addiert wird.
+     * Eine fehlerhafte Datei bricht nur ihren eigenen Auftrag ab.
+     */
+    jobs = (FILE_JOB *) allocate(count * sizeof (FILE_JOB));
+    pool = pool_create(options->threads);
+    for (i = 0; i < count; i++)
+    {
+        jobs[i].in_filename = in_filenames[i];
+        jobs[i].out_filename = out_filenames[i];
+        jobs[i].compress = compress;
+        jobs[i].options = *options;
+        jobs[i].options.threads = 1;
+        if (options->stats != NULL)
+        {
+            init_stats(&jobs[i].stats);
+            jobs[i].options.stats = &jobs[i].stats;
+        }
+        pool_submit(pool, &jobs[i].job, file_task, &jobs[i]);
+    }
+    for (i = 0; i < count; i++)
+    {
+        pool_wait(pool, &jobs[i].job);
+        if (jobs[i].status != EXIT_SUCCESS)
+        {
+            status = (status != EXIT_SUCCESS) ? status : jobs[i].status;
+        }
+        else if (options->stats != NULL)
+        {
+            add_stats(options->stats, &jobs[i].stats);
+        }
+    }
+    pool_destroy(pool);
+    free(jobs);
+
+    return status;
+}
+
+static void file_task(void *arg)
+{
+    FILE_JOB *job = (FILE_JOB *) arg;
+    TRAP trap;
+
+    /* Die Ausgabedatei haben compress- bzw. decompress_with_options gelöscht */
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        if (job->compress)
+        {
+            compress_with_options(job->in_filename, job->out_filename,
+                                  &job->options);
+        }
+        else
+        {
+            decompress_with_options(job->in_filename, job->out_filename,
+                                    &job->options);
+        }
+    }
+    job->status = trap_clear(&trap);
+    if (job->status != EXIT_SUCCESS)
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n", job->in_filename, trap.message);
+    }
+}
+
+static int decompress_memory(const unsigned char src[], size_t src_size,
+                             unsigned char dst[], size_t dst_capacity,
+                             size_t *dst_size)
+{
+    size_t pos = FILE_MAGIC_LEN + 1;
+    size_t produced = 0;
+    TABLE_HISTORY history;
+    uint32_t raw_size;
+
+    if (src_size < pos || memcmp(src, FILE_MAGIC, FILE_MAGIC_LEN) != 0
+            || src[FILE_MAGIC_LEN] != FORMAT_VERSION)
+    {
+        report_format_error_and_exit(EMSG_INVALID_FILE);
+    }
+
+    history.valid = false;
+    for (;;)
+    {
+        uint32_t payload_size;
+        READER block_in;
+
+        if (src_size - pos < 4)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        raw_size = load_u32(src + pos);
+        if (raw_size == 0)
+        {
+            break;
+        }
+        if (src_size - pos < BLOCK_HEADER_LEN)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        payload_size = load_u32(src + pos + 4);
+        pos += BLOCK_HEADER_LEN;
+        if (payload_size > src_size - pos)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        if (raw_size > dst_capacity - produced)
+        {
+            return EXIT_DST_TOO_SMALL;
+        }
+
+        /* Jeder Block wird direkt an seine Position im Ziel dekodiert */
+        reader_open_memory(&block_in, src + pos, payload_size);
+        decode_block(&block_in, dst + produced, raw_size, &history);
+        pos += payload_size;
+        produced += raw_size;
+    }
+    *dst_size = produced;
+
+    return EXIT_SUCCESS;
+}
+
+static uint64_t decompress_sequential(READER *in, WRITER *out,
+                                      const BLOCK_INDEX *index,
+                                      uint64_t range_start, uint64_t range_end,
+                                      HUFFMAN_STATS *stats)
+{
+    unsigned char *payload = NULL;
+    size_t payload_capacity = 0;
+    unsigned char *data = NULL;
+    size_t data_capacity = 0;
+    uint64_t consumed = 0;
+    uint64_t position = 0;
+    size_t first = find_block(index, range_start);
+    TABLE_HISTORY history;
+    uint32_t raw_size;
+
+    /*
+     * Mit Blockverzeichnis direkt zum ersten benötigten Block springen.
+     * Seine Codetabelle kann er höchstens von den Blöcken seines Auftrags
+     * übernommen haben; deren Tabellen werden mitgelesen.
+     */
+    history.valid = false;
+    first = (first > MAX_SPLIT_PARTS - 1) ? first - (MAX_SPLIT_PARTS - 1) : 0;
+    if (first > 0 && first < index->count)
+    {
+        consumed = index->entries[first].offset - (FILE_MAGIC_LEN + 1);
+        if (!reader_skip(in, consumed))
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        position = index->entries[first].raw_offset;
+    }
+
+    while (position < range_end && (raw_size = read_u32(in)) != 0)
+    {
+        uint32_t payload_size = read_u32(in);
+        double block_seconds[PHASE_COUNT];
+        double *caller_seconds;
+        double task_start;
+        double start;
+        READER block_in;
+        uint32_t skip;
+        uint32_t keep;
+        int phase;
+
+        consumed += BLOCK_HEADER_LEN + (uint64_t) payload_size;
+        if (position + raw_size <= range_start)
+        {
+            /* Block vor dem Bereich: nur seine Codetabelle lesen */
+            unsigned char prefix[TABLE_PREFIX_LEN];
+            uint32_t prefix_size = (payload_size < TABLE_PREFIX_LEN)
+                    ? payload_size : TABLE_PREFIX_LEN;
+
+            if (reader_read(in, prefix, prefix_size) != prefix_size
+                    || !reader_skip(in, payload_size - prefix_size))
+            {
+                report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+            }
+            read_block_table(prefix, prefix_size, &history);
+            position += raw_size;
+            continue;
+        }
+        skip = (range_start > position) ? (uint32_t) (range_start - position) : 0;
+        keep = (range_end - position < raw_size)
+                ? (uint32_t) (range_end - position) - skip : raw_size - skip;
+
+        if (payload_size > payload_capacity)
+        {
+            free_owned(payload);
+            payload = (unsigned char *) allocate_owned(payload_size);
+            payload_capacity = payload_size;
+        }
+        start = phase_start();
+        if (reader_read(in, payload, payload_size) != payload_size)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        phase_stop(PHASE_READ, start);
+
+        if (raw_size > data_capacity)
+        {
+            free_owned(data);
+            data = (unsigned char *) allocate_owned(raw_size);
+            data_capacity = raw_size;
+        }
+
+        /* Der Block wird wie ein Auftrag des Thread-Pools gemessen */
+        task_start = begin_task_timing((stats != NULL) ? block_seconds : NULL,
+                                       &caller_seconds);
+        if (payload_size > 0 && payload[0] == BLOCK_STORED
+                && payload_size - 1 == raw_size)
+        {
+            /* Gespeicherte Blöcke ohne Umweg über data schreiben */
+            start = phase_start();
+            writer_write(out, payload + 1 + skip, keep);
+            phase_stop(PHASE_WRITE, start);
+            history.valid = false;
+        }
+        else
+        {
+            reader_open_memory(&block_in, payload, payload_size);
+            decode_block(&block_in, data, raw_size, &history);
+            start = phase_start();
+            writer_write(out, data + skip, keep);
+            phase_stop(PHASE_WRITE, start);
+        }
+        end_task_timing(task_start, caller_seconds);
+
+        if (stats != NULL)
+        {
+            for (phase = 0; phase < PHASE_COUNT; phase++)
+            {
+                stats->phase_seconds[phase] += block_seconds[phase];
+            }
+            stats->out_bytes += keep;
+            stats->blocks++;
+        }
+        position += raw_size;
+    }
+    free_owned(payload);
+    free_owned(data);
+
+    /* Blockköpfe bzw. Endemarke */
+    return consumed + 4;
+}
+
+static void decompress_parallel(READER *in, WRITER *out,
+                                const BLOCK_INDEX *index,
+                                uint64_t range_start, uint64_t range_end,
+                                int threads, HUFFMAN_STATS *stats)
+{
+    POOL *pool;
+    DECODE_JOB *jobs;
+    size_t first = find_block(index, range_start);
+    size_t count = 0;
+    size_t i;
+
+    /*
+     * Alle Blöcke werden sofort übergeben; jeder Auftrag reserviert seinen
+     * Speicher erst bei der Ausführung, so dass nur so viele Blöcke
+     * gleichzeitig im Speicher liegen, wie Threads vorhanden sind.
+     */
+    while (first + count < index->count
+           && index->entries[first + count].raw_offset < range_end)
+    {
+        count++;
+    }
+    jobs = (DECODE_JOB *) allocate_owned((count > 0 ? count : 1)
+                                         * sizeof (DECODE_JOB));
+    pool = pool_create(threads);
+    for (i = 0; i < count; i++)
+    {
+        const INDEX_ENTRY *entry = &index->entries[first + i];
+        uint64_t block_end = entry->raw_offset + entry->raw_size;
+
+        /* Nur der Teil des Blocks innerhalb des Bereichs wird ausgegeben */
+        jobs[i].in = in;
+        jobs[i].out = out;
+        jobs[i].entry = *entry;
+        jobs[i].index = index;
+        jobs[i].block = first + i;
+        jobs[i].skip = (range_start > entry->raw_offset)
+                ? (uint32_t) (range_start - entry->raw_offset) : 0;
+        jobs[i].keep = (uint32_t) (((block_end < range_end) ? block_end
+                                    : range_end)
+                                   - entry->raw_offset) - jobs[i].skip;
+        jobs[i].out_offset = entry->raw_offset + jobs[i].skip - range_start;
+        jobs[i].timed = (stats != NULL);
+        pool_submit(pool, &jobs[i].job, decompress_block_task, &jobs[i]);
+    }
+    for (i = 0; i < count; i++)
+    {
+        pool_wait(pool, &jobs[i].job);
+        if (stats != NULL)
+        {
+            int phase;
+
+            for (phase = 0; phase < PHASE_COUNT; phase++)
+            {
+                stats->phase_seconds[phase] += jobs[i].phase_seconds[phase];
+            }
+            stats->out_bytes += jobs[i].keep;
+        }
+    }
+    if (stats != NULL)
+    {
+        stats->blocks += count;
+    }
+
+    pool_destroy(pool);
+    free_owned(jobs);
+}
+
+static void decompress_block_task(void *arg)
+{
+    DECODE_JOB *job = (DECODE_JOB *) arg;
+    size_t size = BLOCK_HEADER_LEN + (size_t) job->entry.payload_size;
+    const unsigned char *span;
+    size_t span_size;
+    unsigned char *buffer = NULL;
+    const unsigned char *block;
+    unsigned char *data;
+    READER block_in;
+    TABLE_HISTORY history;
+    double *caller_seconds;
+    double task_start = begin_task_timing(job->timed ? job->phase_seconds
+                                          : NULL, &caller_seconds);
+    double start;
+
+    if (copy_stored_block(job))
+    {
+        end_task_timing(task_start, caller_seconds);
+        return;
+    }
+
+    /* Eingeblendete Dateien direkt lesen, sonst den Block kopieren */
+    start = phase_start();
+    span = reader_span(job->in, &span_size);
+    if (span != NULL)
+    {
+        if (job->entry.offset > span_size
+                || size > span_size - job->entry.offset)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        block = span + job->entry.offset;
+    }
+    else
+    {
+        buffer = (unsigned char *) allocate_owned(size);
+        if (!reader_read_at(job->in, buffer, size, job->entry.offset))
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        block = buffer;
+    }
+    phase_stop(PHASE_READ, start);
+
+    /* Blockkopf muss mit dem Eintrag im Verzeichnis übereinstimmen */
+    reader_open_memory(&block_in, block, size);
+    if (read_u32(&block_in) != job->entry.raw_size
+            || read_u32(&block_in) != job->entry.payload_size)
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+
+    /* Nur ein Verweis auf die vorherige Codetabelle erfordert sie zu lesen */
+    history.valid = false;
+    if (block_table_kind(block + BLOCK_HEADER_LEN, job->entry.payload_size)
+            == TABLE_REUSE)
+    {
+        load_table_history(job, &history);
+    }
+
+    data = (unsigned char *) allocate_owned(job->entry.raw_size);
+    decode_block(&block_in, data, job->entry.raw_size, &history);
+
+    start = phase_start();
+    writer_write_at(job->out, data + job->skip, job->keep, job->out_offset);
+    phase_stop(PHASE_WRITE, start);
+
+    free_owned(data);
+    free_owned(buffer);
+    end_task_timing(task_start, caller_seconds);
+}
+
+static bool copy_stored_block(DECODE_JOB *job)
+{
+    unsigned char header[BLOCK_HEADER_LEN + 1];
+    READER header_in;
+    double start;
+
+    if ((uint64_t) job->entry.payload_size != (uint64_t) job->entry.raw_size + 1
+            || !reader_read_at(job->in, header, sizeof (header),
+                               job->entry.offset)
+            || header[BLOCK_HEADER_LEN] != BLOCK_STORED)
+    {
+        return false;
+    }
+
+    reader_open_memory(&header_in, header, sizeof (header));
+    if (read_u32(&header_in) != job->entry.raw_size
+            || read_u32(&header_in) != job->entry.payload_size)
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+
+    start = phase_start();
+    if (!writer_copy_at(job->out, job->in,
+                        job->entry.offset + sizeof (header) + job->skip,
+                        job->keep, job->out_offset))
+    {
+        report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+    }
+    phase_stop(PHASE_WRITE, start);
+
+    return true;
+}
+
+static void load_table_history(const DECODE_JOB *job, TABLE_HISTORY *history)
+{
+    unsigned char buffer[TABLE_PREFIX_LEN];
+    const unsigned char *span;
+    size_t span_size;
+    size_t block = job->block;
+    int chain;
+
+    /*
+     * Verweise reichen nie über die Blöcke eines Auftrags hinaus, die Kette
+     * ist also kürzer als MAX_SPLIT_PARTS. Von jedem Vorgänger wird nur der
+     * Anfang bis zum Ende seiner Codetabelle gelesen.
+     */
+    span = reader_span(job->in, &span_size);
+    for (chain = 1; chain < MAX_SPLIT_PARTS && block > 0; chain++)
+    {
+        const INDEX_ENTRY *entry = &job->index->entries[--block];
+        size_t size = (entry->payload_size < TABLE_PREFIX_LEN)
+                ? entry->payload_size : TABLE_PREFIX_LEN;
+        uint64_t offset = entry->offset + BLOCK_HEADER_LEN;
+        const unsigned char *prefix = buffer;
+
+        if (span != NULL)
+        {
+            if (offset > span_size || size > span_size - offset)
+            {
+                report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+            }
+            prefix = span + offset;
+        }
+        else if (!reader_read_at(job->in, buffer, size, offset))
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+
+        if (block_table_kind(prefix, size) != TABLE_REUSE)
+        {
+            read_block_table(prefix, size, history);
+            return;
+        }
+    }
+    report_format_error_and_exit(EMSG_INVALID_HEADER);
+}
+
+static int block_table_kind(const unsigned char payload[], size_t size)
+{
+    size_t pos = (size > 0 && payload[0] == BLOCK_CHECKED) ? CHECKSUM_LEN : 0;
+
+    if (size < pos + 2 || (payload[pos] != BLOCK_HUFFMAN
+                           && payload[pos] != BLOCK_HUFFMAN_X4))
+    {
+        return -1;
+    }
+
+    return payload[pos + 1];
+}
+
+static void read_block_table(const unsigned char payload[], size_t size,
+                             TABLE_HISTORY *history)
+{
+    int kind = block_table_kind(payload, size);
+    READER in;
+
+    if (kind < 0)
+    {
+        history->valid = false;
+    }
+    else if (kind != TABLE_REUSE)
+    {
+        /* Art des Blockinhalts und ggf. Prüfsumme überspringen */
+        size_t pos = (payload[0] == BLOCK_CHECKED) ? CHECKSUM_LEN + 1 : 1;
+
+        reader_open_memory(&in, payload + pos, size - pos);
+        read_table(&in, history->lengths, NULL);
+        history->valid = true;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Blockverzeichnis
+ * ------------------------------------------------------------------------- */
+
+static void add_index_entry(BLOCK_INDEX *index, const INDEX_ENTRY *entry)
+{
+    if (index->count == index->capacity)
+    {
+        INDEX_ENTRY *entries;
+
+        index->capacity = (index->capacity > 0) ? 2 * index->capacity : 64;
+        entries = (INDEX_ENTRY *) allocate_owned(index->capacity
+                                                 * sizeof (INDEX_ENTRY));
+        if (index->count > 0)
+        {
+            memcpy(entries, index->entries, index->count * sizeof (INDEX_ENTRY));
+        }
+        free_owned(index->entries);
+        index->entries = entries;
+    }
+    index->entries[index->count++] = *entry;
+}
+
+static void write_index(WRITER *out, const BLOCK_INDEX *index,
+                        uint64_t offset)
+{
+    size_t i;
+
+    for (i = 0; i < index->count; i++)
+    {
+        write_u64(out, index->entries[i].offset);
+        write_u32(out, index->entries[i].raw_size);
+        write_u32(out, index->entries[i].payload_size);
+    }
+    write_u64(out, offset);
+    writer_write(out, (const unsigned char *) INDEX_MAGIC, INDEX_MAGIC_LEN);
+}
+
+static bool read_index(READER *in, BLOCK_INDEX *index)
+{
+    unsigned char trailer[TRAILER_LEN];
+    unsigned char *data;
+    uint64_t file_size;
+    uint64_t offset;
+    uint64_t expected = FILE_MAGIC_LEN + 1;
+    uint64_t raw_offset = 0;
+    size_t count;
+    size_t i;
+    READER index_in;
+
+    index->entries = NULL;
+    index->count = 0;
+
+    if (!reader_size(in, &file_size)
+            || file_size < FILE_MAGIC_LEN + 1 + 4 + TRAILER_LEN
+            || !reader_read_at(in, trailer, TRAILER_LEN,
+                               file_size - TRAILER_LEN)
+            || memcmp(trailer + 8, INDEX_MAGIC, INDEX_MAGIC_LEN) != 0)
+    {
+        return false;
+    }
+
+    reader_open_memory(&index_in, trailer, TRAILER_LEN);
+    offset = read_u64(&index_in);
+    if (offset < FILE_MAGIC_LEN + 1 + 4 || offset > file_size - TRAILER_LEN
+            || (file_size - TRAILER_LEN - offset) % INDEX_ENTRY_LEN != 0)
+    {
+        return false;
+    }
+
+    count = (size_t) ((file_size - TRAILER_LEN - offset) / INDEX_ENTRY_LEN);
+    data = (unsigned char *) allocate_owned(count * INDEX_ENTRY_LEN);
+    if (!reader_read_at(in, data, count * INDEX_ENTRY_LEN, offset))
+    {
+        free_owned(data);
+        return false;
+    }
+
+    /* Die Blöcke müssen lückenlos aufeinander folgen */
+    reader_open_memory(&index_in, data, count * INDEX_ENTRY_LEN);
+    for (i = 0; i < count; i++)
+    {
+        INDEX_ENTRY entry;
+
+        entry.offset = read_u64(&index_in);
+        entry.raw_size = read_u32(&index_in);
+        entry.payload_size = read_u32(&index_in);
+        if (entry.offset != expected || entry.raw_size == 0)
+        {
+            break;
+        }
+        entry.raw_offset = raw_offset;
+        raw_offset += entry.raw_size;
+        expected += BLOCK_HEADER_LEN + (uint64_t) entry.payload_size;
+        add_index_entry(index, &entry);
+    }
+    free_owned(data);
+
+    if (i < count || expected + 4 != offset)
+    {
+        free_owned(index->entries);
+        index->entries = NULL;
+        index->count = 0;
+        return false;
+    }
+
+    return true;
+}
+
+static size_t find_block(const BLOCK_INDEX *index, uint64_t position)
+{
+    size_t low = 0;
+    size_t high = index->count;
+
+    /* erster Block, der hinter position endet */
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        const INDEX_ENTRY *entry = &index->entries[middle];
+
+        if (entry->raw_offset + entry->raw_size <= position)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+/* ----------------------------------------------------------------------------
+ * Messung der Laufzeiten
+ * ------------------------------------------------------------------------- */
+
+static double begin_task_timing(double seconds[], double **caller)
+{
+    *caller = phase_seconds;
+    phase_seconds = seconds;
+    if (seconds == NULL)
+    {
+        return 0.0;
+    }
+    memset(seconds, 0, PHASE_COUNT * sizeof (double));
+
+    return now_seconds();
+}
+
+static void end_task_timing(double start, double *caller)
+{
+    if (phase_seconds != NULL)
+    {
+        double rest = now_seconds() - start;
+        int phase;
+
+        for (phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            rest -= phase_seconds[phase];
+        }
+        phase_seconds[PHASE_CODE] += (rest > 0.0) ? rest : 0.0;
+    }
+    phase_seconds = caller;
+}
+
+static double phase_start(void)
+{
+    if (phase_seconds == NULL || phase_active)
+    {
+        return -1.0;
+    }
+    phase_active = true;
+
+    return now_seconds();
+}
+
+static void phase_stop(HUFFMAN_PHASE phase, double start)
+{
+    if (start >= 0.0)
+    {
+        phase_seconds[phase] += now_seconds() - start;
+        phase_active = false;
+    }
+}
+
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/* ----------------------------------------------------------------------------
+ * Komprimieren und Dekomprimieren eines Blocks
+ * ------------------------------------------------------------------------- */
+
+static void compress_block_task(void *arg)
+{
+    BLOCK_JOB *job = (BLOCK_JOB *) arg;
+    double *caller_seconds;
+    double start = begin_task_timing(job->timed ? job->phase_seconds : NULL,
+                                     &caller_seconds);
+
+    /*
+     * Bereits komprimierte oder verschlüsselte Daten nicht kodieren, es sei
+     * denn, sie wiederholen sich innerhalb des Suchfensters. Fasst der
+     * Auftrag mehrere kleine Blöcke zusammen, entscheidet encode_parts für
+     * jeden einzeln.
+     */
+    job->stored = false;
+    job->output = NULL;
+    if (job->block_size == 0 && is_incompressible(job->input, job->input_size)
+            && !lz77_beats_stored(job->input, job->input_size, &job->level))
+    {
+        store_block(job);
+        end_task_timing(start, caller_seconds);
+        return;
+    }
+
+    if (job->block_size > 0)
+    {
+        /* Mehrere kleine Blöcke: fest in Blöcke der gewählten Größe teilen */
+        size_t pos;
+
+        job->part_count = 0;
+        for (pos = 0; pos < job->input_size; pos += job->block_size)
+        {
+            job->part_raw[job->part_count++] = (uint32_t)
+                    ((job->input_size - pos < job->block_size)
+                     ? job->input_size - pos : job->block_size);
+        }
+    }
+    else
+    {
+        job->part_count = plan_parts(job->input, job->input_size, &job->level,
+                                     job->part_raw);
+    }
+    job->output = encode_parts(job->input, job->part_count, job->part_raw,
+                               job->part_payload, &job->level, job->checksum,
+                               &job->output_size);
+
+    /*
+     * Die Aufteilung wird anhand der Häufigkeiten der Zeichen geschätzt.
+     * Die LZ77-Zerlegung findet im ungeteilten Block weiter zurückliegende
+     * Wiederholungen, deshalb wird er behalten, wenn er kürzer ist.
+     */
+    if (job->part_count > 1 && job->level.lz77.chain_depth > 0
+            && job->block_size == 0)
+    {
+        uint32_t whole_raw = (uint32_t) job->input_size;
+        uint32_t whole_payload;
+        size_t whole_size;
+        unsigned char *whole = encode_parts(job->input, 1, &whole_raw,
+                                            &whole_payload, &job->level,
+                                            job->checksum, &whole_size);
+
+        if (whole_size < job->output_size)
+        {
+            free(job->output);
+            job->output = whole;
+            job->output_size = whole_size;
+            job->part_count = 1;
+            job->part_raw[0] = whole_raw;
+            job->part_payload[0] = whole_payload;
+        }
+        else
+        {
+            free(whole);
+        }
+    }
+
+    /* Die Ausgabe wird nie länger als der gespeicherte Block */
+    if (job->block_size == 0
+            && job->output_size
+               + (size_t) (job->part_count - 1) * BLOCK_HEADER_LEN
+               > job->input_size + (job->checksum ? CHECKSUM_LEN : 0))
+    {
+        store_block(job);
+    }
+    end_task_timing(start, caller_seconds);
+}
+
+static bool is_incompressible(const unsigned char data[], size_t size)
+{
+    uint64_t freq[SYMBOL_COUNT];
+    double bits = 0.0;
+    int i;
+
+    count_frequencies(data, size, freq);
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (freq[i] > 0)
+        {
+            bits -= (double) freq[i] * log2((double) freq[i] / (double) size);
+        }
+    }
+
+    /*
+     * Die Entropie ist die untere Grenze für jede Kodierung der einzelnen
+     * Zeichen. Wiederholungen, die nur die LZ77-Zerlegung findet, prüft
+     * danach lz77_beats_stored.
+     */
+    return bits >= (double) size * 8.0 * (1.0 - 1.0 / STORED_MIN_SAVING);
+}
+
+static void store_block(BLOCK_JOB *job)
+{
+    free(job->output);
+    job->output = NULL;
+    job->output_size = 0;
+    job->stored = true;
+    job->part_count = 1;
+    job->part_raw[0] = (uint32_t) job->input_size;
+    job->part_payload[0] = (uint32_t) job->input_size + 1;
+    if (job->checksum)
+    {
+        job->crc = crc32c_update(0, job->input, job->input_size);
+        job->part_payload[0] += CHECKSUM_LEN;
+    }
+}
+
+static unsigned char *encode_parts(const unsigned char input[], int part_count,
+                                   const uint32_t part_raw[],
+                                   uint32_t part_payload[], const LEVEL *level,
+                                   bool checksum, size_t *size)
+{
+    WRITER out;
+    TABLE_HISTORY history;
+    int part;
+
+    /* Die Teilblöcke werden ohne Blockkopf hintereinander abgelegt */
+    history.valid = false;
+    writer_open_memory(&out);
+    for (part = 0; part < part_count; part++)
+    {
+        size_t stored_size = part_raw[part] + 1
+                + (checksum ? CHECKSUM_LEN : 0);
+        bool stored = is_incompressible(input, part_raw[part])
+                && !lz77_beats_stored(input, part_raw[part], level);
+        size_t before;
+
+        writer_flush_bits(&out);
+        before = writer_memory_size(&out);
+        if (!stored)
+        {
+            if (checksum)
+            {
+                writer_write_char(&out, BLOCK_CHECKED);
+                write_u32(&out, crc32c_update(0, input, part_raw[part]));
+            }
+            encode_block(input, part_raw[part], &out, level, &history);
+            writer_flush_bits(&out);
+            stored = writer_memory_size(&out) - before > stored_size;
+        }
+
+        /* Ein Teilblock wird nie länger als gespeichert */
+        if (stored)
+        {
+            writer_truncate_memory(&out, before);
+            if (checksum)
+            {
+                writer_write_char(&out, BLOCK_CHECKED);
+                write_u32(&out, crc32c_update(0, input, part_raw[part]));
+            }
+            writer_write_char(&out, BLOCK_STORED);
+            writer_write(&out, input, part_raw[part]);
+            history.valid = false;
+        }
+        part_payload[part] = (uint32_t) (writer_memory_size(&out) - before);
+        input += part_raw[part];
+    }
+
+    return writer_close_memory(&out, size);
+}
+
+static void encode_block(const unsigned char data[], size_t size,
+                         WRITER *out, const LEVEL *level,
+                         TABLE_HISTORY *history)
+{
+    if (level->lz77.chain_depth > 0 && size >= MIN_LZ77_SIZE
+        && encode_lz77(data, size, out, level))
+    {
+        if (history != NULL)
+        {
+            history->valid = false;
+        }
+        return;
+    }
+    encode_literals(data, size, out, level, history);
+}
+
+static void encode_literals(const unsigned char data[], size_t size,
+                            WRITER *out, const LEVEL *level,
+                            TABLE_HISTORY *history)
+{
+    uint64_t freq[SYMBOL_COUNT];
+    unsigned char lengths[SYMBOL_COUNT];
+    uint32_t codes[SYMBOL_COUNT];
+    uint64_t huffman_bits;
+    uint64_t reuse_bits;
+    uint64_t tans_bits;
+    uint64_t dictionary_bits;
+    const DICTIONARY *dictionary = level->dictionary;
+    bool reuse = false;
+
+    /* Erster Durchlauf: Häufigkeiten bestimmen */
+    count_frequencies(data, size, freq);
+    build_code_lengths(freq, lengths, level);
+
+    /* Das Verfahren mit der voraussichtlich kürzesten Ausgabe wählen */
+    huffman_bits = huffman_block_bits(freq, lengths);
+    reuse_bits = reuse_block_bits(freq, history);
+    if (reuse_bits <= huffman_bits)
+    {
+        /* Die Tabelle des Vorgängers spart mehr als sie an Bits kostet */
+        memcpy(lengths, history->lengths, SYMBOL_COUNT);
+        huffman_bits = reuse_bits;
+        reuse = true;
+    }
+    if (history != NULL)
+    {
+        history->valid = false;
+    }
+    tans_bits = level->tans ? 8 + tans_estimate_bits(freq) : UINT64_MAX;
+    dictionary_bits = dictionary_block_bits(freq, dictionary);
+    if (level->context && size >= MIN_CONTEXT_SIZE)
+    {
+        CONTEXT_MODEL *model = (CONTEXT_MODEL *) allocate(sizeof (CONTEXT_MODEL));
+        double start = phase_start();
+        uint64_t context_bits = build_context_model(data, size, level, model);
+
+        phase_stop(PHASE_TABLE, start);
+        if (context_bits < huffman_bits && context_bits < tans_bits
+                && context_bits < dictionary_bits)
+        {
+            writer_write_char(out, BLOCK_CONTEXT);
+            encode_context(data, size, out, model);
+            free(model);
+            return;
+        }
+        free(model);
+    }
+    if (tans_bits < huffman_bits && tans_bits < dictionary_bits)
+    {
+        writer_write_char(out, BLOCK_TANS);
+        tans_encode(data, size, freq, out);
+        return;
+    }
+
+    /* Mit dem Wörterbuch entfällt die Codetabelle */
+    if (dictionary_bits < huffman_bits)
+    {
+        writer_write_char(out, BLOCK_DICTIONARY);
+        write_u32(out, dictionary->id);
+        if (size >= MIN_INTERLEAVED_SIZE)
+        {
+            encode_interleaved(data, size, out, dictionary->lengths,
+                               dictionary->codes);
+        }
+        else
+        {
+            encode_symbols(data, size, out, dictionary->lengths,
+                           dictionary->codes);
+        }
+        return;
+    }
+    assign_canonical_codes(lengths, codes);
+    if (history != NULL)
+    {
+        history->valid = true;
+        memcpy(history->lengths, lengths, SYMBOL_COUNT);
+    }
+
+    /* Zweiter Durchlauf: Codetabelle und kodierte Zeichen schreiben */
+    writer_write_char(out, (size >= MIN_INTERLEAVED_SIZE) ? BLOCK_HUFFMAN_X4
+                      : BLOCK_HUFFMAN);
+    if (reuse)
+    {
+        writer_write_char(out, TABLE_REUSE);
+    }
+    else
+    {
+        write_table(out, lengths);
+    }
+    if (size >= MIN_INTERLEAVED_SIZE)
+    {
+        encode_interleaved(data, size, out, lengths, codes);
+    }
+    else
+    {
+        encode_symbols(data, size, out, lengths, codes);
+    }
+}
+
+static void decode_block(READER *in, unsigned char dst[], uint32_t size,
+                         TABLE_HISTORY *history)
+{
+    unsigned char lengths[SYMBOL_COUNT];
+    BIT_STREAM streams[STREAM_COUNT];
+    size_t stream_size[STREAM_COUNT];
+    size_t remaining;
+    const unsigned char *data;
+    const DICTIONARY *dictionary = NULL;
+    DECODE_TABLE table;
+    int stream_count;
+    int mode;
+    int k;
+
+    mode = read_header_char(in);
+    if (mode == BLOCK_CHECKED)
+    {
+        uint32_t crc = read_u32(in);
+        READER section;
+
+        /* Geprüfte Blockinhalte werden nicht verschachtelt */
+        data = reader_take_rest(in, &remaining);
+        if (remaining == 0 || data[0] == BLOCK_CHECKED)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+        reader_open_memory(&section, data, remaining);
+        decode_block(&section, dst, size, history);
+        if (crc32c_update(0, dst, size) != crc)
+        {
+            report_format_error_and_exit(EMSG_CHECKSUM);
+        }
+        return;
+    }
+
+    /* Nur Huffman-Blockinhalte hinterlassen eine Tabelle für den nächsten */
+    if (history != NULL && mode != BLOCK_HUFFMAN && mode != BLOCK_HUFFMAN_X4)
+    {
+        history->valid = false;
+    }
+    if (mode == BLOCK_STORED)
+    {
+        data = reader_take_rest(in, &remaining);
+        if (remaining != size)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+        memcpy(dst, data, size);
+        return;
+    }
+    if (mode == BLOCK_TANS)
+    {
+        data = reader_take_rest(in, &remaining);
+        if (!tans_decode(data, remaining, dst, size))
+        {
+            report_format_error_and_exit(EMSG_INVALID_CODE);
+        }
+        return;
+    }
+    if (mode == BLOCK_CONTEXT)
+    {
+        decode_context(in, dst, size);
+        return;
+    }
+    if (mode == BLOCK_LZ77)
+    {
+        decode_lz77(in, dst, size);
+        return;
+    }
+    if (mode == BLOCK_DICTIONARY)
+    {
+        /* Die Dekodiertabelle wurde beim Laden des Wörterbuchs erstellt */
+        dictionary = find_dictionary(read_u32(in));
+        if (dictionary == NULL)
+        {
+            report_format_error_and_exit(EMSG_MISSING_DICTIONARY);
+        }
+        stream_count = (size >= MIN_INTERLEAVED_SIZE) ? STREAM_COUNT : 1;
+    }
+    else if (mode == BLOCK_HUFFMAN || mode == BLOCK_HUFFMAN_X4)
+    {
+        read_table(in, lengths, history);
+        stream_count = (mode == BLOCK_HUFFMAN_X4) ? STREAM_COUNT : 1;
+        if (history != NULL)
+        {
+            history->valid = true;
+            memcpy(history->lengths, lengths, SYMBOL_COUNT);
+        }
+    }
+    else
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+
+    /* Längen der Bitströme: aus der Sprungtabelle, der letzte bis zum Ende */
+    for (k = 0; k < stream_count - 1; k++)
+    {
+        stream_size[k] = read_u32(in);
+    }
+    data = reader_take_rest(in, &remaining);
+    for (k = 0; k < stream_count; k++)
+    {
+        if (k == stream_count - 1)
+        {
+            stream_size[k] = remaining;
+        }
+        else if (stream_size[k] > remaining)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        stream_open(&streams[k], data, stream_size[k]);
+        data += stream_size[k];
+        remaining -= stream_size[k];
+    }
+
+    if (dictionary != NULL)
+    {
+        decode_streams(&dictionary->table, streams, stream_count, dst, size);
+        return;
+    }
+    build_decode_table(lengths, &table);
+    decode_streams(&table, streams, stream_count, dst, size);
+    free_decode_table(&table);
+}
+
+/* ----------------------------------------------------------------------------
+ * Aufbau des Codes
+ * ------------------------------------------------------------------------- */
+
+static void count_frequencies(const unsigned char data[], size_t size,
+                              uint64_t freq[])
+{
+    double start = phase_start();
+
+    histogram_count(data, size, freq);
+    phase_stop(PHASE_HISTOGRAM, start);
+}
+
+static int plan_parts(const unsigned char data[], size_t size,
+                      const LEVEL *level, uint32_t part_raw[])
+{
+    uint64_t freq[MAX_SPLIT_PARTS][SYMBOL_COUNT];
+    size_t leaf_size[MAX_SPLIT_PARTS];
+    int leaves = 1 << level->split_depth;
+    int part_count = 0;
+    int i;
+
+    /* Teilblöcke nicht kleiner als MIN_SPLIT_SIZE werden lassen */
+    while (leaves > 1 && size / (size_t) leaves < MIN_SPLIT_SIZE)
+    {
+        leaves /= 2;
+    }
+    if (leaves == 1)
+    {
+        part_raw[0] = (uint32_t) size;
+        return 1;
+    }
+
+    for (i = 0; i < leaves; i++)
+    {
+        leaf_size[i] = (i < leaves - 1)
+                ? size / (size_t) leaves
+                : size - (size_t) (leaves - 1) * (size / (size_t) leaves);
+        count_frequencies(data, leaf_size[i], freq[i]);
+        data += leaf_size[i];
+    }
+    (void) choose_parts(freq, leaf_size, 0, leaves, level, part_raw,
+                        &part_count);
+
+    return part_count;
+}
+
+static uint64_t choose_parts(const uint64_t freq[][SYMBOL_COUNT],
+                             const size_t leaf_size[], int first, int count,
+                             const LEVEL *level, uint32_t part_raw[],
+                             int *part_count)
+{
+    uint64_t merged[SYMBOL_COUNT] = {0};
+    uint64_t whole_bits;
+    size_t size = 0;
+    int i;
+    int k;
+
+    for (k = first; k < first + count; k++)
+    {
+        for (i = 0; i < SYMBOL_COUNT; i++)
+        {
+            merged[i] += freq[k][i];
+        }
+        size += leaf_size[k];
+    }
+    whole_bits = estimate_block_bits(merged, level);
+
+    if (count > 1)
+    {
+        uint32_t split_raw[MAX_SPLIT_PARTS];
+        int split_count = 0;
+        uint64_t split_bits;
+
+        split_bits = choose_parts(freq, leaf_size, first, count / 2, level,
+                                  split_raw, &split_count);
+        split_bits += choose_parts(freq, leaf_size, first + count / 2,
+                                   count - count / 2, level,
+                                   split_raw, &split_count);
+        if (split_bits < whole_bits)
+        {
+            for (i = 0; i < split_count; i++)
+            {
+                part_raw[(*part_count)++] = split_raw[i];
+            }
+            return split_bits;
+        }
+    }
+
+    part_raw[(*part_count)++] = (uint32_t) size;
+    return whole_bits;
+}
+
+static uint64_t estimate_block_bits(const uint64_t freq[], const LEVEL *level)
+{
+    unsigned char lengths[SYMBOL_COUNT];
+    uint64_t bits;
+    uint64_t dictionary_bits;
+
+    build_code_lengths(freq, lengths, level);
+    bits = huffman_block_bits(freq, lengths);
+    if (level->tans)
+    {
+        uint64_t tans_bits = 8 + tans_estimate_bits(freq);
+
+        bits = (tans_bits < bits) ? tans_bits : bits;
+    }
+    dictionary_bits = dictionary_block_bits(freq, level->dictionary);
+    bits = (dictionary_bits < bits) ? dictionary_bits : bits;
+
+    return 8 * BLOCK_HEADER_LEN + bits;
+}
+
+static uint64_t huffman_block_bits(const uint64_t freq[],
+                                   const unsigned char lengths[])
+{
+    /* Art des Blockinhalts und Codetabelle */
+    uint64_t bits = 8 * (1 + table_size(lengths));
+    uint64_t size = 0;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        bits += freq[i] * lengths[i];
+        size += freq[i];
+    }
+    if (size >= MIN_INTERLEAVED_SIZE)
+    {
+        bits += 8 * JUMP_TABLE_LEN;
+    }
+
+    return bits;
+}
+
+static uint64_t reuse_block_bits(const uint64_t freq[],
+                                 const TABLE_HISTORY *history)
+{
+    /* Art des Blockinhalts und Verweis auf die vorherige Codetabelle */
+    uint64_t bits = 8 * 2;
+    uint64_t size = 0;
+    int i;
+
+    if (history == NULL || !history->valid)
+    {
+        return UINT64_MAX;
+    }
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (freq[i] > 0 && history->lengths[i] == 0)
+        {
+            return UINT64_MAX;
+        }
+        bits += freq[i] * history->lengths[i];
+        size += freq[i];
+    }
+    if (size >= MIN_INTERLEAVED_SIZE)
+    {
+        bits += 8 * JUMP_TABLE_LEN;
+    }
+
+    return bits;
+}
+
+static uint64_t dictionary_block_bits(const uint64_t freq[],
+                                      const DICTIONARY *dictionary)
+{
+    /* Art des Blockinhalts und Kennung des Wörterbuchs */
+    uint64_t bits = 8 * DICTIONARY_REF_LEN;
+    uint64_t size = 0;
+    int i;
+
+    if (dictionary == NULL)
+    {
+        return UINT64_MAX;
+    }
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        bits += freq[i] * dictionary->lengths[i];
+        size += freq[i];
+    }
+    if (size >= MIN_INTERLEAVED_SIZE)
+    {
+        bits += 8 * JUMP_TABLE_LEN;
+    }
+
+    return bits;
+}
+
+static const DICTIONARY *find_dictionary(uint32_t id)
+{
+    int i;
+
+    for (i = 0; i < dictionary_count; i++)
+    {
+        if (dictionaries[i]->id == id)
+        {
+            return dictionaries[i];
+        }
+    }
+
+    return NULL;
+}
+
+static uint32_t dictionary_id(const unsigned char lengths[])
+{
+    uint32_t id = crc32c_update(0, lengths, SYMBOL_COUNT);
+
+    return (id != 0) ? id : 1;
+}
+
+static void build_code_lengths(const uint64_t freq[], unsigned char lengths[],
+                               const LEVEL *level)
+{
+    double start = phase_start();
+
+    if (level->optimal)
+    {
+        build_optimal_lengths(freq, lengths, level->max_code_len);
+    }
+    else
+    {
+        build_scaled_lengths(freq, lengths, level->max_code_len);
+    }
+    phase_stop(PHASE_TABLE, start);
+}
+
+static void build_scaled_lengths(const uint64_t freq[], unsigned char lengths[],
+                                 int max_len)
+{
+    uint64_t scaled[SYMBOL_COUNT];
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        scaled[i] = freq[i];
+    }
+
+    /*
+     * Zu lange Codewörter entstehen nur bei extrem ungleichen Häufigkeiten.
+     * Halbieren (ohne vorkommende Symbole auf 0 fallen zu lassen) glättet
+     * die Verteilung, bis alle Codewörter in max_len passen.
+     */
+    while (build_huffman_lengths(scaled, lengths) > max_len)
+    {
+        for (i = 0; i < SYMBOL_COUNT; i++)
+        {
+            if (scaled[i] > 0)
+            {
+                scaled[i] = (scaled[i] >> 1) | 1;
+            }
+        }
+    }
+}
+
+static void build_optimal_lengths(const uint64_t freq[], unsigned char lengths[],
+                                  int max_len)
+{
+    /* Symbole aufsteigend nach Häufigkeit sortiert */
+    int symbols[SYMBOL_COUNT];
+    uint64_t leaf_weight[SYMBOL_COUNT];
+
+    /* Gewichte der aktuellen und der vorherigen Liste */
+    uint64_t weight[2][2 * SYMBOL_COUNT];
+
+    /* Je Liste und Position: Paket (true) oder Blatt (false) */
+    bool is_package[MAX_CODE_LEN][2 * SYMBOL_COUNT];
+    int list_len = 0;
+    int n = 0;
+    int take;
+    int depth;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        lengths[i] = 0;
+        if (freq[i] > 0)
+        {
+            /* Einfügen sortiert nach Häufigkeit, bei Gleichheit nach Symbol */
+            int pos = n++;
+            while (pos > 0 && leaf_weight[pos - 1] > freq[i])
+            {
+                leaf_weight[pos] = leaf_weight[pos - 1];
+                symbols[pos] = symbols[pos - 1];
+                pos--;
+            }
+            leaf_weight[pos] = freq[i];
+            symbols[pos] = i;
+        }
+    }
+
+    if (n == 0)
+    {
+        return;
+    }
+    if (n == 1)
+    {
+        lengths[symbols[0]] = 1;
+        return;
+    }
+
+    /*
+     * Liste 0 gehört zur größten Codelänge und enthält nur die Blätter.
+     * Jede weitere Liste entsteht, indem die Elemente der vorherigen Liste
+     * paarweise zu Paketen zusammengefasst und mit den Blättern sortiert
+     * zusammengeführt werden.
+     */
+    for (i = 0; i < n; i++)
+    {
+        weight[0][i] = leaf_weight[i];
+        is_package[0][i] = false;
+    }
+    list_len = n;
+
+    for (depth = 1; depth < max_len; depth++)
+    {
+        const uint64_t *prev = weight[(depth - 1) & 1];
+        uint64_t *curr = weight[depth & 1];
+        int packages = list_len / 2;
+        int leaf = 0;
+        int package = 0;
+
+        list_len = 0;
+        while (leaf < n || package < packages)
+        {
+            uint64_t package_weight = (package < packages)
+                    ? prev[2 * package] + prev[2 * package + 1] : 0;
+
+            if (package >= packages
+                    || (leaf < n && leaf_weight[leaf] <= package_weight))
+            {
+                curr[list_len] = leaf_weight[leaf++];
+                is_package[depth][list_len] = false;
+            }
+            else
+            {
+                curr[list_len] = package_weight;
+                is_package[depth][list_len] = true;
+                package++;
+            }
+            list_len++;
+        }
+    }
+
+    /*
+     * Aus der letzten Liste werden die ersten 2n-2 Elemente gewählt. Jedes
+     * gewählte Blatt verlängert das Codewort seines Symbols um ein Bit,
+     * jedes gewählte Paket wählt zwei Elemente der vorherigen Liste. Die
+     * gewählten Blätter einer Liste sind stets die leichtesten.
+     */
+    take = 2 * n - 2;
+    for (depth = max_len - 1; depth >= 0; depth--)
+    {
+        int packages = 0;
+        int leaves = 0;
+
+        for (i = 0; i < take; i++)
+        {
+            if (is_package[depth][i])
+            {
+                packages++;
+            }
+            else
+            {
+                lengths[symbols[leaves++]]++;
+            }
+        }
+        take = 2 * packages;
+    }
+}
+
+static int build_huffman_lengths(const uint64_t freq[], unsigned char lengths[])
+{
+    /* Knoten 0..255 sind die Blätter, danach folgen die inneren Knoten */
+    uint64_t weight[2 * SYMBOL_COUNT];
+    int parent[2 * SYMBOL_COUNT];
+    int depth[2 * SYMBOL_COUNT];
+    int heap[SYMBOL_COUNT];
+    int heap_size = 0;
+    int node_count = SYMBOL_COUNT;
+    int max_len = 0;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        lengths[i] = 0;
+        if (freq[i] > 0)
+        {
+            weight[i] = freq[i];
+            heap[heap_size++] = i;
+        }
+    }
+
+    if (heap_size == 0)
+    {
+        return 0;
+    }
+    if (heap_size == 1)
+    {
+        /* Auch ein einzelnes Symbol benötigt ein Codewort */
+        lengths[heap[0]] = 1;
+        return 1;
+    }
+
+    /*
+     * Min-Heap über die Gewichte; bei gleichem Gewicht entscheidet die
+     * Knotennummer, damit der Code eindeutig bestimmt ist.
+     */
+#define HEAP_LESS(A, B) (weight[A] < weight[B] \
+                         || (weight[A] == weight[B] && (A) < (B)))
+
+    for (i = heap_size / 2 - 1; i >= 0; i--)
+    {
+        int pos = i;
+        int child;
+        while ((child = 2 * pos + 1) < heap_size)
+        {
+            if (child + 1 < heap_size && HEAP_LESS(heap[child + 1], heap[child]))
+            {
+                child++;
+            }
+            if (!HEAP_LESS(heap[child], heap[pos]))
+            {
+                break;
+            }
+            int tmp = heap[pos];
+            heap[pos] = heap[child];
+            heap[child] = tmp;
+            pos = child;
+        }
+    }
+
+    while (heap_size > 1)
+    {
+        int nodes[2];
+        int k;
+
+        /* Die beiden leichtesten Knoten entnehmen */
+        for (k = 0; k < 2; k++)
+        {
+            int pos = 0;
+            int child;
+
+            nodes[k] = heap[0];
+            heap[0] = heap[--heap_size];
+            while ((child = 2 * pos + 1) < heap_size)
+            {
+                if (child + 1 < heap_size
+                        && HEAP_LESS(heap[child + 1], heap[child]))
+                {
+                    child++;
+                }
+                if (!HEAP_LESS(heap[child], heap[pos]))
+                {
+                    break;
+                }
+                int tmp = heap[pos];
+                heap[pos] = heap[child];
+                heap[child] = tmp;
+                pos = child;
+            }
+        }
+
+        /* Neuen inneren Knoten einfügen */
+        weight[node_count] = weight[nodes[0]] + weight[nodes[1]];
+        parent[nodes[0]] = node_count;
+        parent[nodes[1]] = node_count;
+
+        int pos = heap_size++;
+        heap[pos] = node_count;
+        while (pos > 0 && HEAP_LESS(heap[pos], heap[(pos - 1) / 2]))
+        {
+            int tmp = heap[pos];
+            heap[pos] = heap[(pos - 1) / 2];
+            heap[(pos - 1) / 2] = tmp;
+            pos = (pos - 1) / 2;
+        }
+        node_count++;
+    }
+#undef HEAP_LESS
+
+    /* Tiefen von der Wurzel abwärts bestimmen; Eltern haben höhere Nummern */
+    depth[node_count - 1] = 0;
+    for (i = node_count - 2; i >= SYMBOL_COUNT; i--)
+    {
+        depth[i] = depth[parent[i]] + 1;
+    }
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (freq[i] > 0)
+        {
+            depth[i] = depth[parent[i]] + 1;
+            lengths[i] = (unsigned char) (depth[i] > 255 ? 255 : depth[i]);
+            if (depth[i] > max_len)
+            {
+                max_len = depth[i];
+            }
+        }
+    }
+
+    return max_len;
+}
+
+static void assign_canonical_codes(const unsigned char lengths[],
+                                   uint32_t codes[])
+{
+    uint32_t count[MAX_CODE_LEN + 1] = {0};
+    uint32_t next_code[MAX_CODE_LEN + 1];
+    uint32_t code = 0;
+    int len;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        count[lengths[i]]++;
+    }
+    count[0] = 0;
+
+    /* Erstes Codewort je Länge (wie in RFC 1951, Abschnitt 3.2.2) */
+    for (len = 1; len <= MAX_CODE_LEN; len++)
+    {
+        code = (code + count[len - 1]) << 1;
+        next_code[len] = code;
+    }
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        codes[i] = (lengths[i] != 0) ? next_code[lengths[i]]++ : 0;
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Codetabelle
+ * ------------------------------------------------------------------------- */
+
+static void write_table(WRITER *out, const unsigned char lengths[])
+{
+    RLE_TABLE rle;
+    uint32_t codes[SYMBOL_COUNT];
+    int used = 0;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        used += lengths[i] != 0;
+    }
+    build_rle_table(lengths, &rle);
+
+    if (used > MAX_SPARSE_SYMBOLS || rle.size < (size_t) (1 + 2 * used))
+    {
+        /* Letztes Symbol, Codelängen des Hilfscodes, dann die Läufe */
+        writer_write_char(out, TABLE_RLE);
+        writer_write_char(out, (unsigned char) rle.last);
+        for (i = 0; i < RLE_SYMBOL_COUNT; i++)
+        {
+            writer_write_bits(out, rle.lengths[i], RLE_LENGTH_BITS);
+        }
+        assign_canonical_codes(rle.lengths, codes);
+        for (i = 0; i < rle.count; i++)
+        {
+            int symbol = rle.symbols[i];
+
+            writer_write_bits(out, codes[symbol], rle.lengths[symbol]);
+            if (rle_extra_bits(symbol) > 0)
+            {
+                writer_write_bits(out, rle.extra[i], rle_extra_bits(symbol));
+            }
+        }
+        writer_flush_bits(out);
+        return;
+    }
+
+    /* Anzahl der vorkommenden Symbole (minus 1), dann Paare Symbol/Länge */
+    writer_write_char(out, (unsigned char) (used - 1));
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (lengths[i] != 0)
+        {
+            writer_write_char(out, (unsigned char) i);
+            writer_write_char(out, lengths[i]);
+        }
+    }
+}
+
+static size_t table_size(const unsigned char lengths[])
+{
+    RLE_TABLE rle;
+    int used = 0;
+    int i;
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        used += lengths[i] != 0;
+    }
+    build_rle_table(lengths, &rle);
+
+    return (used > MAX_SPARSE_SYMBOLS || rle.size < (size_t) (1 + 2 * used))
+            ? rle.size : (size_t) (1 + 2 * used);
+}
+
+static void build_rle_table(const unsigned char lengths[], RLE_TABLE *rle)
+{
+    uint64_t freq[SYMBOL_COUNT] = {0};
+    uint64_t bits = RLE_SYMBOL_COUNT * RLE_LENGTH_BITS;
+    int run;
+    int i;
+
+    rle->last = SYMBOL_COUNT - 1;
+    while (rle->last > 0 && lengths[rle->last] == 0)
+    {
+        rle->last--;
+    }
+
+    /*
+     * Jeder Lauf gleicher Längen wird in Symbole zerlegt: Läufe von Nullen
+     * direkt, sonst die Länge und danach Wiederholungen der vorherigen.
+     * Reste unter drei werden einzeln geschrieben.
+     */
+    rle->count = 0;
+    for (i = 0; i <= rle->last; i += run)
+    {
+        int len = lengths[i];
+        int remaining;
+
+        run = 1;
+        while (i + run <= rle->last && lengths[i + run] == len)
+        {
+            run++;
+        }
+        remaining = run;
+        if (len == 0)
+        {
+            while (remaining >= 11)
+            {
+                int n = (remaining < 138) ? remaining : 138;
+
+                rle->symbols[rle->count] = RLE_LONG_ZEROS;
+                rle->extra[rle->count++] = (unsigned char) (n - 11);
+                remaining -= n;
+            }
+            if (remaining >= 3)
+            {
+                rle->symbols[rle->count] = RLE_ZEROS;
+                rle->extra[rle->count++] = (unsigned char) (remaining - 3);
+                remaining = 0;
+            }
+        }
+        else
+        {
+            rle->symbols[rle->count] = (unsigned char) len;
+            rle->extra[rle->count++] = 0;
+            remaining--;
+            while (remaining >= 3)
+            {
+                int n = (remaining < 6) ? remaining : 6;
+
+                rle->symbols[rle->count] = RLE_REPEAT;
+                rle->extra[rle->count++] = (unsigned char) (n - 3);
+                remaining -= n;
+            }
+        }
+        for (; remaining > 0; remaining--)
+        {
+            rle->symbols[rle->count] = (unsigned char) len;
+            rle->extra[rle->count++] = 0;
+        }
+    }
+
+    for (i = 0; i < rle->count; i++)
+    {
+        freq[rle->symbols[i]]++;
+        bits += (uint64_t) rle_extra_bits(rle->symbols[i]);
+    }
+    build_optimal_lengths(freq, rle->lengths, RLE_MAX_CODE_LEN);
+    for (i = 0; i < RLE_SYMBOL_COUNT; i++)
+    {
+        bits += freq[i] * rle->lengths[i];
+    }
+
+    /* Art der Tabelle und letztes Symbol, dann die Bits */
+    rle->size = 2 + (size_t) ((bits + 7) / 8);
+}
+
+static void read_table(READER *in, unsigned char lengths[],
+                       const TABLE_HISTORY *history)
+{
+    uint64_t kraft = 0;
+    int kind;
+    int used = 0;
+    int i;
+
+    kind = read_header_char(in);
+    if (kind == TABLE_REUSE)
+    {
+        /* Die Tabelle des vorherigen Blocks wurde bereits geprüft */
+        if (history == NULL || !history->valid)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+        memcpy(lengths, history->lengths, SYMBOL_COUNT);
+        return;
+    }
+
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        lengths[i] = 0;
+    }
+    if (kind == TABLE_RLE)
+    {
+        read_rle_table(in, lengths);
+    }
+    else if (kind < MAX_SPARSE_SYMBOLS)
+    {
+        for (i = 0; i <= kind; i++)
+        {
+            unsigned char symbol = read_header_char(in);
+            unsigned char len = read_header_char(in);
+
+            if (len == 0 || len > MAX_CODE_LEN || lengths[symbol] != 0)
+            {
+                report_format_error_and_exit(EMSG_INVALID_HEADER);
+            }
+            lengths[symbol] = len;
+        }
+    }
+    else
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+
+    /* Die Codelängen müssen einen Präfixcode ergeben (Kraft-Ungleichung) */
+    for (i = 0; i < SYMBOL_COUNT; i++)
+    {
+        if (lengths[i] != 0)
+        {
+            used++;
+            kraft += (uint64_t) 1 << (MAX_CODE_LEN - lengths[i]);
+        }
+    }
+    if (used == 0 || kraft > (uint64_t) 1 << MAX_CODE_LEN)
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+}
+
+static void read_rle_table(READER *in, unsigned char lengths[])
+{
+    TABLE_READER reader;
+    unsigned char rle_lengths[RLE_SYMBOL_COUNT];
+    int count[RLE_MAX_CODE_LEN + 1] = {0};
+    int next[RLE_MAX_CODE_LEN + 1];
+    int sorted[RLE_SYMBOL_COUNT];
+    uint32_t kraft = 0;
+    int last = read_header_char(in);
+    int previous = -1;
+    int pos = 0;
+    int len;
+    int i;
+
+    reader.in = in;
+    reader.bits = 0;
+    reader.count = 0;
+
+    /* Codelängen des Hilfscodes lesen und kanonisch sortieren */
+    for (i = 0; i < RLE_SYMBOL_COUNT; i++)
+    {
+        rle_lengths[i] = (unsigned char) read_table_bits(&reader,
+                                                         RLE_LENGTH_BITS);
+        count[rle_lengths[i]]++;
+        if (rle_lengths[i] != 0)
+        {
+            kraft += (uint32_t) 1 << (RLE_MAX_CODE_LEN - rle_lengths[i]);
+        }
+    }
+    if (count[0] == RLE_SYMBOL_COUNT
+            || kraft > (uint32_t) 1 << RLE_MAX_CODE_LEN)
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+    next[1] = 0;
+    for (len = 2; len <= RLE_MAX_CODE_LEN; len++)
+    {
+        next[len] = next[len - 1] + count[len - 1];
+    }
+    for (i = 0; i < RLE_SYMBOL_COUNT; i++)
+    {
+        if (rle_lengths[i] != 0)
+        {
+            sorted[next[rle_lengths[i]]++] = i;
+        }
+    }
+
+    /* Läufe dürfen nicht über das letzte Symbol hinausreichen */
+    while (pos <= last)
+    {
+        int symbol = read_rle_symbol(&reader, count, sorted);
+        int run;
+
+        if (symbol <= MAX_CODE_LEN)
+        {
+            lengths[pos++] = (unsigned char) symbol;
+            previous = symbol;
+            continue;
+        }
+        if (symbol == RLE_REPEAT)
+        {
+            if (previous < 0)
+            {
+                report_format_error_and_exit(EMSG_INVALID_HEADER);
+            }
+            run = 3 + (int) read_table_bits(&reader, 2);
+        }
+        else
+        {
+            previous = 0;
+            run = (symbol == RLE_ZEROS) ? 3 + (int) read_table_bits(&reader, 3)
+                    : 11 + (int) read_table_bits(&reader, 7);
+        }
+        if (run > last + 1 - pos)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+        memset(lengths + pos, previous, (size_t) run);
+        pos += run;
+    }
+}
+
+static int read_rle_symbol(TABLE_READER *reader, const int count[],
+                           const int sorted[])
+{
+    int code = 0;
+    int first = 0;
+    int index = 0;
+    int len;
+
+    /* Kanonische Codewörter einer Länge sind aufeinanderfolgende Zahlen */
+    for (len = 1; len <= RLE_MAX_CODE_LEN; len++)
+    {
+        code |= (int) read_table_bits(reader, 1);
+        if (code - first < count[len])
+        {
+            return sorted[index + code - first];
+        }
+        index += count[len];
+        first = (first + count[len]) << 1;
+        code <<= 1;
+    }
+    report_format_error_and_exit(EMSG_INVALID_HEADER);
+
+    return 0;
+}
+
+static uint32_t read_table_bits(TABLE_READER *reader, int n)
+{
+    while (reader->count < n)
+    {
+        reader->bits = (reader->bits << 8) | read_header_char(reader->in);
+        reader->count += 8;
+    }
+    reader->count -= n;
+
+    return (reader->bits >> reader->count) & (((uint32_t) 1 << n) - 1);
+}
+
+static int rle_extra_bits(int symbol)
+{
+    return (symbol == RLE_REPEAT) ? 2 : (symbol == RLE_ZEROS) ? 3
+            : (symbol == RLE_LONG_ZEROS) ? 7 : 0;
+}
+
+static void write_u32(WRITER *out, uint32_t value)
+{
+    writer_write_char(out, (unsigned char) (value >> 24));
+    writer_write_char(out, (unsigned char) (value >> 16));
+    writer_write_char(out, (unsigned char) (value >> 8));
+    writer_write_char(out, (unsigned char) value);
+}
+
+static uint32_t read_u32(READER *in)
+{
+    uint32_t value = 0;
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        value = (value << 8) | read_header_char(in);
+    }
+
+    return value;
+}
+
+static void write_u64(WRITER *out, uint64_t value)
+{
+    write_u32(out, (uint32_t) (value >> 32));
+    write_u32(out, (uint32_t) value);
+}
+
+static uint64_t read_u64(READER *in)
+{
+    uint64_t high = read_u32(in);
+
+    return (high << 32) | read_u32(in);
+}
+
+static unsigned char read_header_char(READER *in)
+{
+    if (!reader_has_next_char(in))
+    {
+        report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+    }
+    return reader_read_char(in);
+}
+
+/* ----------------------------------------------------------------------------
+ * Kodieren und Dekodieren
+ * ------------------------------------------------------------------------- */
+
+static void encode_symbols(const unsigned char data[], size_t size,
+                           WRITER *out, const unsigned char lengths[],
+                           const uint32_t codes[])
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        writer_write_bits(out, codes[data[i]], lengths[data[i]]);
+    }
+
+    writer_flush_bits(out);
+}
+
+static void encode_interleaved(const unsigned char data[], size_t size,
+                               WRITER *out, const unsigned char lengths[],
+                               const uint32_t codes[])
+{
+    WRITER streams[STREAM_COUNT];
+    unsigned char *stream_data[STREAM_COUNT];
+    size_t stream_size[STREAM_COUNT];
+    size_t i;
+    int k;
+
+    for (k = 0; k < STREAM_COUNT; k++)
+    {
+        writer_open_memory(&streams[k]);
+    }
+    for (i = 0; i + STREAM_COUNT <= size; i += STREAM_COUNT)
+    {
+        for (k = 0; k < STREAM_COUNT; k++)
+        {
+            writer_write_bits(&streams[k], codes[data[i + k]],
+                              lengths[data[i + k]]);
+        }
+    }
+    for (k = 0; i < size; i++, k++)
+    {
+        writer_write_bits(&streams[k], codes[data[i]], lengths[data[i]]);
+    }
+
+    /* Sprungtabelle, dann die Bitströme hintereinander */
+    for (k = 0; k < STREAM_COUNT; k++)
+    {
+        stream_data[k] = writer_close_memory(&streams[k], &stream_size[k]);
+    }
+    for (k = 0; k < STREAM_COUNT - 1; k++)
+    {
+        write_u32(out, (uint32_t) stream_size[k]);
+    }
+    for (k = 0; k < STREAM_COUNT; k++)
+    {
+        writer_write(out, stream_data[k], stream_size[k]);
+        free(stream_data[k]);
+    }
+}
+
+static void build_decode_table(const unsigned char lengths[],
+                               DECODE_TABLE *table)
+{
+    uint32_t codes[SYMBOL_COUNT];
+    uint32_t single[1 << DECODE_TABLE_BITS];
+    unsigned char sub_bits[1 << DECODE_TABLE_BITS] = {0};
+    uint32_t sub_offset[1 << DECODE_TABLE_BITS];
+    uint32_t sub_size = 0;
+    uint32_t i;
+    int s;
+    double start = phase_start();
+
+    assign_canonical_codes(lengths, codes);
+
+    /* Einträge mit je einem Symbol; ungültige Codewörter bleiben 0 */
+    for (i = 0; i < (1 << DECODE_TABLE_BITS); i++)
+    {
+        single[i] = 0;
+    }
+    for (s = 0; s < SYMBOL_COUNT; s++)
+    {
+        int len = lengths[s];
+
+        if (len == 0)
+        {
+            continue;
+        }
+        if (len <= DECODE_TABLE_BITS)
+        {
+            /* Alle Indizes mit dem Codewort als Präfix */
+            uint32_t first = codes[s] << (DECODE_TABLE_BITS - len);
+            uint32_t last = first + ((uint32_t) 1 << (DECODE_TABLE_BITS - len));
+
+            for (i = first; i < last; i++)
+            {
+                single[i] = ENTRY(s, 0, len, len, 1);
+            }
+        }
+        else
+        {
+            /* Größtes Codewort je Präfix bestimmt die Sekundärtabelle */
+            uint32_t prefix = codes[s] >> (len - DECODE_TABLE_BITS);
+
+            if (len - DECODE_TABLE_BITS > sub_bits[prefix])
+            {
+                sub_bits[prefix] = (unsigned char) (len - DECODE_TABLE_BITS);
+            }
+        }
+    }
+
+    /* Sekundärtabellen anlegen und verknüpfen */
+    for (i = 0; i < (1 << DECODE_TABLE_BITS); i++)
+    {
+        if (sub_bits[i] > 0)
+        {
+            sub_offset[i] = sub_size;
+            single[i] = ENTRY_LINK(sub_size, sub_bits[i]);
+            sub_size += (uint32_t) 1 << sub_bits[i];
+        }
+    }
+
+    table->secondary = NULL;
+    if (sub_size > 0)
+    {
+        table->secondary = (uint32_t *) allocate_owned(sub_size
+                                                       * sizeof (uint32_t));
+        memset(table->secondary, 0, sub_size * sizeof (uint32_t));
+    }
+    for (s = 0; s < SYMBOL_COUNT; s++)
+    {
+        int len = lengths[s];
+
+        if (len > DECODE_TABLE_BITS)
+        {
+            uint32_t prefix = codes[s] >> (len - DECODE_TABLE_BITS);
+            int bits = sub_bits[prefix];
+            int rest = len - DECODE_TABLE_BITS;
+            uint32_t first = sub_offset[prefix]
+                    + ((codes[s] & (((uint32_t) 1 << rest) - 1))
+                       << (bits - rest));
+            uint32_t last = first + ((uint32_t) 1 << (bits - rest));
+
+            for (i = first; i < last; i++)
+            {
+                table->secondary[i] = ENTRY(s, 0, len, len, 1);
+            }
+        }
+    }
+
+    /*
+     * Bleiben nach dem ersten Codewort genügend Bits im Index übrig, um ein
+     * weiteres Codewort vollständig zu enthalten, liefert der Eintrag beide
+     * Symbole. Das zweite Codewort beginnt an den restlichen Indexbits; der
+     * Eintrag dafür ist korrekt, solange es nicht länger als der Rest ist.
+     */
+    for (i = 0; i < (1 << DECODE_TABLE_BITS); i++)
+    {
+        uint32_t entry = single[i];
+
+        table->primary[i] = entry;
+        if (ENTRY_COUNT(entry) == 1 && ENTRY_BITS(entry) < DECODE_TABLE_BITS)
+        {
+            int first_bits = ENTRY_BITS(entry);
+            uint32_t next = single[(i << first_bits)
+                                   & ((1 << DECODE_TABLE_BITS) - 1)];
+
+            if (ENTRY_COUNT(next) == 1
+                    && first_bits + ENTRY_BITS(next) <= DECODE_TABLE_BITS)
+            {
+                table->primary[i] = ENTRY(ENTRY_SYM0(entry), ENTRY_SYM0(next),
+                                          first_bits + ENTRY_BITS(next),
+                                          first_bits, 2);
+            }
+        }
+    }
+    phase_stop(PHASE_TABLE, start);
+}
+
+static void free_decode_table(DECODE_TABLE *table)
+{
+    free_owned(table->secondary);
+    table->secondary = NULL;
+}
+
+static void decode_streams(const DECODE_TABLE *table, BIT_STREAM streams[],
+                           int stream_count, unsigned char dst[],
+                           uint32_t size)
+{
+    uint32_t i = 0;
+    int k;
+
+    /*
+     * Die Bitströme hängen nicht voneinander ab. Werden sie in derselben
+     * Schleife dekodiert, kann der Prozessor die Tabellenzugriffe der
+     * Bitströme überlappend ausführen. Jeder Bitstrom liefert je Durchlauf
+     * zwei Symbole.
+     */
+    if (stream_count == STREAM_COUNT)
+    {
+        for (; size - i >= 2 * STREAM_COUNT; i += 2 * STREAM_COUNT)
+        {
+            bool valid = true;
+
+            for (k = 0; k < STREAM_COUNT; k++)
+            {
+                stream_refill(&streams[k]);
+            }
+            for (k = 0; k < STREAM_COUNT; k++)
+            {
+                valid &= decode_pair(table, &streams[k], &dst[i + k],
+                                     &dst[i + STREAM_COUNT + k]);
+            }
+            if (!valid || (streams[0].count | streams[1].count
+                           | streams[2].count | streams[3].count) < 0)
+            {
+                report_format_error_and_exit(EMSG_INVALID_CODE);
+            }
+        }
+    }
+
+    /* Restliche Symbole einzeln */
+    for (k = (int) (i % (uint32_t) stream_count); i < size; i++)
+    {
+        BIT_STREAM *stream = &streams[k];
+        uint32_t entry;
+
+        stream_refill(stream);
+        entry = lookup_entry(table, stream->bits);
+        if (entry == 0)
+        {
+            report_format_error_and_exit(EMSG_INVALID_CODE);
+        }
+        dst[i] = ENTRY_SYM0(entry);
+        stream->bits <<= ENTRY_FIRST_BITS(entry);
+        stream->count -= ENTRY_FIRST_BITS(entry);
+        k = (k + 1 == stream_count) ? 0 : k + 1;
+    }
+
+    /* Kein Bitstrom darf über sein Ende hinaus gelesen worden sein */
+    for (k = 0; k < stream_count; k++)
+    {
+        if (streams[k].count < 0)
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+    }
+}
+
+static bool decode_pair(const DECODE_TABLE *table, BIT_STREAM *stream,
+                        unsigned char *first, unsigned char *second)
+{
+    uint32_t entry = lookup_entry(table, stream->bits);
+
+    if (ENTRY_COUNT(entry) == 2)
+    {
+        /* Schneller Pfad: zwei Symbole mit einem Tabellenzugriff */
+        *first = ENTRY_SYM0(entry);
+        *second = ENTRY_SYM1(entry);
+        stream->bits <<= ENTRY_BITS(entry);
+        stream->count -= ENTRY_BITS(entry);
+        return true;
+    }
+    if (entry == 0)
+    {
+        return false;
+    }
+    *first = ENTRY_SYM0(entry);
+    stream->bits <<= ENTRY_FIRST_BITS(entry);
+    stream->count -= ENTRY_FIRST_BITS(entry);
+
+    entry = lookup_entry(table, stream->bits);
+    *second = ENTRY_SYM0(entry);
+    stream->bits <<= ENTRY_FIRST_BITS(entry);
+    stream->count -= ENTRY_FIRST_BITS(entry);
+
+    return entry != 0;
+}
+
+static uint32_t lookup_entry(const DECODE_TABLE *table, uint64_t bits)
+{
+    uint32_t entry = table->primary[bits >> (64 - DECODE_TABLE_BITS)];
+
+    if (ENTRY_COUNT(entry) == 0 && ENTRY_BITS(entry) != 0)
+    {
+        /* Langes Codewort: Sekundärtabelle mit den Folgebits */
+        entry = table->secondary[ENTRY_OFFSET(entry)
+                + (uint32_t) ((bits << DECODE_TABLE_BITS)
+                              >> (64 - ENTRY_BITS(entry)))];
+    }
+
+    return entry;
+}
+
+static void stream_open(BIT_STREAM *stream, const unsigned char data[],
+                        size_t size)
+{
+    stream->next = data;
+    stream->end = data + size;
+    stream->bits = 0;
+    stream->count = 0;
+}
+
+static void stream_refill(BIT_STREAM *stream)
+{
+    if (stream->count < 0)
+    {
+        return;
+    }
+
+    if (stream->end - stream->next >= 8)
+    {
+        /*
+         * Acht Zeichen auf einmal laden und nur die ganzen Zeichen zählen,
+         * die in den Akkumulator passen. Die Bits des nächsten, nur zum
+         * Teil übernommenen Zeichens werden beim nächsten Auffüllen an
+         * derselben Stelle erneut eingetragen.
+         */
+        const unsigned char *p = stream->next;
+        uint64_t word = (uint64_t) p[0] << 56 | (uint64_t) p[1] << 48
+                | (uint64_t) p[2] << 40 | (uint64_t) p[3] << 32
+                | (uint64_t) p[4] << 24 | (uint64_t) p[5] << 16
+                | (uint64_t) p[6] << 8 | (uint64_t) p[7];
+        int bytes = (63 - stream->count) >> 3;
+
+        stream->bits |= word >> stream->count;
+        stream->next += bytes;
+        stream->count += bytes << 3;
+    }
+    else
+    {
+        while (stream->count <= 56 && stream->next < stream->end)
+        {
+            stream->bits |= (uint64_t) *stream->next++ << (56 - stream->count);
+            stream->count += 8;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+ * Kontextmodell
+ * ------------------------------------------------------------------------- */
+
+static uint64_t build_context_model(const unsigned char data[], size_t size,
+                                    const LEVEL *level, CONTEXT_MODEL *model)
+{
+    /* Häufigkeit je Kontext und Symbol, Kontext des ersten Zeichens ist 0 */
+    uint32_t (*freq)[SYMBOL_COUNT] = (uint32_t (*)[SYMBOL_COUNT])
+            allocate(SYMBOL_COUNT * sizeof (*freq));
+    uint64_t context_total[SYMBOL_COUNT] = {0};
+    uint64_t cluster_freq[SYMBOL_COUNT];
+    unsigned char cost[MAX_CONTEXT_TABLES][SYMBOL_COUNT];
+    int seeds[MAX_CONTEXT_TABLES];
+    int cluster_count = 0;
+    uint64_t bits;
+    unsigned char prev = 0;
+    size_t i;
+    int round;
+    int c;
+    int k;
+    int s;
+
+    memset(freq, 0, SYMBOL_COUNT * sizeof (*freq));
+    for (i = 0; i < size; i++)
+    {
+        freq[prev][data[i]]++;
+        prev = data[i];
+    }
+    for (c = 0; c < SYMBOL_COUNT; c++)
+    {
+        for (s = 0; s < SYMBOL_COUNT; s++)
+        {
+            context_total[c] += freq[c][s];
+        }
+    }
+
+    /* Die häufigsten Kontexte bilden die Anfangsgruppen */
+    for (c = 0; c < SYMBOL_COUNT; c++)
+    {
+        if (context_total[c] > 0)
+        {
+            int pos = (cluster_count < MAX_CONTEXT_TABLES)
+                    ? cluster_count++ : MAX_CONTEXT_TABLES;
+
+            while (pos > 0 && context_total[seeds[pos - 1]] < context_total[c])
+            {
+                if (pos < MAX_CONTEXT_TABLES)
+                {
+                    seeds[pos] = seeds[pos - 1];
+                }
+                pos--;
+            }
+            if (pos < MAX_CONTEXT_TABLES)
+            {
+                seeds[pos] = c;
+            }
+        }
+        model->map[c] = 0;
+    }
+    for (k = 0; k < cluster_count; k++)
+    {
+        model->map[seeds[k]] = (unsigned char) k;
+    }
+
+    /*
+     * Abwechselnd je Gruppe die Codetabelle berechnen und jeden Kontext der
+     * Gruppe zuordnen, deren Codetabelle seine Zeichen am kürzesten kodiert
+     * (k-Means). Im ersten Durchlauf besteht jede Gruppe nur aus ihrem
+     * Anfangskontext.
+     */
+    for (round = 0; round <= CLUSTER_ROUNDS; round++)
+    {
+        int remap[MAX_CONTEXT_TABLES];
+        int used = 0;
+
+        for (k = 0; k < cluster_count; k++)
+        {
+            memset(cluster_freq, 0, sizeof (cluster_freq));
+            for (c = 0; c < SYMBOL_COUNT; c++)
+            {
+                if (model->map[c] == k && context_total[c] > 0
+                        && (round > 0 || c == seeds[k]))
+                {
+                    for (s = 0; s < SYMBOL_COUNT; s++)
+                    {
+                        cluster_freq[s] += freq[c][s];
+                    }
+                }
+            }
+            build_code_lengths(cluster_freq, model->lengths[k], level);
+            for (s = 0; s < SYMBOL_COUNT; s++)
+            {
+                /* Fehlende Symbole verteuern, damit sie selten nötig sind */
+                cost[k][s] = (model->lengths[k][s] > 0)
+                        ? model->lengths[k][s] : MAX_CODE_LEN + 4;
+            }
+        }
+        if (round == CLUSTER_ROUNDS)
+        {
+            break;
+        }
+
+        for (c = 0; c < SYMBOL_COUNT; c++)
+        {
+            uint64_t best_bits = UINT64_MAX;
+
+            if (context_total[c] == 0)
+            {
+                continue;
+            }
+            for (k = 0; k < cluster_count; k++)
+            {
+                uint64_t cluster_bits = 0;
+
+                for (s = 0; s < SYMBOL_COUNT; s++)
+                {
+                    cluster_bits += (uint64_t) freq[c][s] * cost[k][s];
+                }
+                if (cluster_bits < best_bits)
+                {
+                    best_bits = cluster_bits;
+                    model->map[c] = (unsigned char) k;
+                }
+            }
+        }
+
+        /* Leere Gruppen entfernen */
+        for (k = 0; k < cluster_count; k++)
+        {
+            remap[k] = -1;
+        }
+        for (c = 0; c < SYMBOL_COUNT; c++)
+        {
+            if (context_total[c] > 0 && remap[model->map[c]] < 0)
+            {
+                remap[model->map[c]] = used++;
+            }
+        }
+        for (c = 0; c < SYMBOL_COUNT; c++)
+        {
+            model->map[c] = (context_total[c] > 0)
+                    ? (unsigned char) remap[model->map[c]] : 0;
+        }
+        cluster_count = used;
+    }
+    model->table_count = cluster_count;
+
+    /* Art des Blockinhalts, Anzahl der Tabellen, Zuordnung und Tabellen */
+    bits = 8 * (2 + CONTEXT_MAP_LEN);
+    for (k = 0; k < cluster_count; k++)
+    {
+        bits += 8 * table_size(model->lengths[k]);
+    }
+    for (c = 0; c < SYMBOL_COUNT; c++)
+    {
+        for (s = 0; s < SYMBOL_COUNT; s++)
+        {
+            bits += (uint64_t) freq[c][s] * model->lengths[model->map[c]][s];
+        }
+    }
+    free(freq);
+
+    return bits;
+}
+
+static void encode_context(const unsigned char data[], size_t size,
+                           WRITER *out, const CONTEXT_MODEL *model)
+{
+    uint32_t codes[MAX_CONTEXT_TABLES][SYMBOL_COUNT];
+    unsigned char prev = 0;
+    size_t i;
+    int k;
+
+    writer_write_char(out, (unsigned char) (model->table_count - 1));
+    for (i = 0; i < SYMBOL_COUNT; i += 2)
+    {
+        writer_write_char(out, (unsigned char) (model->map[i] << 4
+                                                | model->map[i + 1]));
+    }
+    for (k = 0; k < model->table_count; k++)
+    {
+        write_table(out, model->lengths[k]);
+        assign_canonical_codes(model->lengths[k], codes[k]);
+    }
+
+    for (i = 0; i < size; i++)
+    {
+        int table = model->map[prev];
+
+        writer_write_bits(out, codes[table][data[i]],
+                          model->lengths[table][data[i]]);
+        prev = data[i];
+    }
+    writer_flush_bits(out);
+}
+
+static void decode_context(READER *in, unsigned char dst[], uint32_t size)
+{
+    CONTEXT_MODEL model;
+    DECODE_TABLE *tables;
+    unsigned char prev = 0;
+    uint32_t i;
+    int k;
+
+    model.table_count = read_header_char(in) + 1;
+    if (model.table_count > MAX_CONTEXT_TABLES)
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+    for (i = 0; i < SYMBOL_COUNT; i += 2)
+    {
+        unsigned char pair = read_header_char(in);
+
+        model.map[i] = (unsigned char) (pair >> 4);
+        model.map[i + 1] = (unsigned char) (pair & 0x0F);
+        if (model.map[i] >= model.table_count
+                || model.map[i + 1] >= model.table_count)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+    }
+
+    tables = (DECODE_TABLE *) allocate_owned((size_t) model.table_count
+                                       * sizeof (DECODE_TABLE));
+    for (k = 0; k < model.table_count; k++)
+    {
+        read_table(in, model.lengths[k], NULL);
+        build_decode_table(model.lengths[k], &tables[k]);
+    }
+
+    /* Das vorherige Zeichen bestimmt die Tabelle für das nächste */
+    for (i = 0; i < size; i++)
+    {
+        uint32_t bits = reader_peek_bits(in, MAX_CODE_LEN);
+        uint32_t entry = lookup_entry(&tables[model.map[prev]],
+                                      (uint64_t) bits << (64 - MAX_CODE_LEN));
+        int len = ENTRY_FIRST_BITS(entry);
+
+        if (entry == 0)
+        {
+            report_format_error_and_exit(EMSG_INVALID_CODE);
+        }
+        if (!reader_has_next_bits(in, len))
+        {
+            report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+        }
+        reader_consume_bits(in, len);
+        dst[i] = ENTRY_SYM0(entry);
+        prev = dst[i];
+    }
+
+    for (k = 0; k < model.table_count; k++)
+    {
+        free_decode_table(&tables[k]);
+    }
+    free_owned(tables);
+}
+
+/* ----------------------------------------------------------------------------
+ * LZ77-Zerlegung
+ * ------------------------------------------------------------------------- */
+
+static bool encode_lz77(const unsigned char data[], size_t size,
+                        WRITER *out, const LEVEL *level)
+{
+    LZ77_PARSE parse;
+    uint64_t freq[SYMBOL_COUNT];
+    unsigned char code_lengths[3][SYMBOL_COUNT];
+    uint32_t codes[3][SYMBOL_COUNT];
+    uint64_t lz77_bits;
+    uint64_t plain_bits;
+    int extra;
+    size_t i;
+    int k;
+    double start = phase_start();
+
+    lz77_parse(data, size, &level->lz77, &parse);
+    phase_stop(PHASE_MATCH, start);
+    if (parse.sequence_count == 0)
+    {
+        lz77_free(&parse);
+        return false;
+    }
+
+    lz77_bits = lz77_parse_bits(&parse, level, code_lengths);
+
+    /* Nur verwenden, wenn der Block kürzer wird als zeichenweise kodiert */
+    count_frequencies(data, size, freq);
+    plain_bits = estimate_block_bits(freq, level) - 8 * BLOCK_HEADER_LEN;
+    if (lz77_bits >= plain_bits)
+    {
+        lz77_free(&parse);
+        return false;
+    }
+
+    writer_write_char(out, BLOCK_LZ77);
+    write_u32(out, (uint32_t) parse.literal_count);
+    write_u32(out, (uint32_t) parse.sequence_count);
+
+    /* Literale als eigener Blockinhalt mit vorangestellter Länge */
+    if (parse.literal_count > 0)
+    {
+        WRITER literals;
+        unsigned char *literal_data;
+        size_t literal_size;
+
+        writer_open_memory(&literals);
+        encode_literals(parse.literals, parse.literal_count, &literals, level,
+                        NULL);
+        writer_flush_bits(&literals);
+        literal_data = writer_close_memory(&literals, &literal_size);
+        write_u32(out, (uint32_t) literal_size);
+        writer_write(out, literal_data, literal_size);
+        free(literal_data);
+    }
+    else
+    {
+        write_u32(out, 0);
+    }
+
+    /* Codetabellen, dann je Sequenz Literallänge, Länge und Abstand */
+    for (k = 0; k < 3; k++)
+    {
+        write_table(out, code_lengths[k]);
+        assign_canonical_codes(code_lengths[k], codes[k]);
+    }
+    for (i = 0; i < parse.sequence_count; i++)
+    {
+        const LZ77_SEQUENCE *sequence = &parse.sequences[i];
+        uint32_t values[3];
+
+        values[0] = sequence->literal_length;
+        values[1] = sequence->match_length - LZ77_MIN_MATCH;
+        values[2] = sequence->distance - 1;
+        for (k = 0; k < 3; k++)
+        {
+            int code = lz77_value_code(values[k], &extra);
+
+            writer_write_bits(out, codes[k][code], code_lengths[k][code]);
+            if (extra > 0)
+            {
+                writer_write_bits(out, values[k], extra);
+            }
+        }
+    }
+    writer_flush_bits(out);
+
+    lz77_free(&parse);
+    return true;
+}
+
+static uint64_t lz77_parse_bits(const LZ77_PARSE *parse, const LEVEL *level,
+                                unsigned char code_lengths[][SYMBOL_COUNT])
+{
+    uint64_t freq[SYMBOL_COUNT];
+    uint64_t code_freq[3][SYMBOL_COUNT];
+    uint64_t bits;
+    int extra;
+    size_t i;
+    int k;
+
+    /* Art, Anzahlen und Länge der Literale */
+    bits = 8 * (1 + 3 * 4);
+
+    /* Literallängen, Wiederholungslängen und Abstände mit Zusatzbits */
+    memset(code_freq, 0, sizeof (code_freq));
+    for (i = 0; i < parse->sequence_count; i++)
+    {
+        const LZ77_SEQUENCE *sequence = &parse->sequences[i];
+
+        code_freq[0][lz77_value_code(sequence->literal_length, &extra)]++;
+        bits += (uint64_t) extra;
+        code_freq[1][lz77_value_code(sequence->match_length - LZ77_MIN_MATCH,
+                                     &extra)]++;
+        bits += (uint64_t) extra;
+        code_freq[2][lz77_value_code(sequence->distance - 1, &extra)]++;
+        bits += (uint64_t) extra;
+    }
+    for (k = 0; k < 3; k++)
+    {
+        build_code_lengths(code_freq[k], code_lengths[k], level);
+        bits += 8 * table_size(code_lengths[k]);
+        for (i = 0; i < LZ77_CODE_COUNT; i++)
+        {
+            bits += code_freq[k][i] * code_lengths[k][i];
+        }
+    }
+    if (parse->literal_count > 0)
+    {
+        count_frequencies(parse->literals, parse->literal_count, freq);
+        bits += estimate_block_bits(freq, level) - 8 * BLOCK_HEADER_LEN;
+    }
+
+    return bits;
+}
+
+static bool lz77_beats_stored(const unsigned char data[], size_t size,
+                              const LEVEL *level)
+{
+    bool beats;
+    double start;
+
+    if (level->lz77.chain_depth == 0 || size < MIN_LZ77_SIZE)
+    {
+        return false;
+    }
+
+    /*
+     * Nur Stichproben statt einer Zerlegung: nicht komprimierbare Daten
+     * sollen kaum mehr kosten als ihr Kopieren. Ob sich das Kodieren
+     * wirklich lohnt, zeigt danach der Vergleich mit dem gespeicherten Block.
+     */
+    start = phase_start();
+    beats = lz77_repeat_share(data, size, &level->lz77) >= MIN_REPEAT_SHARE;
+    phase_stop(PHASE_MATCH, start);
+
+    return beats;
+}
+
+static void decode_lz77(READER *in, unsigned char dst[], uint32_t size)
+{
+    unsigned char code_lengths[3][SYMBOL_COUNT];
+    DECODE_TABLE tables[3];
+    READER section;
+    BIT_STREAM stream;
+    unsigned char *literals;
+    const unsigned char *data;
+    size_t remaining;
+    uint32_t literal_count;
+    uint32_t sequence_count;
+    uint32_t literal_size;
+    size_t literal_pos = 0;
+    size_t pos = 0;
+    uint32_t i;
+    int k;
+
+    literal_count = read_u32(in);
+    sequence_count = read_u32(in);
+    literal_size = read_u32(in);
+    if (literal_count > size || sequence_count > size / LZ77_MIN_MATCH
+            || (literal_count > 0) != (literal_size > 0))
+    {
+        report_format_error_and_exit(EMSG_INVALID_HEADER);
+    }
+    data = reader_take_rest(in, &remaining);
+    if (literal_size > remaining)
+    {
+        report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+    }
+
+    /* Die Literale sind ein eingebetteter Blockinhalt ohne LZ77 */
+    literals = (unsigned char *) allocate_owned(literal_count);
+    if (literal_count > 0)
+    {
+        if (data[0] == BLOCK_LZ77 || data[0] == BLOCK_CHECKED)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+        reader_open_memory(&section, data, literal_size);
+        decode_block(&section, literals, literal_count, NULL);
+    }
+    data += literal_size;
+    remaining -= literal_size;
+
+    if (sequence_count > 0)
+    {
+        reader_open_memory(&section, data, remaining);
+        for (k = 0; k < 3; k++)
+        {
+            read_lz77_table(&section, code_lengths[k]);
+        }
+        data = reader_take_rest(&section, &remaining);
+        stream_open(&stream, data, remaining);
+        for (k = 0; k < 3; k++)
+        {
+            build_decode_table(code_lengths[k], &tables[k]);
+        }
+
+        for (i = 0; i < sequence_count; i++)
+        {
+            size_t literal_length = read_lz77_value(&tables[0], &stream);
+            size_t match_length = (size_t) read_lz77_value(&tables[1], &stream)
+                    + LZ77_MIN_MATCH;
+            size_t distance = (size_t) read_lz77_value(&tables[2], &stream) + 1;
+
+            if (stream.count < 0)
+            {
+                report_format_error_and_exit(EMSG_UNEXPECTED_EOF);
+            }
+            if (literal_length > literal_count - literal_pos
+                    || literal_length > size - pos)
+            {
+                report_format_error_and_exit(EMSG_INVALID_CODE);
+            }
+            memcpy(dst + pos, literals + literal_pos, literal_length);
+            literal_pos += literal_length;
+            pos += literal_length;
+
+            if (distance > pos || match_length > size - pos)
+            {
+                report_format_error_and_exit(EMSG_INVALID_CODE);
+            }
+            if (distance >= match_length)
+            {
+                memcpy(dst + pos, dst + pos - distance, match_length);
+            }
+            else
+            {
+                /* Überlappende Wiederholung: Zeichen einzeln kopieren */
+                unsigned char *match = dst + pos - distance;
+                size_t n;
+
+                for (n = 0; n < match_length; n++)
+                {
+                    dst[pos + n] = match[n];
+                }
+            }
+            pos += match_length;
+        }
+
+        for (k = 0; k < 3; k++)
+        {
+            free_decode_table(&tables[k]);
+        }
+    }
+
+    /* Literale hinter der letzten Sequenz */
+    if (literal_count - literal_pos != size - pos)
+    {
+        report_format_error_and_exit(EMSG_INVALID_CODE);
+    }
+    memcpy(dst + pos, literals + literal_pos, size - pos);
+    free_owned(literals);
+}
+
+static int lz77_value_code(uint32_t value, int *extra_bits)
+{
+    int high = 0;
+
+    if (value < 4)
+    {
+        *extra_bits = 0;
+        return (int) value;
+    }
+    while (value >> (high + 1) != 0)
+    {
+        high++;
+    }
+    *extra_bits = high - 2;
+
+    return 4 * (high - 1) + (int) ((value >> (high - 2)) & 3);
+}
+
+static uint32_t read_lz77_value(const DECODE_TABLE *table, BIT_STREAM *stream)
+{
+    uint32_t entry;
+    uint32_t value;
+    int code;
+    int extra;
+
+    stream_refill(stream);
+    entry = lookup_entry(table, stream->bits);
+    if (entry == 0)
+    {
+        report_format_error_and_exit(EMSG_INVALID_CODE);
+    }
+    code = ENTRY_SYM0(entry);
+    stream->bits <<= ENTRY_FIRST_BITS(entry);
+    stream->count -= ENTRY_FIRST_BITS(entry);
+    if (code < 4)
+    {
+        return (uint32_t) code;
+    }
+
+    /* Höchstes Bit und die beiden folgenden aus dem Code, Rest Zusatzbits */
+    extra = code / 4 - 1;
+    value = (uint32_t) (4 | (code & 3)) << extra;
+    if (extra > 0)
+    {
+        value |= (uint32_t) (stream->bits >> (64 - extra));
+        stream->bits <<= extra;
+        stream->count -= extra;
+    }
+
+    return value;
+}
+
+static void read_lz77_table(READER *in, unsigned char lengths[])
+{
+    int i;
+
+    read_table(in, lengths, NULL);
+    for (i = LZ77_CODE_COUNT; i < SYMBOL_COUNT; i++)
+    {
+        if (lengths[i] != 0)
+        {
+            report_format_error_and_exit(EMSG_INVALID_HEADER);
+        }
+    }
+}
+
+static int window_log(uint32_t window_size)
+{
+    int log = LZ77_MIN_WINDOW_LOG;
+
+    while (log < LZ77_MAX_WINDOW_LOG && (window_size >> (log + 1)) != 0)
+    {
+        log++;
+    }
+
+    return log;
+}
+
+/* ----------------------------------------------------------------------------
+ * Fehlerbehandlung
+ * ------------------------------------------------------------------------- */
+
+static uint32_t load_u32(const unsigned char data[])
+{
+    return ((uint32_t) data[0] << 24) | ((uint32_t) data[1] << 16)
+            | ((uint32_t) data[2] << 8) | (uint32_t) data[3];
+}
+
+static void release_block_ring(void *ring)
+{
+    BLOCK_RING *self = (BLOCK_RING *) ring;
+    size_t i;
+
+    for (i = 0; i < self->count; i++)
+    {
+        free(self->jobs[i].buffer);
+        free(self->jobs[i].output);
+    }
+    free(self->jobs);
+    free(self);
+}
+
+static void discard_files(READER *in, WRITER *out, const char out_filename[],
+                          bool created)
+{
+    reader_abort(in);
+    writer_abort(out);
+    if (created && strcmp(out_filename, STDIO_FILENAME) != 0)
+    {
+        (void) remove(out_filename);
+    }
+}
+
+static void *allocate_owned(size_t size)
+{
+    void *memory = allocate(size);
+
+    trap_own(memory, free);
+
+    return memory;
+}
+
+static void free_owned(void *memory)
+{
+    trap_disown(memory);
+    free(memory);
+}
+
+static void *allocate(size_t size)
+{
+    void *memory = malloc(size > 0 ? size : 1);
+
+    if (memory == NULL)
+    {
+        trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+    }
+
+    return memory;
+}
+
+static void report_format_error_and_exit(const char *message)
+{
+    trap_raise(EXIT_DC_ERROR, message);
 }
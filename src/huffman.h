@@ -3,6 +3,16 @@
  * In diesem Modul werden die Huffman-Komprimierung und die 
  * Huffman-Dekomprimierung realisiert.
  *
+ * Neben Dateien können auch Speicherbereiche komprimiert werden
+ * (compress_buffer, decompress_buffer). Diese Funktionen beenden nie das
+ * Programm, sondern liefern jeden Fehler als Rückgabewert (EXIT_*-Codes aus
+ * huffman_common.h), auch fehlenden Speicher oder Threads
+ * (EXIT_RESOURCE_ERROR) und einen zu kleinen Zielbereich
+ * (EXIT_DST_TOO_SMALL). Bei fehlendem Speicher in einem Thread des Pools
+ * kann dabei Speicher des abgebrochenen Blocks verloren gehen. Mit
+ * "make lib" wird das Modul als statische und dynamische Bibliothek
+ * übersetzt.
+ *
  * @author Ulrike Griefahn
  * @date 2017-01-12
  */
@@ -11,15 +21,171 @@
 #define	HUFFMAN_H
 /* ------------------------------------------------------------------------- */
 
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include "huffman_common.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Standard-Level für die Komprimierung */
+#define HUFFMAN_STD_LEVEL 2
+
+/** Standard-Blockgröße in Byte */
+#define HUFFMAN_STD_BLOCK_SIZE (1024 * 1024)
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Abschnitte der Bearbeitung, deren Laufzeiten getrennt erfasst werden
+ */
+typedef enum
+{
+    /** Lesen der Eingabedatei */
+    PHASE_READ,
+
+    /** Zählen der Häufigkeiten */
+    PHASE_HISTOGRAM,
+
+    /** Aufbau der Codetabellen und Dekodiertabellen */
+    PHASE_TABLE,
+
+    /** Suche nach Wiederholungen (LZ77-Zerlegung) */
+    PHASE_MATCH,
+
+    /** Kodieren bzw. Dekodieren der Zeichen */
+    PHASE_CODE,
+
+    /** Schreiben der Ausgabedatei */
+    PHASE_WRITE,
+
+    /** Anzahl der Abschnitte */
+    PHASE_COUNT
+} HUFFMAN_PHASE;
+
+/**
+ * Statistik über eine oder mehrere Komprimierungen bzw. Dekomprimierungen.
+ * Die Laufzeiten der Abschnitte werden über alle Threads summiert und
+ * können daher zusammen die Wanduhrzeit übersteigen.
+ */
+typedef struct
+{
+    /** Laufzeit je Abschnitt (HUFFMAN_PHASE) in Sekunden */
+    double phase_seconds[PHASE_COUNT];
+
+    /** Anzahl der gelesenen Bytes */
+    uint64_t in_bytes;
+
+    /** Anzahl der geschriebenen Bytes */
+    uint64_t out_bytes;
+
+    /** Anzahl der bearbeiteten Blöcke */
+    uint64_t blocks;
+} HUFFMAN_STATS;
+
+/**
+ * Einstellungen für das Komprimieren und Dekomprimieren
+ */
+typedef struct
+{
+    /** Level der Komprimierung (1-7) */
+    int level;
+
+    /**
+     * Größe der Blöcke in Byte, in die die Eingabedatei zerlegt wird. Jeder
+     * Block erhält eine eigene Codetabelle oder übernimmt die seines
+     * Vorgängers; kleine Blöcke werden dafür gemeinsam komprimiert.
+     */
+    uint32_t block_size;
+
+    /** Anzahl der Threads, die Blöcke parallel bearbeiten */
+    int threads;
+
+    /**
+     * Größe des Suchfensters der LZ77-Zerlegung in Byte (wird auf eine
+     * Zweierpotenz abgerundet), 0 für das Fenster des Levels
+     */
+    uint32_t window_size;
+
+    /**
+     * true: jedem Block die Prüfsumme CRC32C seiner Zeichen voranstellen,
+     * die beim Dekomprimieren geprüft wird
+     */
+    bool checksum;
+
+    /**
+     * Position des ersten auszugebenden Zeichens beim Dekomprimieren. Mit
+     * Blockverzeichnis werden nur die Blöcke gelesen und dekodiert, die
+     * der Bereich berührt.
+     */
+    uint64_t range_offset;
+
+    /**
+     * Anzahl der auszugebenden Zeichen ab range_offset, UINT64_MAX für alle
+     * bis zum Ende. Endet die Datei vorher, wird bis zum Ende ausgegeben.
+     */
+    uint64_t range_length;
+
+    /**
+     * Kennung eines mit load_dictionary geladenen Wörterbuchs, dessen
+     * Codetabelle beim Komprimieren für jeden Block geprüft wird, 0 für
+     * keins. Beim Dekomprimieren werden alle geladenen Wörterbücher
+     * verwendet.
+     */
+    uint32_t dictionary;
+
+    /**
+     * Statistik, zu der Laufzeiten und Größen addiert werden, NULL wenn
+     * keine erfasst werden soll
+     */
+    HUFFMAN_STATS *stats;
+} HUFFMAN_OPTIONS;
+
 
 /* ============================================================================
  * Funktions-Prototypen
  * ========================================================================= */
 
+/**
+ * Belegt die Einstellungen mit Standardwerten: Standard-Level und
+ * -Blockgröße, ein Thread je Prozessorkern, Suchfenster des Levels, keine
+ * Prüfsummen, Dekomprimieren der ganzen Datei, kein Wörterbuch, keine
+ * Statistik.
+ *
+ * @param options   zu belegende Einstellungen
+ */
+extern void init_options(HUFFMAN_OPTIONS *options);
+
+/**
+ * Setzt alle Werte einer Statistik auf 0.
+ *
+ * @param stats     zurückzusetzende Statistik
+ */
+extern void init_stats(HUFFMAN_STATS *stats);
+
+/**
+ * Addiert die Werte einer Statistik zu einer anderen.
+ *
+ * @param sum       Statistik, zu der addiert wird
+ * @param stats     zu addierende Statistik
+ */
+extern void add_stats(HUFFMAN_STATS *sum, const HUFFMAN_STATS *stats);
+
 /**
  * Komprimiert den Inhalt der Eingabedatei in_filename und schreibt das 
- * Ergebnis in die Ausgabedatei out_filename. Bei einem Fehler wird das 
- * Programm abgebrochen.
+ * Ergebnis in die Ausgabedatei out_filename. Bei einem Fehler wird die
+ * unvollständige Ausgabedatei gelöscht und das Programm abgebrochen.
  * 
  * @param in_filename   Name der Eingabedatei
  * @param out_filename  Name der Ausgabedatei
@@ -29,13 +195,179 @@ extern void compress(char in_filename[], char out_filename[]);
 /**
  * Dekomprimiert den Inhalt der Eingabedatei in_filename und 
  * schreibt das Ergebnis in die Ausgabedatei out_filename. Bei einem Fehler
- * wird das Programm abgebrochen.
+ * wird die unvollständige Ausgabedatei gelöscht und das Programm
+ * abgebrochen.
  * 
  * @param in_filename   Name der Eingabedatei
  * @param out_filename  Name der Ausgabedatei
  */
 extern void decompress(char in_filename[], char out_filename[]);
 
+/**
+ * Komprimiert wie compress, verwendet aber die übergebenen Einstellungen.
+ *
+ * @param in_filename   Name der Eingabedatei
+ * @param out_filename  Name der Ausgabedatei
+ * @param options       Einstellungen
+ */
+extern void compress_with_options(char in_filename[], char out_filename[],
+                                  const HUFFMAN_OPTIONS *options);
+
+/**
+ * Dekomprimiert wie decompress, verwendet aber die übergebenen
+ * Einstellungen. Mit range_offset und range_length wird nur ein Ausschnitt
+ * der ursprünglichen Daten ausgegeben.
+ *
+ * @param in_filename   Name der Eingabedatei
+ * @param out_filename  Name der Ausgabedatei
+ * @param options       Einstellungen
+ */
+extern void decompress_with_options(char in_filename[], char out_filename[],
+                                    const HUFFMAN_OPTIONS *options);
+
+/**
+ * Komprimiert mehrere Dateien wie compress_with_options. Die Dateien
+ * werden nebeneinander von options->threads Threads bearbeitet, jede
+ * Datei von einem Thread. Ein Fehler bricht nicht das Programm ab, sondern
+ * nur die betroffene Datei: Er wird mit ihrem Namen ausgegeben, ihre
+ * unvollständige Ausgabedatei gelöscht und die übrigen Dateien werden
+ * weiter bearbeitet.
+ *
+ * @param in_filenames  Namen der Eingabedateien
+ * @param out_filenames Namen der Ausgabedateien
+ * @param count         Anzahl der Dateien
+ * @param options       Einstellungen
+ * @return              EXIT_SUCCESS oder der EXIT_*-Code der ersten Datei
+ *                      (in der übergebenen Reihenfolge), die nicht
+ *                      bearbeitet werden konnte
+ */
+extern int compress_batch(char *in_filenames[], char *out_filenames[],
+                          size_t count, const HUFFMAN_OPTIONS *options);
+
+/**
+ * Dekomprimiert mehrere Dateien wie decompress_with_options. Die Dateien
+ * werden nebeneinander von options->threads Threads bearbeitet, jede
+ * Datei von einem Thread. Fehler werden wie bei compress_batch je Datei
+ * behandelt.
+ *
+ * @param in_filenames  Namen der Eingabedateien
+ * @param out_filenames Namen der Ausgabedateien
+ * @param count         Anzahl der Dateien
+ * @param options       Einstellungen
+ * @return              EXIT_SUCCESS oder der EXIT_*-Code der ersten Datei,
+ *                      die nicht bearbeitet werden konnte
+ */
+extern int decompress_batch(char *in_filenames[], char *out_filenames[],
+                            size_t count, const HUFFMAN_OPTIONS *options);
+
+/**
+ * Liefert die größtmögliche Länge der komprimierten Daten, die
+ * compress_buffer für size Bytes mit den übergebenen Einstellungen
+ * erzeugt.
+ *
+ * @param size      Anzahl der unkomprimierten Bytes
+ * @param options   Einstellungen (Blockgröße, Prüfsummen), NULL für
+ *                  Standardwerte
+ * @return          größtmögliche Anzahl der komprimierten Bytes
+ */
+extern size_t compress_bound(size_t size, const HUFFMAN_OPTIONS *options);
+
+/**
+ * Komprimiert einen Speicherbereich in einen anderen. Das Ergebnis hat
+ * dasselbe Format wie eine komprimierte Datei (ohne Blockverzeichnis) und
+ * wird direkt in den Zielbereich geschrieben. Passt src in einen Block
+ * (bzw. in einen Auftrag aus mehreren kleinen Blöcken, bis 256 KiB), wird
+ * ohne Threads im aufrufenden Thread komprimiert.
+ *
+ * @param src           unkomprimierte Daten
+ * @param src_size      Anzahl der unkomprimierten Bytes
+ * @param dst           Zielbereich, sicher ausreichend mit
+ *                      compress_bound(src_size, options) Bytes
+ * @param dst_capacity  Größe des Zielbereichs
+ * @param dst_size      Anzahl der komprimierten Bytes (Ausgabe)
+ * @param options       Einstellungen, NULL für Standardwerte
+ * @return              EXIT_SUCCESS, EXIT_OPTION_ERROR bei ungültigen
+ *                      Parametern, EXIT_DST_TOO_SMALL bei zu kleinem
+ *                      Zielbereich, EXIT_RESOURCE_ERROR, wenn Speicher
+ *                      oder Threads fehlen
+ */
+extern int compress_buffer(const unsigned char src[], size_t src_size,
+                           unsigned char dst[], size_t dst_capacity,
+                           size_t *dst_size, const HUFFMAN_OPTIONS *options);
+
+/**
+ * Bestimmt aus den Blockköpfen die Länge der unkomprimierten Daten, ohne
+ * sie zu dekomprimieren.
+ *
+ * @param src       komprimierte Daten
+ * @param src_size  Anzahl der komprimierten Bytes
+ * @param size      Anzahl der unkomprimierten Bytes (Ausgabe)
+ * @return          EXIT_SUCCESS, EXIT_OPTION_ERROR bei ungültigen
+ *                  Parametern, EXIT_DC_ERROR bei unvollständigen oder
+ *                  ungültigen Daten
+ */
+extern int decompressed_size(const unsigned char src[], size_t src_size,
+                             uint64_t *size);
+
+/**
+ * Dekomprimiert einen Speicherbereich in einen anderen. Die Blöcke werden
+ * im aufrufenden Thread nacheinander direkt in den Zielbereich dekodiert.
+ * Kann von mehreren Threads gleichzeitig aufgerufen werden.
+ *
+ * @param src           komprimierte Daten
+ * @param src_size      Anzahl der komprimierten Bytes
+ * @param dst           Zielbereich
+ * @param dst_capacity  Größe des Zielbereichs (siehe decompressed_size)
+ * @param dst_size      Anzahl der dekomprimierten Bytes (Ausgabe)
+ * @return              EXIT_SUCCESS, EXIT_OPTION_ERROR bei ungültigen
+ *                      Parametern, EXIT_DST_TOO_SMALL bei zu kleinem
+ *                      Zielbereich, EXIT_DC_ERROR bei ungültigen Daten,
+ *                      EXIT_RESOURCE_ERROR, wenn Speicher fehlt
+ */
+extern int decompress_buffer(const unsigned char src[], size_t src_size,
+                             unsigned char dst[], size_t dst_capacity,
+                             size_t *dst_size);
+
+/**
+ * Erstellt aus den Häufigkeiten der Zeichen in Beispieldateien eine
+ * Codetabelle für alle Zeichen und speichert sie als Wörterbuch. Blöcke,
+ * die mit dem Wörterbuch komprimiert werden, enthalten statt der
+ * Codetabelle nur dessen Kennung; das lohnt sich vor allem für viele
+ * kleine, ähnliche Dateien. Bei einem Fehler wird das Programm
+ * abgebrochen.
+ *
+ * @param sample_filenames      Namen der Beispieldateien
+ * @param count                 Anzahl der Beispieldateien
+ * @param dictionary_filename   Name der Wörterbuchdatei
+ * @param options               Einstellungen (Level, Blockgröße zum Lesen)
+ * @return                      Kennung des Wörterbuchs
+ */
+extern uint32_t train_dictionary(char *sample_filenames[], size_t count,
+                                 char dictionary_filename[],
+                                 const HUFFMAN_OPTIONS *options);
+
+/**
+ * Lädt ein Wörterbuch und berechnet einmal seine Codewörter und seine
+ * Dekodiertabelle, die danach für alle Dateien und Threads verwendet
+ * werden. Darf nicht gleichzeitig mit dem Komprimieren oder
+ * Dekomprimieren aufgerufen werden. Bei einem Fehler wird das Programm
+ * abgebrochen.
+ *
+ * @param dictionary_filename   Name der Wörterbuchdatei
+ * @return                      Kennung des Wörterbuchs (für
+ *                              HUFFMAN_OPTIONS.dictionary)
+ */
+extern uint32_t load_dictionary(char dictionary_filename[]);
+
+/**
+ * Gibt alle geladenen Wörterbücher frei.
+ */
+extern void unload_dictionaries(void);
+
+#ifdef __cplusplus
+}
+#endif
+
 /* ------------------------------------------------------------------------- */
 #endif	/* HUFFMAN_H */
 
@@ -15,6 +15,7 @@
  * ======================================================================== */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 
@@ -45,13 +46,17 @@ typedef enum
  *  2 = Fehler beim Aufruf
  *  3 = Ein-/Ausgabefehler
  *  4 = Fehler beim Komprimieren oder dekomprimieren
+ *  5 = nicht genügend Speicher oder Threads
+ *  6 = Zielbereich zu klein (nur compress_buffer und decompress_buffer)
  */
 enum {
     /* EXIT_SUCCESS, */
     /* EXIT_FAILURE, */
     EXIT_OPTION_ERROR = 2,
     EXIT_IO_ERROR,
-    EXIT_DC_ERROR
+    EXIT_DC_ERROR,
+    EXIT_RESOURCE_ERROR,
+    EXIT_DST_TOO_SMALL
 };
 
 
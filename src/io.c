@@ -2,50 +2,121 @@
  * Includes
  * ========================================================================= */
 
+/* copy_file_range wird von glibc nur mit _GNU_SOURCE deklariert */
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+/* Splint definiert S_SPLINT_S. Die POSIX-Header werden von der Prüfung
+ * ausgeklammert (siehe main.c). */
+#ifndef S_SPLINT_S
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif
 
 /* Definiere Variablen, damit sie in dieser Datei für Splint bekannt sind. Sie
  * werden in errno.h definiert. */
 #define ENOENT 0
 #define EIO 0
 #define EMFILE 0
+#define ENOMEM 0
+#define ENOSPC 0
+#define EISDIR 0
+#define EFBIG 0
 #include <errno.h>
 
 #include "huffman_common.h"
 #include "io.h"
+#include "trap.h"
 
 
 /* ============================================================================
  * Symbolische Konstanten
  * ========================================================================= */
 
-/**
- * Blockgröße, mit der aus der Eingabedatei gelesen und in die Ausgabedatei 
- * geschrieben wird.
- */
-#define BUF_SIZE 4096
+/** Anzahl der Bits im Bitpuffer (Akkumulator) */
+#define BIT_BUF_BITS 64
+
+/** Größe des Zwischenpuffers, wenn writer_copy_at selbst kopieren muss */
+#define COPY_BUF_SIZE (64 * 1024)
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
+/** copy_file_range ist ab glibc 2.27 vorhanden */
+#if defined(__linux__) && defined(__GLIBC__) && !defined(S_SPLINT_S) \
+    && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 27))
+#define HAVE_COPY_FILE_RANGE 1
+#endif
 
 
 /* ============================================================================
- * Makros
+ * Datentypen
  * ========================================================================= */
 
 /**
- * Liefert das Bit von C an der Position POS. Ist POS gleich 0, wird  
- * das höchstwertigste Bit geliefert, für POS gleich 7 wird das 
- * niederwertigste Bit geliefert. Es wird davon ausgegangen, dass POS einen
- * Wert zwischen 0 und 7 hat. Ansonsten ist die Rückgabe undefiniert.
+ * Ring von Puffern zwischen dem Programm und dem Thread einer Datei. Der
+ * Erzeuger füllt die Puffer reihum, der Verbraucher leert sie in derselben
+ * Reihenfolge. Beim Lesen ist der Thread der Erzeuger, beim Schreiben der
+ * Verbraucher.
  */
-#define GET_BIT(C, POS) ((C) >> (7 - (POS)) & (unsigned char) 0x01)
+struct IO_PIPELINE
+{
+    /** Datei, aus der der Thread liest bzw. in die er schreibt */
+    FILE *stream;
 
-/**
- * Schreibt das Bit BIT an der Position POS in das Zeichen C. Ist POS 
- * gleich 0, wird das höchstwertigste Bit geliefert, für POS gleich 7 wird  
- * das niederwertigste Bit geliefert. Es wird davon ausgegangen, dass POS 
- * einen Wert zwischen 0 und 7 hat. Ansonsten ist die Rückgabe undefiniert.
- */
-#define PUT_BIT(C, BIT, POS) ((C) | ((unsigned char) (BIT) << (7 - (POS))))
+    /** Der Thread */
+    pthread_t thread;
+
+    /** Speicher der PIPELINE_BUF_COUNT Puffer hintereinander */
+    unsigned char *memory;
+
+    /** Anzahl der gültigen Zeichen je Puffer */
+    size_t length[PIPELINE_BUF_COUNT];
+
+    /** Anzahl der gefüllten, noch nicht geleerten Puffer */
+    int filled;
+
+    /** Nächster vom Erzeuger zu füllender Puffer */
+    int produce;
+
+    /** Nächster vom Verbraucher zu leerender Puffer */
+    int consume;
+
+    /** true, wenn der Erzeuger keine weiteren Puffer füllt */
+    bool finished;
+
+    /** true, wenn der Verbraucher keine weiteren Puffer annimmt */
+    bool stopped;
+
+    /** errno des ersten Fehlers des Threads, 0 wenn keiner auftrat */
+    int error;
+
+    /** Schützt filled, produce, consume, finished, stopped und error */
+    pthread_mutex_t mutex;
+
+    /** Signalisiert gefüllte Puffer oder das Ende des Erzeugers */
+    pthread_cond_t has_filled;
+
+    /** Signalisiert geleerte Puffer oder das Ende des Verbrauchers */
+    pthread_cond_t has_empty;
+
+    /**
+     * Nur im Programm: Puffer, den es gerade liest (Eingabe) bzw. füllt
+     * (Ausgabe), sonst NULL
+     */
+    unsigned char *current;
+
+    /** Nur im Programm: Anzahl der Zeichen in current beim Füllen */
+    size_t current_length;
+};
 
 
 /* ============================================================================
@@ -53,39 +124,184 @@
  * ========================================================================= */
 
 /**
- * Gibt den Fehler aus, der beim Versuch eine Datei zu oeffnen oder zu schliessen,
- * aufgetreten ist, und bricht dann das Programm ab.
+ * Meldet den Fehler (errno), der beim Versuch eine Datei zu oeffnen, zu
+ * lesen, zu schreiben oder zu schliessen, aufgetreten ist, mit trap_raise.
  */
 static void report_error_and_exit(void);
 
+/**
+ * Füllt den Bitpuffer für das Lesen mit ganzen Zeichen aus dem Eingabestrom
+ * auf.
+ *
+ * @param reader    Kontext des Eingabestroms
+ */
+static void refill_bits(READER *reader);
 
-/* ============================================================================
- * Globale Variablen
- * ========================================================================= */
+/**
+ * Prüft, ob eine Datei regulär ist, und liefert ihre Größe.
+ *
+ * @param stream    geöffnete Datei
+ * @param size      Größe der Datei (Ausgabe, nur bei regulären Dateien)
+ * @return          true bei einer regulären Datei, false z.B. bei Pipes
+ */
+static bool regular_file_size(FILE *stream, uint64_t *size);
+
+/**
+ * Blendet die geöffnete Eingabedatei in den Speicher ein, wenn es sich um
+ * eine nicht leere reguläre Datei handelt.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @return          true, wenn die Datei eingeblendet wurde
+ */
+static bool map_file(READER *reader);
+
+/**
+ * Schreibt den Inhalt des Ausgabepuffers in die Datei bzw. den
+ * Speicherbereich und leert den Puffer.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ */
+static void flush_buffer(WRITER *writer);
+
+/**
+ * Liest bis zu n Zeichen direkt aus der Eingabedatei. Ein Lesefehler wird
+ * gemeldet (report_error_and_exit), statt die Eingabe wie am Dateiende
+ * enden zu lassen.
+ *
+ * @param reader    Kontext des Eingabestroms (Datei)
+ * @param dst       Speicher für die Zeichen
+ * @param n         Anzahl der zu lesenden Zeichen
+ * @return          Anzahl der gelesenen Zeichen, weniger als n nur am
+ *                  Dateiende
+ */
+static size_t read_stream(READER *reader, unsigned char dst[], size_t n);
+
+/**
+ * Hängt n Zeichen an den Speicherbereich des Ausgabestroms an und
+ * vergrößert ihn bei Bedarf. Passen sie nicht in einen Zielbereich fester
+ * Größe, wird stattdessen overflow gesetzt.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param src       anzuhängende Zeichen
+ * @param n         Anzahl der Zeichen
+ */
+static void append_memory(WRITER *writer, const unsigned char src[], size_t n);
+
+/**
+ * Schreibt n Zeichen in die Ausgabedatei, über den Thread des Ausgabestroms
+ * oder direkt.
+ *
+ * @param writer    Kontext des Ausgabestroms (Datei)
+ * @param src       zu schreibende Zeichen
+ * @param n         Anzahl der Zeichen
+ */
+static void write_stream(WRITER *writer, const unsigned char src[], size_t n);
+
+/**
+ * Legt einen Ring von Puffern an und startet den Thread, der ihn mit der
+ * Datei austauscht.
+ *
+ * @param stream        Datei
+ * @param thread_main   Hauptfunktion des Threads (read_ahead oder
+ *                      write_behind)
+ * @return              der Ring oder NULL, wenn Speicher oder Thread nicht
+ *                      angelegt werden konnten
+ */
+static IO_PIPELINE *pipeline_create(FILE *stream,
+                                    void *(*thread_main)(void *));
+
+/**
+ * Wartet auf das Ende des Threads und gibt den Ring frei.
+ *
+ * @param pipeline  Ring
+ * @return          errno des ersten Fehlers des Threads, 0 wenn keiner
+ */
+static int pipeline_destroy(IO_PIPELINE *pipeline);
+
+/**
+ * Erzeuger: wartet auf einen leeren Puffer.
+ *
+ * @param pipeline  Ring
+ * @return          der Puffer oder NULL, wenn der Verbraucher beendet ist
+ */
+static unsigned char *pipeline_acquire(IO_PIPELINE *pipeline);
+
+/**
+ * Erzeuger: übergibt den mit pipeline_acquire erhaltenen Puffer gefüllt an
+ * den Verbraucher.
+ *
+ * @param pipeline  Ring
+ * @param length    Anzahl der gültigen Zeichen im Puffer
+ */
+static void pipeline_submit(IO_PIPELINE *pipeline, size_t length);
+
+/**
+ * Erzeuger: kündigt an, dass keine weiteren Puffer folgen, und hält
+ * gegebenenfalls den Fehler fest, mit dem er endete.
+ *
+ * @param pipeline  Ring
+ * @param error     errno des Fehlers, 0 am Ende der Daten
+ */
+static void pipeline_finish(IO_PIPELINE *pipeline, int error);
 
-/** Eingabestrom */
-static FILE *in_stream;
+/**
+ * Verbraucher: wartet auf den nächsten gefüllten Puffer.
+ *
+ * @param pipeline  Ring
+ * @param length    Anzahl der gültigen Zeichen im Puffer (Ausgabe)
+ * @return          der Puffer oder NULL, wenn keiner mehr folgt
+ */
+static unsigned char *pipeline_take(IO_PIPELINE *pipeline, size_t *length);
+
+/**
+ * Verbraucher: gibt den mit pipeline_take erhaltenen Puffer geleert zurück.
+ *
+ * @param pipeline  Ring
+ * @param error     errno eines Fehlers beim Leeren, sonst 0
+ */
+static void pipeline_release(IO_PIPELINE *pipeline, int error);
 
-/** Puffer für den Eingabestrom */
-static unsigned char in_buffer[BUF_SIZE];
+/**
+ * Verbraucher: nimmt keine weiteren Puffer an.
+ *
+ * @param pipeline  Ring
+ */
+static void pipeline_stop(IO_PIPELINE *pipeline);
 
-/** Enthält die erste freie Position des Puffers nach dem letzten Zeichen */
-static int last_in_pos;
+/**
+ * Programm als Erzeuger: übergibt den angefangenen Puffer und wartet, bis
+ * der Thread alle Puffer geschrieben hat.
+ *
+ * @param pipeline  Ring
+ */
+static void pipeline_drain(IO_PIPELINE *pipeline);
 
-/** Aktuelle Position im Eingabepuffer */
-static int curr_in_pos;
+/**
+ * Hauptfunktion des Threads, der eine Datei im Voraus liest.
+ *
+ * @param arg       Ring
+ * @return          NULL
+ */
+static void *read_ahead(void *arg);
 
-/** Aktuelle Bit-Position im aktuellen Zeichen */
-static int curr_pos_in_bit;
+/**
+ * Hauptfunktion des Threads, der eine Datei im Hintergrund schreibt.
+ *
+ * @param arg       Ring
+ * @return          NULL
+ */
+static void *write_behind(void *arg);
 
-/** Ausgabestrom */
-static FILE *out_stream;
 
-/** Puffer für den Ausgabestrom */
-static unsigned char out_buffer[BUF_SIZE];
+/* ============================================================================
+ * Globale Variablen
+ * ========================================================================= */
 
-/** Nächste freie Position im Ausgabepuffer */
-static int last_out_pos;
+/** Standardkontext für die Funktionen ohne Kontext-Parameter (Eingabe) */
+static READER std_reader;
+
+/** Standardkontext für die Funktionen ohne Kontext-Parameter (Ausgabe) */
+static WRITER std_writer;
 
 
 /* ============================================================================
@@ -96,48 +312,260 @@ static int last_out_pos;
  * Oeffnen und Schliessen von Dateien
  * ------------------------------------------------------------------------- */
 
-extern void open_infile(char filename[])
+extern void reader_open(READER *reader, char filename[])
 {
     errno = 0;
-    in_stream = fopen(filename, "rb");
-    if (in_stream == NULL)
+    reader->stream = (strcmp(filename, STDIO_FILENAME) == 0)
+            ? stdin : fopen(filename, "rb");
+    if (reader->stream == NULL)
     {
         report_error_and_exit();
     }
-    last_in_pos = (int) fread(in_buffer, sizeof (unsigned char),
-                                     BUF_SIZE, in_stream);
-    curr_in_pos = 0;
-    curr_pos_in_bit = 8;
+    reader->mapping = NULL;
+    reader->pipeline = NULL;
+    reader->curr_pos = 0;
+    reader->bits = 0;
+    reader->bit_count = 0;
+
+    if (!map_file(reader))
+    {
+        uint64_t size;
+
+        /* Mit Thread liest reader_has_next_char den ersten Puffer */
+        reader->data = reader->buffer;
+        reader->last_pos = 0;
+        if (!regular_file_size(reader->stream, &size)
+                || size > PIPELINE_BUF_SIZE)
+        {
+            reader->pipeline = pipeline_create(reader->stream, read_ahead);
+        }
+        if (reader->pipeline == NULL)
+        {
+            reader->last_pos = read_stream(reader, reader->buffer, BUF_SIZE);
+        }
+    }
 }
 
-extern void close_infile(void)
+extern void reader_close(READER *reader)
 {
     errno = 0;
-    if (fclose(in_stream) == EOF)
+    if (reader->mapping != NULL)
     {
-        report_error_and_exit();
-    };
+        (void) munmap(reader->mapping, reader->last_pos);
+        reader->mapping = NULL;
+    }
+    if (reader->pipeline != NULL)
+    {
+        /* Der Thread endet spätestens nach dem laufenden Lesen */
+        pipeline_stop(reader->pipeline);
+        (void) pipeline_destroy(reader->pipeline);
+        reader->pipeline = NULL;
+    }
+    if (reader->stream != NULL && reader->stream != stdin)
+    {
+        FILE *stream = reader->stream;
+
+        /* Auch ein fehlgeschlagenes fclose gibt den Strom frei */
+        reader->stream = NULL;
+        if (fclose(stream) == EOF)
+        {
+            report_error_and_exit();
+        }
+    }
 }
 
-extern void open_outfile(char filename[])
+extern void writer_open(WRITER *writer, char filename[])
 {
+    uint64_t size;
+
     errno = 0;
-    out_stream = fopen(filename, "wb");
-    if (out_stream == NULL)
+    writer->stream = (strcmp(filename, STDIO_FILENAME) == 0)
+            ? stdout : fopen(filename, "wb");
+    if (writer->stream == NULL)
     {
         report_error_and_exit();
     }
-    last_out_pos = 0;
+    writer->last_pos = 0;
+    writer->memory = NULL;
+    writer->memory_size = 0;
+    writer->memory_capacity = 0;
+    writer->fixed = false;
+    writer->overflow = false;
+    writer->bits = 0;
+    writer->bit_count = 0;
+    writer->pipeline = NULL;
+    writer->pipeline_countdown = 0;
+
+    /* Reguläre Dateien erhalten den Thread erst, wenn sie groß werden */
+    if (regular_file_size(writer->stream, &size))
+    {
+        writer->pipeline_countdown = PIPELINE_BUF_SIZE;
+    }
+    else
+    {
+        writer->pipeline = pipeline_create(writer->stream, write_behind);
+    }
 }
 
-extern void close_outfile(void)
+extern void writer_close(WRITER *writer)
 {
     errno = 0;
-    (void) fwrite(out_buffer, sizeof(unsigned char), (size_t) last_out_pos, out_stream);
-    if (fclose(out_stream) == EOF)
+    writer_flush_bits(writer);
+    flush_buffer(writer);
+    if (writer->pipeline != NULL)
     {
-        report_error_and_exit();
-    };
+        IO_PIPELINE *pipeline = writer->pipeline;
+
+        if (pipeline->current != NULL)
+        {
+            pipeline_submit(pipeline, pipeline->current_length);
+        }
+        pipeline_finish(pipeline, 0);
+        writer->pipeline = NULL;
+        errno = pipeline_destroy(pipeline);
+        if (errno != 0)
+        {
+            report_error_and_exit();
+        }
+    }
+    if (writer->stream == stdout)
+    {
+        if (fflush(stdout) == EOF)
+        {
+            report_error_and_exit();
+        }
+    }
+    else
+    {
+        FILE *stream = writer->stream;
+
+        writer->stream = NULL;
+        if (fclose(stream) == EOF)
+        {
+            report_error_and_exit();
+        }
+    }
+}
+
+extern void reader_abort(READER *reader)
+{
+    if (reader->stream == NULL)
+    {
+        return;
+    }
+    if (reader->mapping != NULL)
+    {
+        (void) munmap(reader->mapping, reader->last_pos);
+        reader->mapping = NULL;
+    }
+    if (reader->pipeline != NULL)
+    {
+        pipeline_stop(reader->pipeline);
+        (void) pipeline_destroy(reader->pipeline);
+        reader->pipeline = NULL;
+    }
+    if (reader->stream != stdin)
+    {
+        (void) fclose(reader->stream);
+    }
+    reader->stream = NULL;
+}
+
+extern void writer_abort(WRITER *writer)
+{
+    if (writer->stream == NULL)
+    {
+        return;
+    }
+    if (writer->pipeline != NULL)
+    {
+        /* Der Thread schreibt nur noch die bereits übergebenen Puffer */
+        pipeline_finish(writer->pipeline, 0);
+        (void) pipeline_destroy(writer->pipeline);
+        writer->pipeline = NULL;
+    }
+    if (writer->stream != stdout)
+    {
+        (void) fclose(writer->stream);
+    }
+    writer->stream = NULL;
+}
+
+extern void reader_open_memory(READER *reader, const unsigned char data[],
+                               size_t size)
+{
+    reader->stream = NULL;
+    reader->mapping = NULL;
+    reader->pipeline = NULL;
+    reader->data = data;
+    reader->last_pos = size;
+    reader->curr_pos = 0;
+    reader->bits = 0;
+    reader->bit_count = 0;
+}
+
+extern void writer_open_memory(WRITER *writer)
+{
+    writer->stream = NULL;
+    writer->pipeline = NULL;
+    writer->pipeline_countdown = 0;
+    writer->last_pos = 0;
+    writer->memory = NULL;
+    writer->memory_size = 0;
+    writer->memory_capacity = 0;
+    writer->fixed = false;
+    writer->overflow = false;
+    writer->bits = 0;
+    writer->bit_count = 0;
+}
+
+extern void writer_open_buffer(WRITER *writer, unsigned char dst[],
+                               size_t capacity)
+{
+    writer_open_memory(writer);
+    writer->memory = dst;
+    writer->memory_capacity = capacity;
+    writer->fixed = true;
+}
+
+extern unsigned char *writer_close_memory(WRITER *writer, size_t *size)
+{
+    unsigned char *memory;
+
+    writer_flush_bits(writer);
+    flush_buffer(writer);
+
+    memory = writer->memory;
+    *size = writer->memory_size;
+    writer->memory = NULL;
+    writer->memory_size = 0;
+    writer->memory_capacity = 0;
+
+    return memory;
+}
+
+extern bool writer_close_buffer(WRITER *writer, size_t *size)
+{
+    writer_flush_bits(writer);
+    flush_buffer(writer);
+
+    *size = writer->memory_size;
+    writer->memory = NULL;
+    writer->memory_size = 0;
+    writer->memory_capacity = 0;
+
+    return !writer->overflow;
+}
+
+extern size_t writer_memory_size(const WRITER *writer)
+{
+    return writer->memory_size + writer->last_pos;
+}
+
+extern void writer_truncate_memory(WRITER *writer, size_t size)
+{
+    flush_buffer(writer);
+    writer->memory_size = size;
 }
 
 
@@ -145,133 +573,943 @@ extern void close_outfile(void)
  * Byteweises Lesen und Schreiben
  * ------------------------------------------------------------------------- */
 
-extern bool has_next_char(void)
+extern bool reader_has_next_char(READER *reader)
 {
     /* Buffer erneut füllen, falls letztes Zeichen ausgelesen */
-    if (curr_in_pos >= last_in_pos)
+    if (reader->curr_pos >= reader->last_pos && reader->pipeline != NULL)
+    {
+        /* Gelesenen Puffer zurückgeben und den nächsten übernehmen */
+        IO_PIPELINE *pipeline = reader->pipeline;
+
+        if (pipeline->current != NULL)
+        {
+            pipeline_release(pipeline, 0);
+        }
+        pipeline->current = pipeline_take(pipeline, &reader->last_pos);
+        if (pipeline->current == NULL)
+        {
+            reader->data = reader->buffer;
+            reader->last_pos = 0;
+
+            /* Nach dem Ende des Threads ändert sich error nicht mehr */
+            if (pipeline->error != 0)
+            {
+                errno = pipeline->error;
+                report_error_and_exit();
+            }
+        }
+        else
+        {
+            reader->data = pipeline->current;
+        }
+        reader->curr_pos = 0;
+    }
+    else if (reader->curr_pos >= reader->last_pos && reader->stream != NULL
+            && reader->mapping == NULL)
     {
-        last_in_pos = (int) fread(in_buffer, sizeof(unsigned char), 
-                                         BUF_SIZE, in_stream);
-        curr_in_pos = 0;
+        reader->last_pos = read_stream(reader, reader->buffer, BUF_SIZE);
+        reader->curr_pos = 0;
     }
-    
-    return curr_in_pos < last_in_pos;
+
+    return reader->curr_pos < reader->last_pos;
 }
 
-extern unsigned char read_char(void)
+extern unsigned char reader_read_char(READER *reader)
 {
     /* Nächstes Zeichen aus dem Buffer lesen */
-    unsigned char c = in_buffer[curr_in_pos];
-    curr_in_pos++;
+    unsigned char c = reader->data[reader->curr_pos];
+    reader->curr_pos++;
 
     return c;
 }
 
-extern void write_char(unsigned char c)
+extern void writer_write_char(WRITER *writer, unsigned char c)
 {
-    /* 
+    /*
      * Schreibt das Zeichen in den Puffer, bis dieser voll ist. Ist dieser voll,
-     * wird der Inhalt des Puffers in die Ausgabedatei geschrieben und der 
+     * wird der Inhalt des Puffers in die Ausgabedatei geschrieben und der
      * Puffer erneut gefuellt.
      */
 
     /* Zeichen an nächste freie Pufferposition schreiben */
-    out_buffer[last_out_pos] = c;
-    last_out_pos++;
+    writer->buffer[writer->last_pos] = c;
+    writer->last_pos++;
 
     /* Vollen Puffer zuerst schreiben */
-    if (last_out_pos >= BUF_SIZE)
+    if (writer->last_pos >= BUF_SIZE)
+    {
+        flush_buffer(writer);
+    }
+}
+
+extern size_t reader_read(READER *reader, unsigned char dst[], size_t n)
+{
+    size_t done = 0;
+
+    while (done < n && reader_has_next_char(reader))
+    {
+        size_t available = reader->last_pos - reader->curr_pos;
+        size_t count = (n - done < available) ? n - done : available;
+
+        memcpy(dst + done, reader->data + reader->curr_pos, count);
+        reader->curr_pos += count;
+        done += count;
+
+        /* Große Reste direkt und ohne Umweg über den Puffer lesen */
+        if (n - done >= BUF_SIZE && reader->stream != NULL
+                && reader->mapping == NULL && reader->pipeline == NULL)
+        {
+            done += read_stream(reader, dst + done, n - done);
+        }
+    }
+
+    return done;
+}
+
+extern bool reader_skip(READER *reader, uint64_t n)
+{
+    while (n > 0 && reader_has_next_char(reader))
     {
-        (void) fwrite(out_buffer, sizeof(unsigned char), BUF_SIZE, out_stream);
-        last_out_pos = 0;
+        size_t available = reader->last_pos - reader->curr_pos;
+        size_t count = (n < available) ? (size_t) n : available;
+
+        reader->curr_pos += count;
+        n -= count;
     }
+
+    return n == 0;
+}
+
+extern void writer_write(WRITER *writer, const unsigned char src[], size_t n)
+{
+    if (writer->last_pos + n < BUF_SIZE)
+    {
+        memcpy(writer->buffer + writer->last_pos, src, n);
+        writer->last_pos += n;
+    }
+    else
+    {
+        /* Große Blöcke direkt und ohne Umweg über den Puffer schreiben */
+        flush_buffer(writer);
+        if (writer->stream != NULL)
+        {
+            write_stream(writer, src, n);
+        }
+        else
+        {
+            append_memory(writer, src, n);
+        }
+    }
+}
+
+extern const unsigned char *reader_take_rest(READER *reader, size_t *size)
+{
+    const unsigned char *data;
+
+    if (reader->stream != NULL && reader->mapping == NULL)
+    {
+        return NULL;
+    }
+    data = reader->data + reader->curr_pos;
+    *size = reader->last_pos - reader->curr_pos;
+    reader->curr_pos = reader->last_pos;
+
+    return data;
+}
+
+extern const unsigned char *reader_span(READER *reader, size_t *size)
+{
+    if (reader->stream != NULL && reader->mapping == NULL)
+    {
+        return NULL;
+    }
+    *size = reader->last_pos;
+
+    return reader->data;
+}
+
+extern bool reader_size(READER *reader, uint64_t *size)
+{
+    struct stat attribut;
+
+    if (reader->stream == NULL || reader->mapping != NULL)
+    {
+        *size = reader->last_pos;
+        return true;
+    }
+    if (fstat(fileno(reader->stream), &attribut) != 0
+            || !S_ISREG(attribut.st_mode))
+    {
+        return false;
+    }
+    *size = (uint64_t) attribut.st_size;
+
+    return true;
+}
+
+extern bool reader_read_at(READER *reader, unsigned char dst[], size_t n,
+                           uint64_t offset)
+{
+    size_t done = 0;
+
+    if (reader->stream == NULL || reader->mapping != NULL)
+    {
+        if (offset > reader->last_pos || n > reader->last_pos - offset)
+        {
+            return false;
+        }
+        memcpy(dst, reader->data + offset, n);
+        return true;
+    }
+
+    while (done < n)
+    {
+        ssize_t count = pread(fileno(reader->stream), dst + done, n - done,
+                              (off_t) (offset + done));
+        if (count <= 0)
+        {
+            return false;
+        }
+        done += (size_t) count;
+    }
+
+    return true;
+}
+
+extern bool writer_set_size(WRITER *writer, uint64_t size)
+{
+    struct stat attribut;
+
+    if (writer->stream == NULL || writer->stream == stdout)
+    {
+        return false;
+    }
+
+    /* writer_write_at schreibt an der Pufferung vorbei */
+    flush_buffer(writer);
+    if (writer->pipeline != NULL)
+    {
+        pipeline_drain(writer->pipeline);
+    }
+    (void) fflush(writer->stream);
+
+    return fstat(fileno(writer->stream), &attribut) == 0
+            && S_ISREG(attribut.st_mode)
+            && ftruncate(fileno(writer->stream), (off_t) size) == 0;
+}
+
+extern void writer_write_at(WRITER *writer, const unsigned char src[],
+                            size_t n, uint64_t offset)
+{
+    size_t done = 0;
+
+    while (done < n)
+    {
+        ssize_t count;
+
+        errno = 0;
+        count = pwrite(fileno(writer->stream), src + done, n - done,
+                       (off_t) (offset + done));
+        if (count <= 0)
+        {
+            report_error_and_exit();
+        }
+        done += (size_t) count;
+    }
+}
+
+extern bool writer_copy_at(WRITER *writer, READER *reader, uint64_t in_offset,
+                           size_t n, uint64_t out_offset)
+{
+    unsigned char *buffer;
+    size_t done = 0;
+
+#ifdef HAVE_COPY_FILE_RANGE
+    /*
+     * Der Kern kopiert zwischen den Dateien (bei manchen Dateisystemen
+     * sogar ohne die Daten zu kopieren). Schlägt das fehl, etwa bei
+     * verschiedenen Dateisystemen in älteren Kernen, wird der Rest
+     * gewöhnlich kopiert.
+     */
+    if (reader->stream != NULL)
+    {
+        while (done < n)
+        {
+            loff_t in_pos = (loff_t) (in_offset + done);
+            loff_t out_pos = (loff_t) (out_offset + done);
+            ssize_t count = copy_file_range(fileno(reader->stream), &in_pos,
+                                            fileno(writer->stream), &out_pos,
+                                            n - done, 0);
+            if (count <= 0)
+            {
+                break;
+            }
+            done += (size_t) count;
+        }
+    }
+#endif
+
+    /* Eingeblendete Dateien direkt, andere über einen Zwischenpuffer */
+    if (reader->stream == NULL || reader->mapping != NULL)
+    {
+        if (in_offset > reader->last_pos || n > reader->last_pos - in_offset)
+        {
+            return false;
+        }
+        writer_write_at(writer, reader->data + in_offset + done, n - done,
+                        out_offset + done);
+        return true;
+    }
+
+    buffer = (unsigned char *) malloc(COPY_BUF_SIZE);
+    if (buffer == NULL)
+    {
+        trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+    }
+    while (done < n)
+    {
+        size_t chunk = (n - done < COPY_BUF_SIZE) ? n - done : COPY_BUF_SIZE;
+
+        if (!reader_read_at(reader, buffer, chunk, in_offset + done))
+        {
+            free(buffer);
+            return false;
+        }
+        writer_write_at(writer, buffer, chunk, out_offset + done);
+        done += chunk;
+    }
+    free(buffer);
+
+    return true;
+}
+
+static void flush_buffer(WRITER *writer)
+{
+    if (writer->stream != NULL)
+    {
+        write_stream(writer, writer->buffer, writer->last_pos);
+    }
+    else
+    {
+        append_memory(writer, writer->buffer, writer->last_pos);
+    }
+    writer->last_pos = 0;
+}
+
+static void write_stream(WRITER *writer, const unsigned char src[], size_t n)
+{
+    IO_PIPELINE *pipeline = writer->pipeline;
+
+    if (pipeline == NULL)
+    {
+        errno = 0;
+        if (fwrite(src, sizeof(unsigned char), n, writer->stream) != n)
+        {
+            report_error_and_exit();
+        }
+
+        /* Ab PIPELINE_BUF_SIZE Zeichen im Hintergrund weiterschreiben */
+        if (writer->pipeline_countdown > n)
+        {
+            writer->pipeline_countdown -= n;
+        }
+        else if (writer->pipeline_countdown > 0)
+        {
+            writer->pipeline_countdown = 0;
+            errno = 0;
+            if (fflush(writer->stream) == EOF)
+            {
+                report_error_and_exit();
+            }
+            writer->pipeline = pipeline_create(writer->stream, write_behind);
+        }
+        return;
+    }
+
+    /* In die Puffer des Rings kopieren, volle Puffer dem Thread übergeben */
+    while (n > 0)
+    {
+        size_t count;
+
+        if (pipeline->current == NULL)
+        {
+            pipeline->current = pipeline_acquire(pipeline);
+            pipeline->current_length = 0;
+        }
+        count = PIPELINE_BUF_SIZE - pipeline->current_length;
+        if (count > n)
+        {
+            count = n;
+        }
+        memcpy(pipeline->current + pipeline->current_length, src, count);
+        pipeline->current_length += count;
+        src += count;
+        n -= count;
+
+        if (pipeline->current_length == PIPELINE_BUF_SIZE)
+        {
+            pipeline_submit(pipeline, PIPELINE_BUF_SIZE);
+            pipeline->current = NULL;
+        }
+    }
+}
+
+static size_t read_stream(READER *reader, unsigned char dst[], size_t n)
+{
+    size_t count;
+
+    errno = 0;
+    count = fread(dst, sizeof (unsigned char), n, reader->stream);
+    if (count < n && ferror(reader->stream))
+    {
+        errno = (errno != 0) ? errno : EIO;
+        report_error_and_exit();
+    }
+
+    return count;
+}
+
+static void append_memory(WRITER *writer, const unsigned char src[], size_t n)
+{
+    if (n == 0 || writer->overflow)
+    {
+        return;
+    }
+    if (writer->fixed && n > writer->memory_capacity - writer->memory_size)
+    {
+        writer->overflow = true;
+        return;
+    }
+    if (writer->memory_size + n > writer->memory_capacity)
+    {
+        size_t capacity = (writer->memory_capacity > 0)
+                ? writer->memory_capacity : BUF_SIZE;
+        unsigned char *memory;
+
+        while (capacity < writer->memory_size + n)
+        {
+            capacity *= 2;
+        }
+        memory = (unsigned char *) realloc(writer->memory, capacity);
+        if (memory == NULL)
+        {
+            trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+        }
+        writer->memory = memory;
+        writer->memory_capacity = capacity;
+    }
+
+    memcpy(writer->memory + writer->memory_size, src, n);
+    writer->memory_size += n;
 }
 
 /* ----------------------------------------------------------------------------
- * Bitweises Lesen und Schreiben
+ * Vorauslesen und Schreiben im Hintergrund
  * ------------------------------------------------------------------------- */
 
-extern bool has_next_bit(void)
+static IO_PIPELINE *pipeline_create(FILE *stream,
+                                    void *(*thread_main)(void *))
 {
-    return curr_pos_in_bit < 8 || has_next_char();
+    IO_PIPELINE *pipeline = (IO_PIPELINE *) malloc(sizeof (IO_PIPELINE));
+
+    if (pipeline == NULL)
+    {
+        return NULL;
+    }
+    pipeline->memory = (unsigned char *) malloc((size_t) PIPELINE_BUF_COUNT
+                                                * PIPELINE_BUF_SIZE);
+    if (pipeline->memory == NULL)
+    {
+        free(pipeline);
+        return NULL;
+    }
+    pipeline->stream = stream;
+    pipeline->filled = 0;
+    pipeline->produce = 0;
+    pipeline->consume = 0;
+    pipeline->finished = false;
+    pipeline->stopped = false;
+    pipeline->error = 0;
+    pipeline->current = NULL;
+    pipeline->current_length = 0;
+    pthread_mutex_init(&pipeline->mutex, NULL);
+    pthread_cond_init(&pipeline->has_filled, NULL);
+    pthread_cond_init(&pipeline->has_empty, NULL);
+
+    /* Ohne Thread wird die Datei wie bisher direkt gelesen bzw. geschrieben */
+    if (pthread_create(&pipeline->thread, NULL, thread_main, pipeline) != 0)
+    {
+        pthread_mutex_destroy(&pipeline->mutex);
+        pthread_cond_destroy(&pipeline->has_filled);
+        pthread_cond_destroy(&pipeline->has_empty);
+        free(pipeline->memory);
+        free(pipeline);
+        return NULL;
+    }
+
+    return pipeline;
 }
 
-extern BIT read_bit(void)
+static int pipeline_destroy(IO_PIPELINE *pipeline)
 {
-    /* 
-     * Liest so lange aus dem Puffer, bis dieser leer ist. Ist dieser leer,
-     * wird der Inhalt des Puffers aus der Eingabedatei erneut gefuellt.
+    int error;
+
+    (void) pthread_join(pipeline->thread, NULL);
+    error = pipeline->error;
+    pthread_mutex_destroy(&pipeline->mutex);
+    pthread_cond_destroy(&pipeline->has_filled);
+    pthread_cond_destroy(&pipeline->has_empty);
+    free(pipeline->memory);
+    free(pipeline);
+
+    return error;
+}
+
+static unsigned char *pipeline_acquire(IO_PIPELINE *pipeline)
+{
+    unsigned char *buffer = NULL;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->filled == PIPELINE_BUF_COUNT && !pipeline->stopped)
+    {
+        pthread_cond_wait(&pipeline->has_empty, &pipeline->mutex);
+    }
+    if (!pipeline->stopped)
+    {
+        buffer = pipeline->memory
+                + (size_t) pipeline->produce * PIPELINE_BUF_SIZE;
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    return buffer;
+}
+
+static void pipeline_submit(IO_PIPELINE *pipeline, size_t length)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->length[pipeline->produce] = length;
+    pipeline->produce = (pipeline->produce + 1) % PIPELINE_BUF_COUNT;
+    pipeline->filled++;
+    pthread_cond_signal(&pipeline->has_filled);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void pipeline_finish(IO_PIPELINE *pipeline, int error)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    if (error != 0 && pipeline->error == 0)
+    {
+        pipeline->error = error;
+    }
+    pipeline->finished = true;
+    pthread_cond_broadcast(&pipeline->has_filled);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static unsigned char *pipeline_take(IO_PIPELINE *pipeline, size_t *length)
+{
+    unsigned char *buffer = NULL;
+
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->filled == 0 && !pipeline->finished)
+    {
+        pthread_cond_wait(&pipeline->has_filled, &pipeline->mutex);
+    }
+    if (pipeline->filled > 0)
+    {
+        buffer = pipeline->memory
+                + (size_t) pipeline->consume * PIPELINE_BUF_SIZE;
+        *length = pipeline->length[pipeline->consume];
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+
+    return buffer;
+}
+
+static void pipeline_release(IO_PIPELINE *pipeline, int error)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    if (pipeline->error == 0)
+    {
+        pipeline->error = error;
+    }
+    pipeline->consume = (pipeline->consume + 1) % PIPELINE_BUF_COUNT;
+    pipeline->filled--;
+    pthread_cond_signal(&pipeline->has_empty);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void pipeline_stop(IO_PIPELINE *pipeline)
+{
+    pthread_mutex_lock(&pipeline->mutex);
+    pipeline->stopped = true;
+    pthread_cond_broadcast(&pipeline->has_empty);
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void pipeline_drain(IO_PIPELINE *pipeline)
+{
+    if (pipeline->current != NULL)
+    {
+        pipeline_submit(pipeline, pipeline->current_length);
+        pipeline->current = NULL;
+    }
+
+    pthread_mutex_lock(&pipeline->mutex);
+    while (pipeline->filled > 0)
+    {
+        pthread_cond_wait(&pipeline->has_empty, &pipeline->mutex);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+}
+
+static void *read_ahead(void *arg)
+{
+    IO_PIPELINE *pipeline = (IO_PIPELINE *) arg;
+    unsigned char *buffer;
+    int error = 0;
+
+    /*
+     * fread kehrt erst mit einem vollen Puffer oder am Dateiende zurück.
+     * Einen Lesefehler meldet das Programm, sobald es die bis dahin
+     * gelesenen Puffer verbraucht hat.
      */
+    while ((buffer = pipeline_acquire(pipeline)) != NULL)
+    {
+        size_t length;
+
+        errno = 0;
+        length = fread(buffer, sizeof (unsigned char), PIPELINE_BUF_SIZE,
+                       pipeline->stream);
+        if (length > 0)
+        {
+            pipeline_submit(pipeline, length);
+        }
+        if (length < PIPELINE_BUF_SIZE)
+        {
+            if (ferror(pipeline->stream))
+            {
+                error = (errno != 0) ? errno : EIO;
+            }
+            break;
+        }
+    }
+    pipeline_finish(pipeline, error);
+
+    return NULL;
+}
 
-    /* Das aktuelle Zeichen */
-    static int c = EOF;
+static void *write_behind(void *arg)
+{
+    IO_PIPELINE *pipeline = (IO_PIPELINE *) arg;
+    const unsigned char *buffer;
+    size_t length;
 
-    /* das aktuelle Bit */
-    BIT bit;
-    
-    /* das allererste Zeichen holen, weil statische Variable nicht mit 
-     * Rückgabe einer Funktion initialisiert werden kann */
-    if (curr_pos_in_bit % 8 == 0 && has_next_char())
+    /* Nach einem Fehler werden die übrigen Puffer nur noch verworfen */
+    while ((buffer = pipeline_take(pipeline, &length)) != NULL)
     {
-        c = read_char();
-        curr_pos_in_bit = 0;
+        int error = 0;
+
+        errno = 0;
+        if (pipeline->error == 0
+                && fwrite(buffer, sizeof (unsigned char), length,
+                          pipeline->stream) != length)
+        {
+            error = (errno != 0) ? errno : EIO;
+        }
+        pipeline_release(pipeline, error);
     }
-    
-    /* Bit aus dem aktuellen Zeichen auslesen und weitersetzen */
-    bit = GET_BIT(c, curr_pos_in_bit);
-    curr_pos_in_bit++;
-    
+
+    return NULL;
+}
+
+/* ----------------------------------------------------------------------------
+ * Bitweises Lesen und Schreiben
+ * ------------------------------------------------------------------------- */
+
+extern bool reader_has_next_bit(READER *reader)
+{
+    return reader->bit_count > 0 || reader_has_next_char(reader);
+}
+
+extern BIT reader_read_bit(READER *reader)
+{
+    BIT bit = (BIT) reader_peek_bits(reader, 1);
+    reader_consume_bits(reader, 1);
+
     return bit;
 }
 
-extern void write_bit(BIT bit)
+extern void writer_write_bit(WRITER *writer, BIT bit)
+{
+    writer_write_bits(writer, (uint32_t) bit, 1);
+}
+
+extern bool reader_has_next_bits(READER *reader, int n)
 {
-    /* 
-     * Schreibt so lange in den Puffer, bis dieser voll ist. Ist dieser voll,
-     * wird der Inhalt des Puffers in die Ausgabedatei geschrieben und der 
-     * Puffer erneut gefüllt.
+    if (reader->bit_count < n)
+    {
+        refill_bits(reader);
+    }
+
+    return reader->bit_count >= n;
+}
+
+extern uint32_t reader_peek_bits(READER *reader, int n)
+{
+    if (reader->bit_count < n)
+    {
+        refill_bits(reader);
+
+        /* Am Dateiende fehlende Bits als 0-Bits ergänzen */
+        if (reader->bit_count < n)
+        {
+            return (uint32_t) (reader->bits << (n - reader->bit_count))
+                    & (uint32_t) (((uint64_t) 1 << n) - 1);
+        }
+    }
+
+    return (uint32_t) (reader->bits >> (reader->bit_count - n))
+            & (uint32_t) (((uint64_t) 1 << n) - 1);
+}
+
+extern void reader_consume_bits(READER *reader, int n)
+{
+    reader->bit_count = (n < reader->bit_count) ? reader->bit_count - n : 0;
+}
+
+extern void writer_write_bits(WRITER *writer, uint32_t code, int n)
+{
+    /*
+     * Die Bits werden im Akkumulator gesammelt. Erst wenn mindestens 32 Bits
+     * vorliegen, werden vier ganze Zeichen auf einmal in den Puffer
+     * geschrieben.
      */
+    writer->bits = (writer->bits << n)
+            | (code & (uint32_t) (((uint64_t) 1 << n) - 1));
+    writer->bit_count += n;
 
-    /* das aktuelle Zeichen */
-    static unsigned char c;
-    
-    /* die aktuelle Bit-Position im aktuellen Zeichen */
-    static int bit_pos = 0;
-    
-    /* Bit im aktuellen Zeichen setzen */
-    c = PUT_BIT(c, bit, bit_pos);
-    bit_pos++;
-    
-    /* Wenn Byte voll, dann Zeichen schreiben */
-    if (bit_pos == 8)
+    if (writer->bit_count >= 32)
     {
-        write_char((unsigned char) c);
-        bit_pos = 0;
-        c = '\0';
+        writer->bit_count -= 32;
+        writer_write_char(writer, (unsigned char) (writer->bits
+                                                   >> (writer->bit_count + 24)));
+        writer_write_char(writer, (unsigned char) (writer->bits
+                                                   >> (writer->bit_count + 16)));
+        writer_write_char(writer, (unsigned char) (writer->bits
+                                                   >> (writer->bit_count + 8)));
+        writer_write_char(writer, (unsigned char) (writer->bits
+                                                   >> writer->bit_count));
+    }
+}
+
+extern void writer_flush_bits(WRITER *writer)
+{
+    /* Restliche Bits schreiben, letztes Zeichen mit 0-Bits auffüllen */
+    while (writer->bit_count > 0)
+    {
+        if (writer->bit_count >= 8)
+        {
+            writer->bit_count -= 8;
+            writer_write_char(writer, (unsigned char) (writer->bits
+                                                       >> writer->bit_count));
+        }
+        else
+        {
+            writer_write_char(writer, (unsigned char) (writer->bits
+                                                       << (8 - writer->bit_count)));
+            writer->bit_count = 0;
+        }
+    }
+    writer->bits = 0;
+}
+
+static bool regular_file_size(FILE *stream, uint64_t *size)
+{
+    struct stat attribut;
+
+    if (fstat(fileno(stream), &attribut) != 0 || !S_ISREG(attribut.st_mode))
+    {
+        return false;
+    }
+    *size = (attribut.st_size > 0) ? (uint64_t) attribut.st_size : 0;
+
+    return true;
+}
+
+static bool map_file(READER *reader)
+{
+    struct stat attribut;
+    void *mapping;
+
+    if (fstat(fileno(reader->stream), &attribut) != 0
+            || !S_ISREG(attribut.st_mode) || attribut.st_size <= 0
+            || (uint64_t) attribut.st_size > (uint64_t) SIZE_MAX)
+    {
+        return false;
+    }
+
+    /* Eine umgeleitete Standardeingabe nur vom Dateianfang an einblenden */
+    if (reader->stream == stdin && lseek(fileno(stdin), 0, SEEK_CUR) != 0)
+    {
+        return false;
+    }
+
+    mapping = mmap(NULL, (size_t) attribut.st_size, PROT_READ, MAP_PRIVATE,
+                   fileno(reader->stream), 0);
+    if (mapping == MAP_FAILED)
+    {
+        return false;
+    }
+
+    /*
+     * Die Datei wird (mindestens beim Komprimieren zweimal) von vorne nach
+     * hinten gelesen; große Seiten verringern die Zahl der TLB-Fehlgriffe.
+     * Beides sind nur Hinweise an den Kern, Fehler werden ignoriert.
+     */
+    (void) madvise(mapping, (size_t) attribut.st_size, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    (void) madvise(mapping, (size_t) attribut.st_size, MADV_HUGEPAGE);
+#endif
+
+    reader->mapping = mapping;
+    reader->data = (const unsigned char *) mapping;
+    reader->last_pos = (size_t) attribut.st_size;
+
+    return true;
+}
+
+static void refill_bits(READER *reader)
+{
+    /*
+     * So viele ganze Zeichen nachladen, wie in den Akkumulator passen. Ein
+     * Nachladen ist damit erst nach mindestens 32 gelesenen Bits wieder
+     * nötig.
+     */
+    while (reader->bit_count <= BIT_BUF_BITS - 8
+           && (reader->curr_pos < reader->last_pos
+               || reader_has_next_char(reader)))
+    {
+        reader->bits = (reader->bits << 8) | reader->data[reader->curr_pos];
+        reader->curr_pos++;
+        reader->bit_count += 8;
     }
 }
 
+/* ----------------------------------------------------------------------------
+ * Funktionen auf den Standardkontexten
+ * ------------------------------------------------------------------------- */
+
+extern void open_infile(char filename[])
+{
+    reader_open(&std_reader, filename);
+}
+
+extern void close_infile(void)
+{
+    reader_close(&std_reader);
+}
+
+extern void open_outfile(char filename[])
+{
+    writer_open(&std_writer, filename);
+}
+
+extern void close_outfile(void)
+{
+    writer_close(&std_writer);
+}
+
+extern bool has_next_char(void)
+{
+    return reader_has_next_char(&std_reader);
+}
+
+extern unsigned char read_char(void)
+{
+    return reader_read_char(&std_reader);
+}
+
+extern void write_char(unsigned char c)
+{
+    writer_write_char(&std_writer, c);
+}
+
+extern bool has_next_bit(void)
+{
+    return reader_has_next_bit(&std_reader);
+}
+
+extern BIT read_bit(void)
+{
+    return reader_read_bit(&std_reader);
+}
+
+extern void write_bit(BIT bit)
+{
+    writer_write_bit(&std_writer, bit);
+}
+
+extern bool has_next_bits(int n)
+{
+    return reader_has_next_bits(&std_reader, n);
+}
+
+extern uint32_t peek_bits(int n)
+{
+    return reader_peek_bits(&std_reader, n);
+}
+
+extern void consume_bits(int n)
+{
+    reader_consume_bits(&std_reader, n);
+}
+
+extern void write_bits(uint32_t code, int n)
+{
+    writer_write_bits(&std_writer, code, n);
+}
+
+extern void flush_bits(void)
+{
+    writer_flush_bits(&std_writer);
+}
+
 /* ----------------------------------------------------------------------------
  * Fehlerbehandlung
  * ------------------------------------------------------------------------- */
 
 static void report_error_and_exit(void)
 {
+    const char *message;
+
     switch (errno)
     {
     case ENOENT:
-        fprintf(stderr, "[ERROR] (%d): No such file or directory.\n", errno);
+        message = "No such file or directory.";
         break;
     case EIO:
-        fprintf(stderr, "[ERROR] (%d): I/O error.\n", errno);
+        message = "I/O error.";
         break;
     case EMFILE:
-        fprintf(stderr, "[ERROR] (%d): Too many open files.\n", errno);
+        message = "Too many open files.";
+        break;
+    case ENOMEM:
+        message = "Out of memory.";
+        break;
+    case ENOSPC:
+        message = "No space left on device.";
+        break;
+    case EISDIR:
+        message = "Is a directory.";
+        break;
+    case EFBIG:
+        message = "File too large.";
         break;
     default:
-        fprintf(stderr, "[ERROR] (%d): unknown error.\n", errno);
+        message = "unknown error.";
         break;
     }
 
-    exit(EXIT_IO_ERROR); /* Todo Richtigen Fehlercode eintragen */
+    trap_raise(EXIT_IO_ERROR, message);
 }
@@ -1,10 +1,28 @@
 /**
  * @file
  * In diesem Modul wird der Dateizugriff realisiert. Die zu lesenden und
- * zu schreibenden Daten werden gepuffert, so dass blockweise gelesen und 
- * geschrieben wird. Das Modul bietet Funktionen an, um bit- und byteweise 
+ * zu schreibenden Daten werden gepuffert, so dass blockweise gelesen und
+ * geschrieben wird. Das Modul bietet Funktionen an, um bit- und byteweise
  * zu lesen und zu schreiben.
  *
+ * Der gesamte Zustand eines Ein- bzw. Ausgabestroms liegt in einem Kontext
+ * (READER bzw. WRITER), der jeder Funktion übergeben wird. Damit können
+ * mehrere Ströme gleichzeitig, auch in verschiedenen Threads, verwendet
+ * werden. Die Funktionen ohne Kontext arbeiten auf je einem Standardkontext
+ * für die Ein- und die Ausgabe.
+ *
+ * Dateien, die nicht eingeblendet werden können (z.B. Pipes), liest ein
+ * eigener Thread im Voraus in einen Ring aus PIPELINE_BUF_COUNT Puffern;
+ * ebenso schreibt ein eigener Thread die Ausgabe im Hintergrund. So wartet
+ * das Kodieren nicht auf die Datei und die Datei nicht auf das Kodieren.
+ * Bei regulären Dateien lohnen sich Thread und Ring erst ab
+ * PIPELINE_BUF_SIZE Zeichen; kleinere werden direkt gelesen bzw.
+ * geschrieben, die Ausgabe bis dahin ebenso.
+ *
+ * Ein-/Ausgabefehler werden mit trap_raise (EXIT_IO_ERROR) gemeldet: Ist im
+ * Thread eine Fehlerfalle gesetzt, kehren sie zu ihr zurück, sonst brechen
+ * sie das Programm ab.
+ *
  * @author Ulrike Griefahn
  * @date 2017-12-01
  */
@@ -13,82 +31,617 @@
 #define	IO_H
 /* ------------------------------------------------------------------------- */
 
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/**
+ * Blockgröße, mit der aus der Eingabedatei gelesen und in die Ausgabedatei
+ * geschrieben wird.
+ */
+#define BUF_SIZE 4096
+
+/**
+ * Dateiname, der für die Standardeingabe bzw. Standardausgabe steht
+ */
+#define STDIO_FILENAME "-"
+
+/**
+ * Größe der Puffer, mit denen die Threads für das Vorauslesen und das
+ * Schreiben im Hintergrund arbeiten
+ */
+#define PIPELINE_BUF_SIZE (1024 * 1024)
+
+/**
+ * Anzahl der Puffer je Thread: einer wird gelesen bzw. gefüllt, während
+ * die übrigen von der Datei gefüllt bzw. in die Datei geschrieben werden
+ */
+#define PIPELINE_BUF_COUNT 3
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Ring von Puffern zwischen dem Programm und einem Thread, der die Datei
+ * im Voraus liest bzw. im Hintergrund schreibt (Aufbau nur im Modul
+ * bekannt)
+ */
+typedef struct IO_PIPELINE IO_PIPELINE;
+
+/**
+ * Kontext eines Eingabestroms. Gelesen wird entweder aus einer Datei oder
+ * direkt aus einem Speicherbereich. Reguläre Dateien werden, wenn möglich,
+ * vollständig in den Speicher eingeblendet (mmap) und dann wie ein
+ * Speicherbereich gelesen; andere Dateien werden gepuffert und, wenn
+ * möglich, von einem eigenen Thread im Voraus gelesen.
+ */
+typedef struct
+{
+    /** Eingabestrom, NULL beim Lesen aus dem Speicher */
+    FILE *stream;
+
+    /** In den Speicher eingeblendete Datei oder NULL */
+    void *mapping;
+
+    /** Thread, der die Datei im Voraus liest, oder NULL */
+    IO_PIPELINE *pipeline;
+
+    /** Puffer für den Eingabestrom */
+    unsigned char buffer[BUF_SIZE];
+
+    /** Die aktuell gelesenen Daten (buffer oder der Speicherbereich) */
+    const unsigned char *data;
+
+    /** Enthält die erste freie Position des Puffers nach dem letzten Zeichen */
+    size_t last_pos;
+
+    /** Aktuelle Position im Eingabepuffer */
+    size_t curr_pos;
+
+    /**
+     * Bitpuffer für das bitweise Lesen. Die gültigen Bits stehen in den
+     * bit_count niederwertigsten Bits, das nächste zu lesende Bit ist das
+     * höchstwertige davon.
+     */
+    uint64_t bits;
+
+    /** Anzahl der gültigen Bits im Bitpuffer */
+    int bit_count;
+} READER;
+
+/**
+ * Kontext eines Ausgabestroms. Geschrieben wird entweder in eine Datei, in
+ * einen dynamisch wachsenden Speicherbereich oder in einen Zielbereich
+ * fester Größe. Dateien werden, wenn möglich, von einem eigenen Thread im
+ * Hintergrund geschrieben.
+ */
+typedef struct
+{
+    /** Ausgabestrom, NULL beim Schreiben in den Speicher */
+    FILE *stream;
+
+    /** Thread, der die Datei im Hintergrund schreibt, oder NULL */
+    IO_PIPELINE *pipeline;
+
+    /**
+     * Anzahl der Zeichen, die noch direkt in eine reguläre Datei geschrieben
+     * werden, bevor der Thread gestartet wird; 0, wenn keiner (mehr)
+     * gestartet wird
+     */
+    size_t pipeline_countdown;
+
+    /** Puffer für den Ausgabestrom */
+    unsigned char buffer[BUF_SIZE];
+
+    /** Nächste freie Position im Ausgabepuffer */
+    size_t last_pos;
+
+    /** Speicherbereich beim Schreiben in den Speicher */
+    unsigned char *memory;
+
+    /** Anzahl der in den Speicherbereich geschriebenen Zeichen */
+    size_t memory_size;
+
+    /** Größe des Speicherbereichs */
+    size_t memory_capacity;
+
+    /**
+     * true: memory ist ein Zielbereich des Aufrufers, der nicht vergrößert
+     * wird
+     */
+    bool fixed;
+
+    /** true, wenn Zeichen nicht mehr in den Zielbereich passten */
+    bool overflow;
+
+    /**
+     * Bitpuffer für das bitweise Schreiben. Die noch nicht geschriebenen
+     * Bits stehen in den bit_count niederwertigsten Bits.
+     */
+    uint64_t bits;
+
+    /** Anzahl der noch nicht geschriebenen Bits im Bitpuffer */
+    int bit_count;
+} WRITER;
+
+
 /* ============================================================================
  * Funktions-Prototypen
  * ========================================================================= */
 
+/* ----------------------------------------------------------------------------
+ * Funktionen mit Kontext
+ * ------------------------------------------------------------------------- */
+
+/**
+ * Oeffnet die uebergebene Datei zum Lesen im Kontext reader oder bricht das
+ * Programm ab, wenn die Datei nicht geoeffnet werden konnte. Für den Namen
+ * STDIO_FILENAME wird von der Standardeingabe gelesen.
+ *
+ * @param reader    zu initialisierender Kontext
+ * @param filename  zu oeffnende Datei
+ */
+extern void reader_open(READER *reader, char filename[]);
+
+/**
+ * Schliesst die zum Lesen geoeffnete Datei oder bricht das Programm ab, wenn
+ * die Datei nicht geschlossen werden konnte.
+ *
+ * @param reader    Kontext des Eingabestroms
+ */
+extern void reader_close(READER *reader);
+
+/**
+ * Oeffnet die uebergebene Datei zum Schreiben im Kontext writer oder bricht
+ * das Programm ab, wenn die Datei nicht geoeffnet werden konnte. Für den
+ * Namen STDIO_FILENAME wird auf die Standardausgabe geschrieben.
+ *
+ * @param writer    zu initialisierender Kontext
+ * @param filename  zu oeffnende Datei
+ */
+extern void writer_open(WRITER *writer, char filename[]);
+
+/**
+ * Schreibt gepufferte Daten, schliesst die zum Schreiben geoeffnete Datei
+ * oder bricht das Programm ab, wenn die Datei nicht geschlossen werden
+ * konnte.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ */
+extern void writer_close(WRITER *writer);
+
+/**
+ * Schliesst die zum Lesen geoeffnete Datei nach einem Fehler, ohne weitere
+ * Fehler zu melden. Wurde die Datei nicht geoeffnet (reader->stream ist
+ * NULL), geschieht nichts.
+ *
+ * @param reader    Kontext des Eingabestroms
+ */
+extern void reader_abort(READER *reader);
+
+/**
+ * Schliesst die zum Schreiben geoeffnete Datei nach einem Fehler, ohne
+ * weitere Fehler zu melden. Noch gepufferte Daten werden verworfen. Wurde
+ * die Datei nicht geoeffnet (writer->stream ist NULL), geschieht nichts.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ */
+extern void writer_abort(WRITER *writer);
+
+/**
+ * Initialisiert den Kontext reader zum Lesen aus dem Speicherbereich data.
+ * Der Speicherbereich muss gültig bleiben, solange gelesen wird.
+ *
+ * @param reader    zu initialisierender Kontext
+ * @param data      zu lesende Daten
+ * @param size      Anzahl der Zeichen
+ */
+extern void reader_open_memory(READER *reader, const unsigned char data[],
+                               size_t size);
+
+/**
+ * Initialisiert den Kontext writer zum Schreiben in einen dynamisch
+ * wachsenden Speicherbereich.
+ *
+ * @param writer    zu initialisierender Kontext
+ */
+extern void writer_open_memory(WRITER *writer);
+
+/**
+ * Initialisiert den Kontext writer zum Schreiben in einen Zielbereich
+ * fester Größe. Zeichen, die nicht mehr hineinpassen, werden verworfen.
+ *
+ * @param writer    zu initialisierender Kontext
+ * @param dst       Zielbereich
+ * @param capacity  Größe des Zielbereichs
+ */
+extern void writer_open_buffer(WRITER *writer, unsigned char dst[],
+                               size_t capacity);
+
+/**
+ * Schreibt gepufferte Daten in den Speicherbereich und liefert ihn zurück.
+ * Der Aufrufer muss den Speicherbereich mit free freigeben.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param size      Anzahl der geschriebenen Zeichen (Ausgabe)
+ * @return          geschriebene Daten, NULL wenn nichts geschrieben wurde
+ */
+extern unsigned char *writer_close_memory(WRITER *writer, size_t *size);
+
+/**
+ * Schreibt gepufferte Daten in den Zielbereich fester Größe.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param size      Anzahl der geschriebenen Zeichen (Ausgabe)
+ * @return          false, wenn nicht alle Zeichen in den Zielbereich passten
+ */
+extern bool writer_close_buffer(WRITER *writer, size_t *size);
+
+/**
+ * Liefert die Anzahl der Zeichen, die bisher in einen Speicherbereich
+ * geschrieben wurden. Noch nicht ausgegebene Bits werden nicht mitgezählt.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @return          Anzahl der geschriebenen Zeichen
+ */
+extern size_t writer_memory_size(const WRITER *writer);
+
+/**
+ * Verwirft alles, was nach den ersten size Zeichen in einen Speicherbereich
+ * geschrieben wurde. Es dürfen keine Bits mehr im Bitpuffer stehen.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param size      Anzahl der Zeichen, die erhalten bleiben (höchstens
+ *                  writer_memory_size)
+ */
+extern void writer_truncate_memory(WRITER *writer, size_t size);
+
+/**
+ * Liest bis zu n Zeichen aus dem Eingabestrom nach dst. Es dürfen keine
+ * Bits mehr im Bitpuffer stehen.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param dst       Ziel der gelesenen Zeichen
+ * @param n         Anzahl der zu lesenden Zeichen
+ * @return          Anzahl der gelesenen Zeichen, weniger als n nur am Ende
+ *                  des Eingabestroms
+ */
+extern size_t reader_read(READER *reader, unsigned char dst[], size_t n);
+
+/**
+ * Überspringt n Zeichen des Eingabestroms. Bei eingeblendeten Dateien und
+ * Speicherbereichen werden die Zeichen dabei nicht gelesen. Es dürfen keine
+ * Bits mehr im Bitpuffer stehen.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param n         Anzahl der zu überspringenden Zeichen
+ * @return          false, wenn der Eingabestrom vorher endet
+ */
+extern bool reader_skip(READER *reader, uint64_t n);
+
+/**
+ * Schreibt n Zeichen aus src in den Ausgabestrom. Es dürfen keine Bits
+ * mehr im Bitpuffer stehen.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param src       zu schreibende Zeichen
+ * @param n         Anzahl der Zeichen
+ */
+extern void writer_write(WRITER *writer, const unsigned char src[], size_t n);
+
+/**
+ * Liefert den gesamten Inhalt des Eingabestroms als zusammenhängenden
+ * Speicherbereich, wenn die Datei eingeblendet ist oder aus dem Speicher
+ * gelesen wird. Der Bereich bleibt bis zum Schließen gültig und kann von
+ * mehreren Threads gleichzeitig gelesen werden.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param size      Größe des Bereichs (Ausgabe)
+ * @return          Beginn des Bereichs oder NULL bei gepuffertem Lesen
+ */
+extern const unsigned char *reader_span(READER *reader, size_t *size);
+
+/**
+ * Liefert die noch nicht gelesenen Zeichen eines Eingabestroms, der aus dem
+ * Speicher gelesen wird oder eingeblendet ist, und überspringt sie. Es
+ * dürfen keine Bits gepuffert sein.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param size      Anzahl der Zeichen (Ausgabe)
+ * @return          Adresse der Zeichen oder NULL bei gepuffertem Lesen
+ */
+extern const unsigned char *reader_take_rest(READER *reader, size_t *size);
+
+/**
+ * Liefert die Größe der Eingabedatei, wenn es sich um eine reguläre Datei
+ * handelt, deren Inhalt mit reader_read_at gelesen werden kann.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param size      Größe in Byte (Ausgabe)
+ * @return          true bei einer regulären Datei bzw. einem Speicherbereich
+ */
+extern bool reader_size(READER *reader, uint64_t *size);
+
+/**
+ * Liest n Zeichen ab der Position offset, ohne die aktuelle Leseposition zu
+ * verändern. Kann von mehreren Threads gleichzeitig aufgerufen werden.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param dst       Ziel der gelesenen Zeichen
+ * @param n         Anzahl der zu lesenden Zeichen
+ * @param offset    Position in der Eingabedatei
+ * @return          true, wenn alle n Zeichen gelesen wurden
+ */
+extern bool reader_read_at(READER *reader, unsigned char dst[], size_t n,
+                           uint64_t offset);
+
+/**
+ * Legt die Größe der Ausgabedatei fest, damit sie anschließend mit
+ * writer_write_at an beliebigen Positionen beschrieben werden kann. Zuvor
+ * wird alles bisher Geschriebene in die Datei übertragen.
+ *
+ * @param writer    Kontext des Ausgabestroms (Datei)
+ * @param size      Größe in Byte
+ * @return          true, wenn die Datei positionsweise beschrieben werden
+ *                  kann
+ */
+extern bool writer_set_size(WRITER *writer, uint64_t size);
+
+/**
+ * Schreibt n Zeichen an die Position offset der Ausgabedatei, ohne die
+ * Pufferung des Ausgabestroms zu verwenden. Kann von mehreren Threads
+ * gleichzeitig aufgerufen werden. Bricht das Programm bei einem Fehler ab.
+ *
+ * @param writer    Kontext des Ausgabestroms (Datei)
+ * @param src       zu schreibende Zeichen
+ * @param n         Anzahl der Zeichen
+ * @param offset    Position in der Ausgabedatei
+ */
+extern void writer_write_at(WRITER *writer, const unsigned char src[],
+                            size_t n, uint64_t offset);
+
+/**
+ * Kopiert n Zeichen ab der Position in_offset der Eingabedatei an die
+ * Position out_offset der Ausgabedatei. Wenn das Betriebssystem es erlaubt
+ * (copy_file_range), kopiert der Kern die Daten, ohne sie in den Speicher
+ * des Programms zu laden. Kann von mehreren Threads gleichzeitig aufgerufen
+ * werden. Bricht das Programm bei einem Schreibfehler ab.
+ *
+ * @param writer        Kontext des Ausgabestroms (Datei)
+ * @param reader        Kontext des Eingabestroms
+ * @param in_offset     Position in der Eingabedatei
+ * @param n             Anzahl der Zeichen
+ * @param out_offset    Position in der Ausgabedatei
+ * @return              false, wenn die Eingabedatei vorher endet
+ */
+extern bool writer_copy_at(WRITER *writer, READER *reader, uint64_t in_offset,
+                           size_t n, uint64_t out_offset);
+
+/**
+ * Liefert true, wenn noch mindestens ein weiteres Zeichen vorhanden ist.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @return
+ */
+extern bool reader_has_next_char(READER *reader);
+
+/**
+ * Liefert das nächste Zeichen aus dem Eingabestrom
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @return
+ */
+extern unsigned char reader_read_char(READER *reader);
+
+/**
+ * Schreibt das Zeichen in den Ausgabestrom
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param c
+ */
+extern void writer_write_char(WRITER *writer, unsigned char c);
+
+/**
+ * Liefert true, wenn noch mindestens ein weiteres Bit vorhanden ist.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @return
+ */
+extern bool reader_has_next_bit(READER *reader);
+
+/**
+ * Liefert das nächste Bit aus dem Eingabestrom
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @return
+ */
+extern BIT reader_read_bit(READER *reader);
+
+/**
+ * Schreibt das Bit in den Ausgabestrom
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param bit
+ */
+extern void writer_write_bit(WRITER *writer, BIT bit);
+
+/**
+ * Liefert true, wenn noch mindestens n weitere Bits vorhanden sind.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param n         Anzahl der Bits (höchstens 32)
+ * @return
+ */
+extern bool reader_has_next_bits(READER *reader, int n);
+
+/**
+ * Liefert die nächsten n Bits aus dem Eingabestrom, ohne sie zu verbrauchen.
+ * Das erste Bit steht im höchstwertigen der n Bits. Nach dem Dateiende
+ * werden 0-Bits geliefert.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param n         Anzahl der Bits (1 bis 32)
+ * @return          die nächsten n Bits
+ */
+extern uint32_t reader_peek_bits(READER *reader, int n);
+
+/**
+ * Verbraucht die nächsten n Bits des Eingabestroms. Es dürfen höchstens so
+ * viele Bits verbraucht werden, wie zuvor mit reader_peek_bits gelesen
+ * wurden.
+ *
+ * @param reader    Kontext des Eingabestroms
+ * @param n         Anzahl der Bits
+ */
+extern void reader_consume_bits(READER *reader, int n);
+
+/**
+ * Schreibt die n niederwertigsten Bits von code in den Ausgabestrom, das
+ * höchstwertige dieser Bits zuerst.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ * @param code      zu schreibende Bits
+ * @param n         Anzahl der Bits (1 bis 32)
+ */
+extern void writer_write_bits(WRITER *writer, uint32_t code, int n);
+
+/**
+ * Schreibt noch gepufferte Bits in den Ausgabestrom und füllt das letzte
+ * Zeichen mit 0-Bits auf. Muss vor writer_write_char aufgerufen werden, wenn
+ * zuvor bitweise geschrieben wurde; writer_close ruft die Funktion selbst
+ * auf.
+ *
+ * @param writer    Kontext des Ausgabestroms
+ */
+extern void writer_flush_bits(WRITER *writer);
+
+/* ----------------------------------------------------------------------------
+ * Funktionen auf den Standardkontexten
+ * ------------------------------------------------------------------------- */
+
 /**
  * Oeffnet die uebergebene Datei zum Lesen
- * 
+ *
  * @param filename zu oeffnende Datei
- * @return  liefert den Eingabestrom oder bricht das Programm ab, wenn die 
+ * @return  liefert den Eingabestrom oder bricht das Programm ab, wenn die
  *          Datei nicht geoeffnet werden konnte.
  */
 extern void open_infile(char filename[]);
 
 /**
- * Schliesst die zum Lesen geoeffnete Datei oder bricht das Programm ab, wenn die 
+ * Schliesst die zum Lesen geoeffnete Datei oder bricht das Programm ab, wenn die
  *          Datei nicht geschlossen werden konnte.
- * @return 
+ * @return
  */
 extern void close_infile(void);
 
 /**
  * Oeffnet die uebergebene Datei zum Schreiben
- * 
+ *
  * @param filename zu oeffnende Datei
- * @return  liefert den Ausgabestrom oder bricht das Programm ab, wenn die 
+ * @return  liefert den Ausgabestrom oder bricht das Programm ab, wenn die
  *          Datei nicht geoeffnet werden konnte.
  */
 extern void open_outfile(char filename[]);
 
 /**
- * Schliesst die zum Schreiben geoeffnete Datei oder bricht das Programm ab, 
+ * Schliesst die zum Schreiben geoeffnete Datei oder bricht das Programm ab,
  *          wenn die Datei nicht geschlossen werden konnte.
- * @return 
+ * @return
  */
 extern void close_outfile(void);
 
 /**
  * Liefert true, wenn noch mindestens ein weiteres Zeichen vorhanden ist.
- * 
- * @return 
+ *
+ * @return
  */
 extern bool has_next_char(void);
 
 /**
  * Liefert das nächste Zeichen aus dem Eingabestrom
- * @return 
+ * @return
  */
 extern unsigned char read_char(void);
 
 /**
  * Schreibt das Zeichen in den Ausgabestrom
- * 
- * @param c 
+ *
+ * @param c
  */
 extern void write_char(unsigned char c);
 
 /**
  * Liefert true, wenn noch mindestens ein weiteres Bit vorhanden ist.
- * 
- * @return 
+ *
+ * @return
  */
 extern bool has_next_bit(void);
 
 /**
  * Liefert das nächste Bit aus dem Eingabestrom
- * @return 
+ * @return
  */
 extern BIT read_bit(void);
 
 /**
- * Schreibt das Zeichen c, das nur den Zahlwert 0 oder 1 haben darf in den 
+ * Schreibt das Zeichen c, das nur den Zahlwert 0 oder 1 haben darf in den
  * Ausgabestrom
- * 
- * @param c 
+ *
+ * @param c
  */
 extern void write_bit(BIT c);
 
+/**
+ * Liefert true, wenn noch mindestens n weitere Bits vorhanden sind.
+ *
+ * @param n     Anzahl der Bits (höchstens 32)
+ * @return
+ */
+extern bool has_next_bits(int n);
+
+/**
+ * Liefert die nächsten n Bits aus dem Eingabestrom, ohne sie zu verbrauchen
+ * (siehe reader_peek_bits).
+ *
+ * @param n     Anzahl der Bits (1 bis 32)
+ * @return      die nächsten n Bits
+ */
+extern uint32_t peek_bits(int n);
+
+/**
+ * Verbraucht die nächsten n Bits des Eingabestroms (siehe
+ * reader_consume_bits).
+ *
+ * @param n     Anzahl der Bits
+ */
+extern void consume_bits(int n);
+
+/**
+ * Schreibt die n niederwertigsten Bits von code in den Ausgabestrom, das
+ * höchstwertige dieser Bits zuerst.
+ *
+ * @param code  zu schreibende Bits
+ * @param n     Anzahl der Bits (1 bis 32)
+ */
+extern void write_bits(uint32_t code, int n);
+
+/**
+ * Schreibt noch gepufferte Bits in den Ausgabestrom und füllt das letzte
+ * Zeichen mit 0-Bits auf (siehe writer_flush_bits).
+ */
+extern void flush_bits(void);
+
 /* ------------------------------------------------------------------------- */
 #endif	/* IO_H */
@@ -0,0 +1,432 @@
+/**
+ * @file
+ * In diesem Modul wird die LZ77-Zerlegung realisiert.
+ *
+ * Für jede Position wird der Hashwert der nächsten LZ77_MIN_MATCH Bytes
+ * gebildet. Die Tabelle head enthält je Hashwert die letzte Position mit
+ * diesem Wert, die Tabelle chain je Position die vorherige Position mit
+ * demselben Hashwert. chain ist als Ringpuffer über das Suchfenster
+ * angelegt: ein Eintrag bleibt gültig, solange seine Position im Fenster
+ * liegt. Positionen werden um 1 erhöht gespeichert, 0 steht für "keine".
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "huffman_common.h"
+#include "lz77.h"
+#include "trap.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Zweierlogarithmus der kleinsten Hash-Tabelle */
+#define MIN_HASH_LOG 10
+
+/** Zweierlogarithmus der größten Hash-Tabelle */
+#define MAX_HASH_LOG 16
+
+/**
+ * Abstand der Positionen, die lz77_repeat_share einträgt, und Länge der
+ * geprüften Abschnitte
+ */
+#define PROBE_STRIDE 32
+
+/** Anzahl der Abschnitte, die lz77_repeat_share prüft */
+#define PROBE_WINDOWS 64
+
+/** Mindestlänge einer Wiederholung für lz77_repeat_share */
+#define PROBE_MIN_MATCH 64
+
+/** Zweierlogarithmus der größten Hash-Tabelle von lz77_repeat_share */
+#define PROBE_MAX_HASH_LOG 18
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Zustand der Suche nach Wiederholungen in einem Block
+ */
+typedef struct
+{
+    /** zu zerlegende Daten */
+    const unsigned char *data;
+
+    /** Anzahl der Zeichen */
+    size_t size;
+
+    /** Einstellungen der Suche */
+    const LZ77_PARAMS *params;
+
+    /** Größe des Suchfensters */
+    size_t window;
+
+    /** Maske für den Ringpuffer chain */
+    size_t chain_mask;
+
+    /** Zweierlogarithmus der Größe von head */
+    int hash_log;
+
+    /** letzte Position (+1) je Hashwert */
+    uint32_t *head;
+
+    /** vorherige Position (+1) mit demselben Hashwert je Position */
+    uint32_t *chain;
+
+    /** nächste noch nicht eingetragene Position */
+    size_t next_insert;
+} MATCH_FINDER;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Berechnet den Hashwert der LZ77_MIN_MATCH Bytes ab p.
+ *
+ * @param p         erstes Byte
+ * @param hash_log  Zweierlogarithmus der Tabellengröße
+ * @return          Hashwert
+ */
+static uint32_t hash_bytes(const unsigned char *p, int hash_log);
+
+/**
+ * Trägt alle Positionen vor end in die Hash-Ketten ein.
+ *
+ * @param finder    Zustand der Suche
+ * @param end       erste nicht einzutragende Position
+ */
+static void insert_until(MATCH_FINDER *finder, size_t end);
+
+/**
+ * Sucht die längste Wiederholung, die an pos beginnt. Alle Positionen vor
+ * pos müssen eingetragen sein.
+ *
+ * @param finder    Zustand der Suche
+ * @param pos       Position
+ * @param distance  Abstand der gefundenen Wiederholung (Ausgabe)
+ * @return          Länge der Wiederholung, 0 wenn keine gefunden wurde
+ */
+static size_t find_match(const MATCH_FINDER *finder, size_t pos,
+                         uint32_t *distance);
+
+/**
+ * Bestimmt die Anzahl übereinstimmender Bytes zweier Positionen.
+ *
+ * @param a         erste Position
+ * @param b         zweite Position, hinter a
+ * @param limit     maximale Anzahl
+ * @return          Anzahl übereinstimmender Bytes
+ */
+static size_t common_length(const unsigned char *a, const unsigned char *b,
+                            size_t limit);
+
+/**
+ * Reserviert Speicher oder meldet einen Fehler (trap_raise), wenn keiner
+ * vorhanden ist.
+ *
+ * @param size      Anzahl der Bytes
+ * @return          reservierter Speicher
+ */
+static void *allocate(size_t size);
+
+
+/* ============================================================================
+ * Funktionsdefinitionen
+ * ========================================================================= */
+
+extern void lz77_parse(const unsigned char data[], size_t size,
+                       const LZ77_PARAMS *params, LZ77_PARSE *parse)
+{
+    MATCH_FINDER finder;
+    size_t chain_size;
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    parse->sequences = (LZ77_SEQUENCE *) allocate(
+            (size / LZ77_MIN_MATCH + 1) * sizeof (LZ77_SEQUENCE));
+    parse->literals = (unsigned char *) allocate(size);
+    parse->sequence_count = 0;
+    parse->literal_count = 0;
+
+    finder.data = data;
+    finder.size = size;
+    finder.params = params;
+    finder.window = (size_t) 1 << params->window_log;
+    finder.chain_mask = finder.window - 1;
+    finder.next_insert = 0;
+    finder.hash_log = MIN_HASH_LOG;
+    while (finder.hash_log < MAX_HASH_LOG
+           && ((size_t) 1 << finder.hash_log) < size)
+    {
+        finder.hash_log++;
+    }
+    chain_size = (size < finder.window) ? size : finder.window;
+    finder.head = (uint32_t *) allocate(
+            ((size_t) 1 << finder.hash_log) * sizeof (uint32_t));
+    finder.chain = (uint32_t *) allocate(chain_size * sizeof (uint32_t));
+    memset(finder.head, 0, ((size_t) 1 << finder.hash_log) * sizeof (uint32_t));
+
+    while (pos + LZ77_MIN_MATCH <= size)
+    {
+        uint32_t distance;
+        size_t length;
+
+        insert_until(&finder, pos);
+        length = find_match(&finder, pos, &distance);
+        if (length == 0)
+        {
+            pos++;
+            continue;
+        }
+
+        /* Lazy Matching: beginnt eine Position später eine längere
+         * Wiederholung, wird das aktuelle Zeichen als Literal ausgegeben */
+        while (params->lazy && length < (size_t) params->nice_length
+               && pos + 1 + LZ77_MIN_MATCH <= size)
+        {
+            uint32_t next_distance;
+            size_t next_length;
+
+            insert_until(&finder, pos + 1);
+            next_length = find_match(&finder, pos + 1, &next_distance);
+            if (next_length <= length)
+            {
+                break;
+            }
+            pos++;
+            length = next_length;
+            distance = next_distance;
+        }
+
+        {
+            LZ77_SEQUENCE *sequence = &parse->sequences[parse->sequence_count++];
+
+            sequence->literal_length = (uint32_t) (pos - anchor);
+            sequence->match_length = (uint32_t) length;
+            sequence->distance = distance;
+            memcpy(parse->literals + parse->literal_count, data + anchor,
+                   pos - anchor);
+            parse->literal_count += pos - anchor;
+        }
+        pos += length;
+        anchor = pos;
+    }
+
+    /* Literale hinter der letzten Sequenz */
+    memcpy(parse->literals + parse->literal_count, data + anchor,
+           size - anchor);
+    parse->literal_count += size - anchor;
+
+    free(finder.head);
+    free(finder.chain);
+}
+
+extern double lz77_repeat_share(const unsigned char data[], size_t size,
+                                const LZ77_PARAMS *params)
+{
+    size_t window = (size_t) 1 << params->window_log;
+    size_t next_insert = 0;
+    uint32_t *head;
+    int hash_log = MIN_HASH_LOG;
+    int probed = 0;
+    int repeated = 0;
+    int w;
+
+    if (size < 2 * (PROBE_STRIDE + PROBE_MIN_MATCH))
+    {
+        return 0.0;
+    }
+
+    /*
+     * Eingetragen wird nur jede PROBE_STRIDE-te Position. Geprüft werden
+     * dafür alle Positionen eines Abschnitts der Länge PROBE_STRIDE: eine
+     * Wiederholung, die den Abschnitt um PROBE_MIN_MATCH überragt, beginnt
+     * so für eine davon an einer eingetragenen Position.
+     */
+    while (hash_log < PROBE_MAX_HASH_LOG
+           && ((size_t) 1 << hash_log) < 2 * (size / PROBE_STRIDE))
+    {
+        hash_log++;
+    }
+    head = (uint32_t *) allocate(((size_t) 1 << hash_log) * sizeof (uint32_t));
+    memset(head, 0, ((size_t) 1 << hash_log) * sizeof (uint32_t));
+
+    for (w = 1; w <= PROBE_WINDOWS; w++)
+    {
+        size_t start = size / (PROBE_WINDOWS + 1) * (size_t) w;
+        size_t pos;
+
+        if (start + PROBE_STRIDE + PROBE_MIN_MATCH > size)
+        {
+            break;
+        }
+        for (; next_insert < start; next_insert += PROBE_STRIDE)
+        {
+            head[hash_bytes(data + next_insert, hash_log)]
+                    = (uint32_t) next_insert + 1;
+        }
+
+        probed++;
+        for (pos = start; pos < start + PROBE_STRIDE; pos++)
+        {
+            uint32_t candidate = head[hash_bytes(data + pos, hash_log)];
+
+            if (candidate > 0 && pos - (candidate - 1) <= window
+                    && common_length(data + candidate - 1, data + pos,
+                                     PROBE_MIN_MATCH) == PROBE_MIN_MATCH)
+            {
+                repeated++;
+                break;
+            }
+        }
+    }
+    free(head);
+
+    return (probed > 0) ? (double) repeated / probed : 0.0;
+}
+
+extern void lz77_free(LZ77_PARSE *parse)
+{
+    free(parse->sequences);
+    free(parse->literals);
+    parse->sequences = NULL;
+    parse->literals = NULL;
+}
+
+/* ----------------------------------------------------------------------------
+ * Suche nach Wiederholungen
+ * ------------------------------------------------------------------------- */
+
+static uint32_t hash_bytes(const unsigned char *p, int hash_log)
+{
+    uint32_t word;
+
+    memcpy(&word, p, sizeof(word));
+
+    return (word * 2654435761u) >> (32 - hash_log);
+}
+
+static void insert_until(MATCH_FINDER *finder, size_t end)
+{
+    size_t last = finder->size - LZ77_MIN_MATCH;
+    size_t pos;
+
+    if (end > last + 1)
+    {
+        end = last + 1;
+    }
+    for (pos = finder->next_insert; pos < end; pos++)
+    {
+        uint32_t hash = hash_bytes(finder->data + pos, finder->hash_log);
+
+        finder->chain[pos & finder->chain_mask] = finder->head[hash];
+        finder->head[hash] = (uint32_t) (pos + 1);
+    }
+    if (end > finder->next_insert)
+    {
+        finder->next_insert = end;
+    }
+}
+
+static size_t find_match(const MATCH_FINDER *finder, size_t pos,
+                         uint32_t *distance)
+{
+    const unsigned char *data = finder->data;
+    size_t limit = finder->size - pos;
+    size_t best = LZ77_MIN_MATCH - 1;
+    uint32_t candidate;
+    int depth = finder->params->chain_depth;
+
+    if (limit > LZ77_MAX_MATCH)
+    {
+        limit = LZ77_MAX_MATCH;
+    }
+
+    candidate = finder->head[hash_bytes(data + pos, finder->hash_log)];
+    while (candidate != 0 && depth-- > 0)
+    {
+        size_t match = candidate - 1;
+        size_t length;
+
+        /* der Eintrag in chain ist nur innerhalb des Fensters gültig */
+        if (pos - match > finder->window)
+        {
+            break;
+        }
+        if (data[match + best] == data[pos + best])
+        {
+            length = common_length(data + match, data + pos, limit);
+            if (length > best)
+            {
+                best = length;
+                *distance = (uint32_t) (pos - match);
+                if (length >= (size_t) finder->params->nice_length
+                    || length == limit)
+                {
+                    break;
+                }
+            }
+        }
+        candidate = finder->chain[match & finder->chain_mask];
+    }
+
+    return (best >= LZ77_MIN_MATCH) ? best : 0;
+}
+
+static size_t common_length(const unsigned char *a, const unsigned char *b,
+                            size_t limit)
+{
+    size_t length = 0;
+
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) \
+    && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    while (length + 8 <= limit)
+    {
+        uint64_t x;
+        uint64_t y;
+
+        memcpy(&x, a + length, sizeof(x));
+        memcpy(&y, b + length, sizeof(y));
+        if (x != y)
+        {
+            return length + (size_t) (__builtin_ctzll(x ^ y) >> 3);
+        }
+        length += 8;
+    }
+#endif
+    while (length < limit && a[length] == b[length])
+    {
+        length++;
+    }
+
+    return length;
+}
+
+static void *allocate(size_t size)
+{
+    void *memory = malloc(size > 0 ? size : 1);
+
+    if (memory == NULL)
+    {
+        trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+    }
+
+    return memory;
+}
@@ -0,0 +1,149 @@
+/**
+ * @file
+ * In diesem Modul wird die LZ77-Zerlegung realisiert. Ein Block wird in
+ * Sequenzen zerlegt, die jeweils aus einer Anzahl unveränderter Zeichen
+ * (Literale) und einem Verweis auf eine frühere Wiederholung bestehen.
+ * Wiederholungen werden über Hash-Ketten gesucht.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef LZ77_H
+#define LZ77_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stddef.h>
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/**
+ * Minimale Länge einer Wiederholung
+ */
+#define LZ77_MIN_MATCH 4
+
+/**
+ * Maximale Länge einer Wiederholung
+ */
+#define LZ77_MAX_MATCH (LZ77_MIN_MATCH + 65535)
+
+/**
+ * Zweierlogarithmus des kleinsten Suchfensters
+ */
+#define LZ77_MIN_WINDOW_LOG 10
+
+/**
+ * Zweierlogarithmus des größten Suchfensters
+ */
+#define LZ77_MAX_WINDOW_LOG 24
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Einstellungen der Suche nach Wiederholungen
+ */
+typedef struct
+{
+    /** Maximale Anzahl der je Position geprüften Kandidaten */
+    int chain_depth;
+
+    /** Zweierlogarithmus des Suchfensters */
+    int window_log;
+
+    /** Die Suche endet, sobald eine Wiederholung diese Länge erreicht */
+    int nice_length;
+
+    /**
+     * true: eine gefundene Wiederholung nur übernehmen, wenn an der
+     * nächsten Position keine längere beginnt
+     */
+    bool lazy;
+} LZ77_PARAMS;
+
+/**
+ * Eine Sequenz: literal_length Literale, dann eine Wiederholung
+ */
+typedef struct
+{
+    /** Anzahl der Literale vor der Wiederholung */
+    uint32_t literal_length;
+
+    /** Länge der Wiederholung, mindestens LZ77_MIN_MATCH */
+    uint32_t match_length;
+
+    /** Abstand zum Beginn der Wiederholung, mindestens 1 */
+    uint32_t distance;
+} LZ77_SEQUENCE;
+
+/**
+ * Ergebnis der Zerlegung eines Blocks. Die Literale hinter der letzten
+ * Sequenz stehen am Ende von literals.
+ */
+typedef struct
+{
+    /** Sequenzen in der Reihenfolge des Blocks */
+    LZ77_SEQUENCE *sequences;
+
+    /** Anzahl der Sequenzen */
+    size_t sequence_count;
+
+    /** alle Literale hintereinander */
+    unsigned char *literals;
+
+    /** Anzahl der Literale */
+    size_t literal_count;
+} LZ77_PARSE;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Zerlegt einen Block in Sequenzen. Der Speicher des Ergebnisses muss mit
+ * lz77_free freigegeben werden. Bricht das Programm ab, wenn nicht genügend
+ * Speicher vorhanden ist.
+ *
+ * @param data      zu zerlegende Daten
+ * @param size      Anzahl der Zeichen
+ * @param params    Einstellungen der Suche
+ * @param parse     Ergebnis (Ausgabe)
+ */
+extern void lz77_parse(const unsigned char data[], size_t size,
+                       const LZ77_PARAMS *params, LZ77_PARSE *parse);
+
+/**
+ * Schätzt an Stichproben, welcher Anteil eines Blocks sich innerhalb des
+ * Suchfensters wiederholt, ohne den Block zu zerlegen. Gefunden werden nur
+ * lange Wiederholungen, wie sie in sonst nicht komprimierbaren Daten
+ * vorkommen; der Aufwand ist klein gegenüber lz77_parse.
+ *
+ * @param data      zu prüfende Daten
+ * @param size      Anzahl der Zeichen
+ * @param params    Einstellungen der Suche (nur das Suchfenster zählt)
+ * @return          Anteil der Stichproben, die sich wiederholen (0 bis 1)
+ */
+extern double lz77_repeat_share(const unsigned char data[], size_t size,
+                                const LZ77_PARAMS *params);
+
+/**
+ * Gibt den Speicher eines Ergebnisses frei.
+ *
+ * @param parse     freizugebendes Ergebnis
+ */
+extern void lz77_free(LZ77_PARSE *parse);
+
+/* ------------------------------------------------------------------------- */
+#endif /* LZ77_H */
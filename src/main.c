@@ -21,6 +21,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <errno.h>
 
 /* Splint definiert S_SPLINT_S. Da die Splint-Prüfung von stat.h zum parse
  * error und Abbruch führt, wird der folgende Codeteil von der Splint-Prüfung 
@@ -29,13 +30,16 @@
 #ifndef S_SPLINT_S
 #ifdef __unix__
 #include <sys/stat.h>
+#include <sys/resource.h>
 #else
 #include <sys\stat.h>
 #endif
 #endif
 
 #include "huffman_common.h"
+#include "io.h"
 #include "huffman.h"
+#include "histogram.h"
 
 /* ===========================================================================
  * Datentypen
@@ -49,9 +53,16 @@ typedef enum
     NO_MODE,
     HELP,
     COMPRESS,
-    DECOMPRESS
+    DECOMPRESS,
+    TRAIN
 } MODE;
 
+/**
+ * Dateiname, 3 Zeichen länger als MAX_FILENAME, weil ggf. noch Platz für
+ * die Standard-Endung .hc bzw. .hd vorhanden sein muss.
+ */
+typedef char FILENAME[MAX_FILENAME + 4];
+
 
 /* ===========================================================================
  * Symbolische Konstanten
@@ -69,9 +80,36 @@ typedef enum
 /** Kommandozeilen-Option für die Wahl der Komprimierungsstärke */
 #define LEVEL_OPTION "-l"
 
+/** Kommandozeilen-Option für die Blockgröße in KiB */
+#define BLOCK_OPTION "-b"
+
+/** Kommandozeilen-Option für das Suchfenster in KiB */
+#define WINDOW_OPTION "-w"
+
+/** Kommandozeilen-Option für die Anzahl der Threads */
+#define THREADS_OPTION "-t"
+
+/** Kommandozeilen-Option für Prüfsummen je Block */
+#define CHECKSUM_OPTION "-k"
+
+/** Kommandozeilen-Option für einen Ausschnitt beim Dekomprimieren */
+#define RANGE_OPTION "--range"
+
+/** Kommandozeilen-Option für das Erstellen eines Wörterbuchs */
+#define TRAIN_OPTION "--train"
+
+/** Kommandozeilen-Option für die Wörterbuchdatei */
+#define DICTIONARY_OPTION "--dict"
+
+/** Kommandozeilen-Option für eine Datei mit den Namen der Eingabedateien */
+#define FILELIST_OPTION "-f"
+
 /** Kommandozeilen-Option für die Ausgabe von Informationen */
 #define VERBOSE_OPTION "-v"
 
+/** Kommandozeilen-Option für die Ausgabe von Informationen im JSON-Format */
+#define JSON_OPTION "-j"
+
 /** Kommandozeilen-Option für die Unterdrückung des Ausgabe von Informationen */
 #define HELP_OPTION "-h"
 
@@ -81,6 +119,21 @@ typedef enum
 /** Maximaler Level für Komprimierung */
 #define MAX_LEVEL 7
 
+/** Minimale Blockgröße in KiB */
+#define MIN_BLOCK_KIB 1
+
+/** Maximale Blockgröße in KiB (1 GiB) */
+#define MAX_BLOCK_KIB (1024 * 1024)
+
+/** Minimales Suchfenster in KiB */
+#define MIN_WINDOW_KIB 1
+
+/** Maximales Suchfenster in KiB (16 MiB) */
+#define MAX_WINDOW_KIB (16 * 1024)
+
+/** Maximale Anzahl der Threads */
+#define MAX_THREADS 1024
+
 /** ---------------------------------------------------------------------- */
 /** Dateiendung fuer die Ergebnisdatei, je nach Modus 'hc' oder 'hd' */
 #define GET_STD_SUFFIX(MODE) (((MODE) == COMPRESS) ? ".hc" : ".hd")
@@ -108,6 +161,48 @@ typedef enum
 /** Fehlermeldung wenn Ausgabedatei nicht angegeben wurde */
 #define EMSG_INVALID_LEVEL "Ungueltiger Level für Komprimierung."
 
+/** Fehlermeldung bei ungueltiger Blockgroesse */
+#define EMSG_INVALID_BLOCK_SIZE "Ungueltige Blockgroesse."
+
+/** Fehlermeldung bei ungueltigem Suchfenster */
+#define EMSG_INVALID_WINDOW "Ungueltige Groesse des Suchfensters."
+
+/** Fehlermeldung bei ungueltiger Anzahl von Threads */
+#define EMSG_INVALID_THREADS "Ungueltige Anzahl von Threads."
+
+/** Fehlermeldung wenn -o bei mehreren Eingabedateien angegeben wurde */
+#define EMSG_OUTFILE_BATCH "Option -o ist nur bei einer Eingabedatei erlaubt."
+
+/** Fehlermeldung wenn '-' bei mehreren Eingabedateien angegeben wurde */
+#define EMSG_STDIO_BATCH "'-' ist nur als einzige Eingabedatei erlaubt."
+
+/** Fehlermeldung wenn der Bereich fehlt */
+#define EMSG_RANGE_MISSING "Es wurde kein Bereich angegeben."
+
+/** Fehlermeldung bei ungueltigem Bereich */
+#define EMSG_INVALID_RANGE "Ungueltiger Bereich, erwartet wird <offset>:<laenge>."
+
+/** Fehlermeldung wenn --range nicht beim Dekomprimieren einer Datei steht */
+#define EMSG_RANGE_MODE "Option --range ist nur beim Dekomprimieren einer Datei erlaubt."
+
+/** Fehlermeldung wenn -k oder -b beim Dekomprimieren angegeben wurde */
+#define EMSG_COMPRESS_ONLY "Optionen -k und -b sind nur beim Komprimieren erlaubt."
+
+/** Fehlermeldung wenn die Wörterbuchdatei fehlt */
+#define EMSG_DICTIONARY_MISSING "Es wurde keine Woerterbuchdatei angegeben."
+
+/** Fehlermeldung wenn die Dateiliste fehlt */
+#define EMSG_FILELIST_MISSING "Es wurde keine Dateiliste angegeben."
+
+/** Fehlermeldung wenn die Dateiliste nicht gelesen werden kann */
+#define EMSG_INVALID_FILELIST "Die Dateiliste kann nicht gelesen werden."
+
+/** Fehlermeldung bei zu langem Dateinamen */
+#define EMSG_FILENAME_TOO_LONG "Dateiname ist zu lang."
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
 /** Fehlermeldung fuer unbekannte Option */
 #define EMSG_UNKNOWN_OPTION "Unbekannte Option."
 
@@ -120,15 +215,34 @@ typedef enum
  * ======================================================================== */
 
 /**
- * Name der Eingabedatei 
+ * Namen der Eingabedateien
+ */
+static FILENAME *in_filenames = NULL;
+
+/**
+ * Namen der Ausgabedateien, je Eingabedatei einer
  */
-static char in_filename[MAX_FILENAME + 1] = "";
+static FILENAME *out_filenames = NULL;
 
 /**
- * Name der Ausghabedatei, 3 Zeichen mehr, weil ggf. noch Platz für die 
- * Standard-Endung .hc bzw. .hd vorhanden sein muss.
+ * Anzahl der Eingabedateien
  */
-static char out_filename[MAX_FILENAME + 4] = "";
+static size_t file_count = 0;
+
+/**
+ * Anzahl der Dateinamen, für die Speicher reserviert ist
+ */
+static size_t file_capacity = 0;
+
+/**
+ * Name der Ausgabedatei aus der Option -o, leer wenn nicht angegeben
+ */
+static FILENAME out_option = "";
+
+/**
+ * Name der Wörterbuchdatei aus der Option --dict, leer wenn nicht angegeben
+ */
+static FILENAME dictionary_option = "";
 
 /**
  * Modus, in der das Programm ausgeführt werden soll
@@ -142,10 +256,68 @@ static MODE mode = NO_MODE;
 static bool verbose = false;
 
 /**
- * Level der Komprimierung, wird derzeit nicht verwendet.
+ * Flag, über das festgelegt wird, ob die Informationen im JSON-Format
+ * ausgegeben werden.
+ */
+static bool json = false;
+
+/**
+ * Namen der Abschnitte (HUFFMAN_PHASE) in der Ausgabe im JSON-Format
+ */
+static const char *phase_keys[PHASE_COUNT] =
+{
+    "read", "histogram", "table", "match", "code", "write"
+};
+
+/**
+ * Namen der Abschnitte (HUFFMAN_PHASE) in der Textausgabe
+ */
+static const char *phase_labels[PHASE_COUNT] =
+{
+    "Lesen", "Haeufigkeiten", "Codetabellen", "Wiederholungen",
+    "Kodieren", "Schreiben"
+};
+
+/**
+ * Level der Komprimierung
  */
 static int level = STD_LEVEL;
 
+/**
+ * Blockgröße in KiB, 0 für die Standard-Blockgröße
+ */
+static int block_kib = 0;
+
+/**
+ * Suchfenster in KiB, 0 für das Suchfenster des Levels
+ */
+static int window_kib = 0;
+
+/**
+ * Anzahl der Threads, 0 für einen Thread je Prozessorkern
+ */
+static int threads = 0;
+
+/**
+ * Flag, über das festgelegt wird, ob jeder Block eine Prüfsumme erhält
+ */
+static bool checksum = false;
+
+/**
+ * Flag, über das festgelegt wird, ob nur ein Ausschnitt dekomprimiert wird
+ */
+static bool range = false;
+
+/**
+ * Position des ersten Zeichens des Ausschnitts
+ */
+static uint64_t range_offset = 0;
+
+/**
+ * Länge des Ausschnitts, UINT64_MAX bis zum Ende
+ */
+static uint64_t range_length = UINT64_MAX;
+
 
 /* ===========================================================================
  * Funktionsprototypen
@@ -161,6 +333,42 @@ static int level = STD_LEVEL;
  */
 static int read_arguments(int argc, char **argv);
 
+/**
+ * Appends an input file name to the list of input files.
+ *
+ * @param filename  name of the input file
+ * @return          EXIT_SUCCESS, or #EXIT_OPTION_ERROR if the name is too
+ *                  long
+ */
+static int add_input_file(const char filename[]);
+
+/**
+ * Reads input file names from a list file, one name per line. Empty lines
+ * are skipped.
+ *
+ * @param list_filename name of the list file, '-' for stdin
+ * @return              EXIT_SUCCESS, or an error state if the list cannot be
+ *                      read or contains an invalid name
+ */
+static int read_file_list(const char list_filename[]);
+
+/**
+ * Derives the output file names and checks them against the input file
+ * names.
+ *
+ * @return  EXIT_SUCCESS if all names are valid, #EXIT_OPTION_ERROR otherwise
+ */
+static int assign_output_files(void);
+
+/**
+ * Parses the argument of option --range: "offset:length" or "offset:" for
+ * everything from offset to the end, both in bytes.
+ *
+ * @param text  argument of the option
+ * @return      EXIT_SUCCESS, or #EXIT_OPTION_ERROR if the range is invalid
+ */
+static int parse_range(const char text[]);
+
 /**
  * Prints usage information 
  */
@@ -168,12 +376,45 @@ static void print_help();
 
 /**
  * If verbose is switched on, this function prints information about run time
- * and size of input and output files. If switched off, nothing ist done.
+ * and size of input and output files: wall and cpu time, time per phase,
+ * throughput, ratio and peak memory. For several files one summary over all
+ * files is printed. If json is set, the same information is printed as one
+ * JSON object. If switched off, nothing ist done.
  * 
- * @param verbose   info is printed if set to true, 
- * @param prg_start cpu time at program start
+ * @param verbose       info is printed if set to true, 
+ * @param wall_start    wall clock time at program start in seconds
+ * @param cpu_start     cpu time at program start
+ * @param stats         statistics collected during de-/compression
  */
-static void print_info(bool verbose, clock_t prg_start);
+static void print_info(bool verbose, double wall_start, clock_t cpu_start,
+                       const HUFFMAN_STATS *stats);
+
+/**
+ * Prints the information of print_info as one JSON object on one line.
+ *
+ * @param info          output stream
+ * @param wall_seconds  elapsed wall clock time in seconds
+ * @param cpu_seconds   used cpu time of all threads in seconds
+ * @param peak_kib      peak resident memory in KiB, -1 if unknown
+ * @param stats         statistics collected during de-/compression
+ */
+static void print_json_info(FILE *info, double wall_seconds,
+                            double cpu_seconds, long peak_kib,
+                            const HUFFMAN_STATS *stats);
+
+/**
+ * Returns the time of a monotonic clock.
+ *
+ * @return  time in seconds
+ */
+static double wall_clock(void);
+
+/**
+ * Returns the peak resident memory of the process.
+ *
+ * @return  peak memory in KiB, -1 if unknown
+ */
+static long peak_memory_kib(void);
 
 
 /* ===========================================================================
@@ -189,24 +430,117 @@ static void print_info(bool verbose, clock_t prg_start);
  */
 int main(int argc, char** argv)
 {
-    clock_t prg_start = clock();
+    double wall_start = wall_clock();
+    clock_t cpu_start = clock();
     int exit_status = EXIT_SUCCESS;
+    HUFFMAN_OPTIONS options;
+    HUFFMAN_STATS stats;
 
     exit_status = read_arguments(argc, argv);
 
-    if (exit_status == EXIT_SUCCESS)
+    init_options(&options);
+    options.level = level;
+    if (block_kib > 0)
+    {
+        options.block_size = (uint32_t) block_kib * 1024;
+    }
+    if (window_kib > 0)
+    {
+        options.window_size = (uint32_t) window_kib * 1024;
+    }
+    if (threads > 0)
+    {
+        options.threads = threads;
+    }
+    options.checksum = checksum;
+    options.range_offset = range_offset;
+    options.range_length = range_length;
+    if (verbose)
+    {
+        init_stats(&stats);
+        options.stats = &stats;
+    }
+
+    /* Das Wörterbuch wird einmal geladen und für alle Dateien verwendet */
+    if (exit_status == EXIT_SUCCESS && mode != TRAIN
+            && strcmp(dictionary_option, "") != 0)
+    {
+        options.dictionary = load_dictionary(dictionary_option);
+    }
+
+    if (exit_status == EXIT_SUCCESS && file_count > 1
+            && (mode == COMPRESS || mode == DECOMPRESS))
+    {
+        /* Stapelbetrieb: alle Dateien teilen sich einen Thread-Pool */
+        char **in_names = (char **) malloc(file_count * sizeof (char *));
+        char **out_names = (char **) malloc(file_count * sizeof (char *));
+        size_t i;
+
+        if (in_names == NULL || out_names == NULL)
+        {
+            fprintf(stderr, "[ERROR]: %s\n", EMSG_OUT_OF_MEMORY);
+            exit(EXIT_FAILURE);
+        }
+        for (i = 0; i < file_count; i++)
+        {
+            in_names[i] = in_filenames[i];
+            out_names[i] = out_filenames[i];
+        }
+        if (mode == COMPRESS)
+        {
+            exit_status = compress_batch(in_names, out_names, file_count,
+                                         &options);
+        }
+        else
+        {
+            exit_status = decompress_batch(in_names, out_names, file_count,
+                                           &options);
+        }
+        print_info(verbose, wall_start, cpu_start, &stats);
+        free(in_names);
+        free(out_names);
+    }
+    else if (exit_status == EXIT_SUCCESS)
     {
         switch (mode)
         {
         case COMPRESS:
-            compress(in_filename, out_filename); /* level nicht verwendet */
-            print_info(verbose, prg_start);
+            compress_with_options(in_filenames[0], out_filenames[0], &options);
+            print_info(verbose, wall_start, cpu_start, &stats);
             break;
 
         case DECOMPRESS:
-            decompress(in_filename, out_filename);
-            print_info(verbose, prg_start);
+            decompress_with_options(in_filenames[0], out_filenames[0],
+                                    &options);
+            print_info(verbose, wall_start, cpu_start, &stats);
+            break;
+
+        case TRAIN:
+        {
+            char **sample_names = (char **) malloc(file_count * sizeof (char *));
+            uint32_t id;
+            size_t i;
+
+            if (sample_names == NULL)
+            {
+                fprintf(stderr, "[ERROR]: %s\n", EMSG_OUT_OF_MEMORY);
+                exit(EXIT_FAILURE);
+            }
+            for (i = 0; i < file_count; i++)
+            {
+                sample_names[i] = in_filenames[i];
+            }
+            id = train_dictionary(sample_names, file_count, out_option,
+                                  &options);
+            if (verbose)
+            {
+                printf("Woerterbuch %s: Kennung %08x aus %lu Datei(en)\n",
+                       out_option, (unsigned int) id,
+                       (unsigned long) file_count);
+            }
+            free(sample_names);
             break;
+        }
 
         default:
             print_help();
@@ -218,6 +552,10 @@ int main(int argc, char** argv)
         print_help();
     }
 
+    free(in_filenames);
+    free(out_filenames);
+    unload_dictionaries();
+
     return (exit_status);
 }
 
@@ -232,125 +570,462 @@ static int read_arguments(int argc, char **argv)
     {
         /* Nicht genügend Argumente*/
         fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MISSING_OPTION);
-        exit_status = EXIT_OPTION_ERROR;
+        return EXIT_OPTION_ERROR;
     }
-    else
-    {
-        /* Das letzte Argument ist der Name der Eingabedatei */
-        strncpy(in_filename, argv[argc - 1], MAX_FILENAME);
-        argc--;
 
-        /* Argumente durchlaufen vom zweiten bis zum vorletzten */
-        i = 1;
-        while (i < argc && resume)
+    /*
+     * Argumente durchlaufen: Optionen beginnen mit '-', alle übrigen
+     * Argumente (und '-' allein für die Standardeingabe) sind Eingabedateien
+     */
+    i = 1;
+    while (i < argc && resume)
+    {
+        if (argv[i][0] != '-' || argv[i][1] == '\0')
         {
-            if (strcmp(argv[i], HELP_OPTION) == 0)
+            if (add_input_file(argv[i]) != EXIT_SUCCESS)
             {
-                /* HELP_OPTION gefunden: Parameterprüfung beenden */
-                mode = HELP;
-                resume = false;
+                exit_status = EXIT_OPTION_ERROR;
             }
-            else if (strcmp(argv[i], OUTFILE_OPTION) == 0)
+        }
+        else if (strcmp(argv[i], HELP_OPTION) == 0)
+        {
+            /* HELP_OPTION gefunden: Parameterprüfung beenden */
+            mode = HELP;
+            resume = false;
+        }
+        else if (strcmp(argv[i], OUTFILE_OPTION) == 0)
+        {
+            /* OUTFILE_OPTION gefunden, nächster Parameter ist Name der Datei */
+            if (i + 1 < argc)
             {
-                /* OUTFILE_OPTION gefunden, nächster Parameter ist Name der Datei */
-                if (i + 1 < argc)
-                {
-                    strncpy(out_filename, argv[i + 1], MAX_FILENAME);
-                    i++;
-                }
-                else
-                {
-                    fprintf(stderr, "[ERROR]: %s\n\n", EMSG_OUTFILE_MISSING);
-                    exit_status = EXIT_OPTION_ERROR;
-                }
+                strncpy(out_option, argv[i + 1], MAX_FILENAME);
+                i++;
             }
-            else if (strcmp(argv[i], COMPRESS_OPTION) == 0)
+            else
             {
-                mode = COMPRESS;
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_OUTFILE_MISSING);
+                exit_status = EXIT_OPTION_ERROR;
             }
-            else if (strcmp(argv[i], DECOMPRESS_OPTION) == 0)
+        }
+        else if (strcmp(argv[i], FILELIST_OPTION) == 0)
+        {
+            /* FILELIST_OPTION gefunden, nächster Parameter ist die Liste */
+            if (i + 1 < argc)
             {
-                mode = DECOMPRESS;
+                int list_status = read_file_list(argv[i + 1]);
+
+                if (list_status != EXIT_SUCCESS)
+                {
+                    exit_status = list_status;
+                }
+                i++;
             }
-            else if (strcmp(argv[i], VERBOSE_OPTION) == 0)
+            else
             {
-                verbose = true;
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_FILELIST_MISSING);
+                exit_status = EXIT_OPTION_ERROR;
             }
-            else if (strncmp(argv[i], LEVEL_OPTION, 2) == 0)
+        }
+        else if (strcmp(argv[i], RANGE_OPTION) == 0)
+        {
+            /* RANGE_OPTION gefunden, nächster Parameter ist der Bereich */
+            if (i + 1 < argc)
             {
-                /* LEVEL_OPTION: nächste Zeichen bilden die Zahl des Levels */
-                level = atoi(argv[i] + 2);
-
-                /* Fehler bei Umwandlung der Zeichenkette */
-                if (level == 0)
+                if (parse_range(argv[i + 1]) != EXIT_SUCCESS)
                 {
-                    fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MISSING_LEVEL);
-                    exit_status = EXIT_OPTION_ERROR;
-                }
-                else if (level < MIN_LEVEL || level > MAX_LEVEL)
-                {
-                    fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_LEVEL);
                     exit_status = EXIT_OPTION_ERROR;
                 }
+                i++;
             }
             else
             {
-                fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_UNKNOWN_OPTION, argv[i]);
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_RANGE_MISSING);
                 exit_status = EXIT_OPTION_ERROR;
             }
-
-            i++;
         }
+        else if (strcmp(argv[i], DICTIONARY_OPTION) == 0)
+        {
+            /* DICTIONARY_OPTION gefunden, nächster Parameter ist die Datei */
+            if (i + 1 < argc)
+            {
+                strncpy(dictionary_option, argv[i + 1], MAX_FILENAME);
+                i++;
+            }
+            else
+            {
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_DICTIONARY_MISSING);
+                exit_status = EXIT_OPTION_ERROR;
+            }
+        }
+        else if (strcmp(argv[i], TRAIN_OPTION) == 0)
+        {
+            mode = TRAIN;
+        }
+        else if (strcmp(argv[i], COMPRESS_OPTION) == 0)
+        {
+            mode = COMPRESS;
+        }
+        else if (strcmp(argv[i], DECOMPRESS_OPTION) == 0)
+        {
+            mode = DECOMPRESS;
+        }
+        else if (strcmp(argv[i], CHECKSUM_OPTION) == 0)
+        {
+            checksum = true;
+        }
+        else if (strcmp(argv[i], VERBOSE_OPTION) == 0)
+        {
+            verbose = true;
+        }
+        else if (strcmp(argv[i], JSON_OPTION) == 0)
+        {
+            verbose = true;
+            json = true;
+        }
+        else if (strncmp(argv[i], LEVEL_OPTION, 2) == 0)
+        {
+            /* LEVEL_OPTION: nächste Zeichen bilden die Zahl des Levels */
+            level = atoi(argv[i] + 2);
 
-        if (mode == NO_MODE)
+            /* Fehler bei Umwandlung der Zeichenkette */
+            if (level == 0)
+            {
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MISSING_LEVEL);
+                exit_status = EXIT_OPTION_ERROR;
+            }
+            else if (level < MIN_LEVEL || level > MAX_LEVEL)
+            {
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_LEVEL);
+                exit_status = EXIT_OPTION_ERROR;
+            }
+        }
+        else if (strncmp(argv[i], BLOCK_OPTION, 2) == 0)
         {
-            fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MODE_MISSSING);
-            exit_status = EXIT_OPTION_ERROR;
+            /* BLOCK_OPTION: nächste Zeichen bilden die Blockgröße in KiB */
+            block_kib = atoi(argv[i] + 2);
+
+            if (block_kib < MIN_BLOCK_KIB || block_kib > MAX_BLOCK_KIB)
+            {
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_BLOCK_SIZE);
+                exit_status = EXIT_OPTION_ERROR;
+            }
         }
-        else
+        else if (strncmp(argv[i], WINDOW_OPTION, 2) == 0)
         {
-            /* Standard-Ausgabedateinamen erstellen */
-            if (strcmp(out_filename, "") == 0
-                    && strlen(in_filename) < MAX_FILENAME - strlen(GET_STD_SUFFIX(mode)))
+            /* WINDOW_OPTION: nächste Zeichen bilden das Suchfenster in KiB */
+            window_kib = atoi(argv[i] + 2);
+
+            if (window_kib < MIN_WINDOW_KIB || window_kib > MAX_WINDOW_KIB)
             {
-                strncpy(out_filename, in_filename, MAX_FILENAME);
-                strncat(out_filename, GET_STD_SUFFIX(mode), GET_STD_SUFFIX_LEN(mode));
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_WINDOW);
+                exit_status = EXIT_OPTION_ERROR;
             }
+        }
+        else if (strncmp(argv[i], THREADS_OPTION, 2) == 0)
+        {
+            /* THREADS_OPTION: nächste Zeichen bilden die Anzahl */
+            threads = atoi(argv[i] + 2);
 
-            /* Ein- und Ausgabedateiname vergleichen */
-            if (strcmp(in_filename, out_filename) == 0)
+            if (threads < 1 || threads > MAX_THREADS)
             {
-                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_OUTFILE);
+                fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_THREADS);
                 exit_status = EXIT_OPTION_ERROR;
             }
         }
+        else
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_UNKNOWN_OPTION, argv[i]);
+            exit_status = EXIT_OPTION_ERROR;
+        }
+
+        i++;
+    }
+
+    if (mode == HELP)
+    {
+        return exit_status;
+    }
+    if (mode == NO_MODE)
+    {
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MODE_MISSSING);
+        exit_status = EXIT_OPTION_ERROR;
+    }
+    else if (file_count == 0)
+    {
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_MISSING_OPTION);
+        exit_status = EXIT_OPTION_ERROR;
+    }
+    else if (range && (mode != DECOMPRESS || file_count > 1))
+    {
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_RANGE_MODE);
+        exit_status = EXIT_OPTION_ERROR;
+    }
+    else if (mode == DECOMPRESS && (checksum || block_kib != 0))
+    {
+        /* Prüfsummen und Blockgröße stehen in der komprimierten Datei */
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_COMPRESS_ONLY);
+        exit_status = EXIT_OPTION_ERROR;
+    }
+    else if (mode == TRAIN)
+    {
+        /* Beim Erstellen eines Wörterbuchs nennt -o die Wörterbuchdatei */
+        if (strcmp(out_option, "") == 0)
+        {
+            fprintf(stderr, "[ERROR]: %s\n\n", EMSG_OUTFILE_MISSING);
+            exit_status = EXIT_OPTION_ERROR;
+        }
+    }
+    else if (exit_status == EXIT_SUCCESS)
+    {
+        exit_status = assign_output_files();
     }
 
-    SPRINT(in_filename);
-    SPRINT(out_filename);
     DPRINT(mode);
     DPRINT(verbose);
+    DPRINT(json);
     DPRINT(level);
+    DPRINT(block_kib);
+    DPRINT(window_kib);
+    DPRINT(threads);
+    DPRINT(checksum);
 
     return exit_status;
 }
 
+static int add_input_file(const char filename[])
+{
+    if (strlen(filename) > MAX_FILENAME)
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_FILENAME_TOO_LONG, filename);
+        return EXIT_OPTION_ERROR;
+    }
+
+    if (file_count == file_capacity)
+    {
+        size_t capacity = (file_capacity > 0) ? 2 * file_capacity : 16;
+        FILENAME *in_names = (FILENAME *) realloc(in_filenames,
+                                                  capacity * sizeof (FILENAME));
+
+        if (in_names == NULL)
+        {
+            fprintf(stderr, "[ERROR]: %s\n", EMSG_OUT_OF_MEMORY);
+            exit(EXIT_FAILURE);
+        }
+        in_filenames = in_names;
+        file_capacity = capacity;
+    }
+    strcpy(in_filenames[file_count], filename);
+    file_count++;
+
+    SPRINT(filename);
+
+    return EXIT_SUCCESS;
+}
+
+static int read_file_list(const char list_filename[])
+{
+    char line[MAX_FILENAME + 3];
+    int exit_status = EXIT_SUCCESS;
+    FILE *list = (strcmp(list_filename, STDIO_FILENAME) == 0)
+            ? stdin : fopen(list_filename, "r");
+
+    if (list == NULL)
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_FILELIST,
+                list_filename);
+        return EXIT_IO_ERROR;
+    }
+
+    while (exit_status == EXIT_SUCCESS
+           && fgets(line, (int) sizeof (line), list) != NULL)
+    {
+        size_t len = strlen(line);
+
+        /* Zeilenende (auch CR LF) entfernen */
+        if (len > 0 && line[len - 1] != '\n' && !feof(list))
+        {
+            fprintf(stderr, "[ERROR]: %s: %s...\n\n", EMSG_FILENAME_TOO_LONG,
+                    line);
+            exit_status = EXIT_OPTION_ERROR;
+            break;
+        }
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        {
+            line[--len] = '\0';
+        }
+        if (len > 0)
+        {
+            exit_status = add_input_file(line);
+        }
+    }
+    if (exit_status == EXIT_SUCCESS && ferror(list))
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_FILELIST,
+                list_filename);
+        exit_status = EXIT_IO_ERROR;
+    }
+
+    if (list != stdin)
+    {
+        fclose(list);
+    }
+
+    return exit_status;
+}
+
+static int parse_range(const char text[])
+{
+    const char *length_text;
+    char *end;
+
+    /* strtoull akzeptiert auch Vorzeichen und Leerraum, daher Ziffern prüfen */
+    if (text[0] < '0' || text[0] > '9')
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_RANGE, text);
+        return EXIT_OPTION_ERROR;
+    }
+    errno = 0;
+    range_offset = strtoull(text, &end, 10);
+    if (errno != 0 || *end != ':')
+    {
+        fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_RANGE, text);
+        return EXIT_OPTION_ERROR;
+    }
+
+    /* Ohne Länge reicht der Bereich bis zum Ende */
+    length_text = end + 1;
+    if (*length_text == '\0')
+    {
+        range_length = UINT64_MAX;
+    }
+    else
+    {
+        if (*length_text < '0' || *length_text > '9')
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_RANGE, text);
+            return EXIT_OPTION_ERROR;
+        }
+        range_length = strtoull(length_text, &end, 10);
+        if (errno != 0 || *end != '\0')
+        {
+            fprintf(stderr, "[ERROR]: %s: %s\n\n", EMSG_INVALID_RANGE, text);
+            return EXIT_OPTION_ERROR;
+        }
+    }
+    range = true;
+
+    return EXIT_SUCCESS;
+}
+
+static int assign_output_files(void)
+{
+    size_t i;
+
+    if (file_count > 1 && strcmp(out_option, "") != 0)
+    {
+        fprintf(stderr, "[ERROR]: %s\n\n", EMSG_OUTFILE_BATCH);
+        return EXIT_OPTION_ERROR;
+    }
+
+    out_filenames = (FILENAME *) malloc(file_count * sizeof (FILENAME));
+    if (out_filenames == NULL)
+    {
+        fprintf(stderr, "[ERROR]: %s\n", EMSG_OUT_OF_MEMORY);
+        exit(EXIT_FAILURE);
+    }
+
+    for (i = 0; i < file_count; i++)
+    {
+        char *in_filename = in_filenames[i];
+        char *out_filename = out_filenames[i];
+
+        if (file_count > 1 && strcmp(in_filename, STDIO_FILENAME) == 0)
+        {
+            fprintf(stderr, "[ERROR]: %s\n\n", EMSG_STDIO_BATCH);
+            return EXIT_OPTION_ERROR;
+        }
+        strcpy(out_filename, out_option);
+
+        /* Von der Standardeingabe wird auf die Standardausgabe geschrieben */
+        if (strcmp(out_filename, "") == 0
+                && strcmp(in_filename, STDIO_FILENAME) == 0)
+        {
+            strncpy(out_filename, STDIO_FILENAME, MAX_FILENAME);
+        }
+
+        /* Standard-Ausgabedateinamen erstellen */
+        if (strcmp(out_filename, "") == 0
+                && strlen(in_filename) < MAX_FILENAME - strlen(GET_STD_SUFFIX(mode)))
+        {
+            strncpy(out_filename, in_filename, MAX_FILENAME);
+            strncat(out_filename, GET_STD_SUFFIX(mode), GET_STD_SUFFIX_LEN(mode));
+        }
+
+        /* Ein- und Ausgabedateiname vergleichen */
+        if (strcmp(in_filename, out_filename) == 0
+                && strcmp(in_filename, STDIO_FILENAME) != 0)
+        {
+            fprintf(stderr, "[ERROR]: %s\n\n", EMSG_INVALID_OUTFILE);
+            return EXIT_OPTION_ERROR;
+        }
+
+        SPRINT(in_filename);
+        SPRINT(out_filename);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 static void print_help()
 {
-    printf("Usage: huffman <options> infilename\n"
-           "  depending on options compresses oder decompresses infilename\n");
+    printf("Usage: huffman <options> infilename...\n"
+           "  depending on options compresses oder decompresses the infilenames,\n"
+           "  several files are processed in parallel\n"
+           "  infilename '-' reads from stdin and writes to stdout unless -o is given\n");
 
     printf("Options are:\n");
     printf("  -c           compress file (mandatory) \n");
     printf("  -d           decompress file (mandatory) \n"
            "                  if options -c and -d are both given, the latter\n"
            "                  determines the mode of execution\n");
-    printf("  -l<level>    level (1-7) of compression (optional, default: 2) \n");
-    printf("  -v           prints size of outfile and used time to de-/compress (optional) \n");
-    printf("  -o <outfile> name of output file (optional)\n"
+    printf("  --train      builds a dictionary from the infilenames as samples\n"
+           "                  and writes it to the file given by -o (instead of\n"
+           "                  -c or -d); -l selects the code length limit\n");
+    printf("  --dict <dictfile>\n"
+           "               loads the dictionary once for all files (optional);\n"
+           "                  with -c, blocks refer to it by its id instead of\n"
+           "                  storing a code table where that is shorter, -d\n"
+           "                  needs the same dictionary\n");
+    printf("  -l<level>    level (1-7) of compression (optional, default: 2) \n"
+           "                  1-2: fast, code length limited for small decode tables\n"
+           "                  3-4: optimal length-limited codes\n"
+           "                  5-7: additionally split blocks where it pays off\n"
+           "                  higher levels search longer for repeated strings\n");
+    printf("  -b<size>     block size in KiB (optional, default: 1024) \n"
+           "                  each block is compressed independently\n"
+           "                  (only for -c)\n");
+    printf("  -w<size>     window in KiB for repeated strings (optional, \n"
+           "                  default: depends on level, at most 16384)\n");
+    printf("  -t<threads>  number of threads (optional, default: number of cores) \n");
+    printf("  -k           stores a CRC32C checksum per block, verified when\n"
+           "                  decompressing (optional, only for -c)\n");
+    printf("  --range <offset>:<length>\n"
+           "               decompresses only length bytes from offset of the\n"
+           "                  original data, '<offset>:' up to the end (optional,\n"
+           "                  only for -d and one infilename); with a block index\n"
+           "                  only the blocks in the range are read\n");
+    printf("  -v           prints sizes, wall and cpu time, time per phase, throughput,\n"
+           "                  ratio and peak memory (optional)\n"
+           "                  for several files one summary over all files\n");
+    printf("  -j           like -v, but prints the information as one JSON object\n"
+           "                  (optional)\n");
+    printf("  -o <outfile> name of output file (optional, only for one infilename),\n"
+           "                  '-' for stdout\n"
            "                  if option -o is not given, a standard suffix is added\n"
            "                  to the infilename: 'hc' in case of compression, 'hd' in\n"
            "                  case of decompression\n");
+    printf("  -f <list>    reads further infilenames from file list, one per line,\n"
+           "                  '-' reads the list from stdin\n");
     printf("  -h           prints this help \n");
     printf("\n");
 
@@ -359,32 +1034,156 @@ static void print_help()
     printf("  1:           unspecified error\n");
     printf("  2:           error in some option\n");
     printf("  3:           file error\n");
-    printf("  4:           error caused by compression/decompression\n\n");
+    printf("  4:           error caused by compression/decompression\n");
+    printf("  5:           not enough memory or threads\n\n");
 }
 
-static void print_info(bool verbose, clock_t prg_start)
+static void print_info(bool verbose, double wall_start, clock_t cpu_start,
+                       const HUFFMAN_STATS *stats)
 {
 #ifndef S_SPLINT_S
 
     if (verbose)
     {
         struct stat attribut;
-        clock_t prg_end = clock();
+        double wall_seconds = wall_clock() - wall_start;
+        double cpu_seconds = (double) (clock() - cpu_start) / CLOCKS_PER_SEC;
+        long peak_kib = peak_memory_kib();
+        uint64_t raw_bytes = (mode == COMPRESS)
+                ? stats->in_bytes : stats->out_bytes;
+        uint64_t packed_bytes = (mode == COMPRESS)
+                ? stats->out_bytes : stats->in_bytes;
+        int phase;
+
+        /* Bei Ausgabe auf die Standardausgabe nicht in die Daten schreiben */
+        FILE *info = (strcmp(out_filenames[0], STDIO_FILENAME) == 0)
+                ? stderr : stdout;
+
+        if (json)
+        {
+            print_json_info(info, wall_seconds, cpu_seconds, peak_kib, stats);
+            return;
+        }
+
+        fprintf(info, "\nAusfuehrungsstatistik\n");
+
+        if (file_count == 1)
+        {
+            if (strcmp(in_filenames[0], STDIO_FILENAME) != 0
+                    && stat(in_filenames[0], &attribut) == 0)
+            {
+                fprintf(info, " - Groesse der Eingabedatei %s (byte): %lu\n",
+                        in_filenames[0], (unsigned long) attribut.st_size);
+            }
+
+            if (strcmp(out_filenames[0], STDIO_FILENAME) != 0
+                    && stat(out_filenames[0], &attribut) == 0)
+            {
+                fprintf(info, " - Groesse der Ausgabedatei %s (byte): %lu\n",
+                        out_filenames[0], (unsigned long) attribut.st_size);
+            }
+        }
+        else
+        {
+            /* Stapelbetrieb: eine Zusammenfassung über alle Dateien */
+            fprintf(info, " - Anzahl der Dateien: %lu\n",
+                    (unsigned long) file_count);
+            fprintf(info, " - Groesse der Eingabedateien (byte): %llu\n",
+                    (unsigned long long) stats->in_bytes);
+            fprintf(info, " - Groesse der Ausgabedateien (byte): %llu\n",
+                    (unsigned long long) stats->out_bytes);
+        }
+
+        fprintf(info, " - Anzahl der Bloecke: %llu\n",
+                (unsigned long long) stats->blocks);
+        if (raw_bytes > 0)
+        {
+            fprintf(info, " - Verhaeltnis komprimiert/unkomprimiert: %.4f\n",
+                    (double) packed_bytes / (double) raw_bytes);
+        }
+
+        fprintf(info, " - Die Programmlaufzeit betrug %.3f Sekunden"
+                " (CPU-Zeit aller Threads: %.3f Sekunden)\n",
+                wall_seconds, cpu_seconds);
+        if (wall_seconds > 0.0)
+        {
+            fprintf(info, " - Durchsatz (unkomprimiert): %.1f MB/s\n",
+                    (double) raw_bytes / wall_seconds / 1e6);
+        }
+
+        /* Die Abschnitte laufen in mehreren Threads gleichzeitig */
+        fprintf(info, " - Laufzeit je Abschnitt, Summe ueber alle Threads"
+                " (Sekunden):\n");
+        for (phase = 0; phase < PHASE_COUNT; phase++)
+        {
+            fprintf(info, "     %-16s %8.3f", phase_labels[phase],
+                    stats->phase_seconds[phase]);
+            if (phase == PHASE_HISTOGRAM && mode == COMPRESS)
+            {
+                fprintf(info, " (%s)", histogram_kernel_name());
+            }
+            fprintf(info, "\n");
+        }
+
+        if (peak_kib >= 0)
+        {
+            fprintf(info, " - Maximaler Speicherbedarf (KiB): %ld\n", peak_kib);
+        }
+
+        fprintf(info, "\n");
+    }
+#endif
+}
 
-        printf("\nAusfuehrungsstatistik\n");
+static void print_json_info(FILE *info, double wall_seconds,
+                            double cpu_seconds, long peak_kib,
+                            const HUFFMAN_STATS *stats)
+{
+    uint64_t raw_bytes = (mode == COMPRESS) ? stats->in_bytes : stats->out_bytes;
+    uint64_t packed_bytes = (mode == COMPRESS)
+            ? stats->out_bytes : stats->in_bytes;
+    int phase;
+
+    fprintf(info, "{\"mode\":\"%s\",\"files\":%lu,\"blocks\":%llu,"
+            "\"in_bytes\":%llu,\"out_bytes\":%llu,\"ratio\":%.6f,"
+            "\"wall_seconds\":%.6f,\"cpu_seconds\":%.6f,"
+            "\"throughput_mb_s\":%.3f,\"peak_rss_kib\":%ld,\"phase_seconds\":{",
+            (mode == COMPRESS) ? "compress" : "decompress",
+            (unsigned long) file_count, (unsigned long long) stats->blocks,
+            (unsigned long long) stats->in_bytes,
+            (unsigned long long) stats->out_bytes,
+            (raw_bytes > 0) ? (double) packed_bytes / (double) raw_bytes : 0.0,
+            wall_seconds, cpu_seconds,
+            (wall_seconds > 0.0) ? (double) raw_bytes / wall_seconds / 1e6 : 0.0,
+            peak_kib);
+    for (phase = 0; phase < PHASE_COUNT; phase++)
+    {
+        fprintf(info, "%s\"%s\":%.6f", (phase > 0) ? "," : "",
+                phase_keys[phase], stats->phase_seconds[phase]);
+    }
+    fprintf(info, "},\"histogram_kernel\":\"%s\"}\n",
+            histogram_kernel_name());
+}
 
-        stat(in_filename, &attribut);
-        printf(" - Groesse der Eingabedatei %s (byte): %lu\n",
-               in_filename, (unsigned long) attribut.st_size);
+static double wall_clock(void)
+{
+    struct timespec now;
 
-        stat(out_filename, &attribut);
-        printf(" - Groesse der Ausgabedatei %s (byte): %lu\n",
-               out_filename, (unsigned long) attribut.st_size);
+    clock_gettime(CLOCK_MONOTONIC, &now);
 
-        printf(" - Die Programmlaufzeit betrug %.2f Sekunden\n",
-               (float) (prg_end - prg_start) / CLOCKS_PER_SEC);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
 
-        printf("\n");
+static long peak_memory_kib(void)
+{
+#if defined(__unix__) && !defined(S_SPLINT_S)
+    struct rusage usage;
+
+    /* ru_maxrss wird unter Linux in KiB angegeben */
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        return usage.ru_maxrss;
     }
 #endif
+    return -1;
 }
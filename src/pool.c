@@ -0,0 +1,278 @@
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "huffman_common.h"
+#include "pool.h"
+#include "trap.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Fehlermeldung, wenn der Thread-Pool nicht angelegt werden konnte */
+#define EMSG_POOL_CREATE "Thread-Pool konnte nicht angelegt werden."
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Thread-Pool
+ */
+struct POOL
+{
+    /** Anzahl der Threads, 0 wenn Aufträge direkt ausgeführt werden */
+    int thread_count;
+
+    /** Die Threads des Pools */
+    pthread_t *threads;
+
+    /** Schützt die Warteschlange und die done-Flags der Aufträge */
+    pthread_mutex_t mutex;
+
+    /** Signalisiert neue Aufträge oder das Beenden des Pools */
+    pthread_cond_t job_available;
+
+    /** Signalisiert ausgeführte Aufträge */
+    pthread_cond_t job_done;
+
+    /** Erster Auftrag der Warteschlange */
+    POOL_JOB *head;
+
+    /** Letzter Auftrag der Warteschlange */
+    POOL_JOB *tail;
+
+    /** true, wenn die Threads sich beenden sollen */
+    bool shutdown;
+};
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Hauptfunktion der Threads: Aufträge entnehmen und ausführen, bis der Pool
+ * beendet wird.
+ *
+ * @param arg   der Thread-Pool
+ * @return      NULL
+ */
+static void *worker_main(void *arg);
+
+/**
+ * Gibt den Pool nach einem Fehler frei (siehe trap_own). Noch nicht
+ * begonnene Aufträge werden verworfen.
+ *
+ * @param pool  der Thread-Pool
+ */
+static void release_pool(void *pool);
+
+/**
+ * Führt einen Auftrag in einem Thread des Pools unter einer eigenen
+ * Fehlerfalle aus und hält einen Fehler im Auftrag fest.
+ *
+ * @param job   der Auftrag
+ */
+static void run_job(POOL_JOB *job);
+
+
+/* ============================================================================
+ * Funktions-Definitionen
+ * ========================================================================= */
+
+extern int pool_cpu_count(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return (count > 0) ? (int) count : 1;
+}
+
+extern POOL *pool_create(int threads)
+{
+    POOL *pool = (POOL *) malloc(sizeof (POOL));
+    int i;
+
+    if (pool == NULL)
+    {
+        trap_raise(EXIT_RESOURCE_ERROR, EMSG_POOL_CREATE);
+    }
+
+    pool->thread_count = (threads > 1) ? threads : 0;
+    pool->threads = NULL;
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->shutdown = false;
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->job_available, NULL);
+    pthread_cond_init(&pool->job_done, NULL);
+
+    if (pool->thread_count > 0)
+    {
+        pool->threads = (pthread_t *) malloc((size_t) pool->thread_count
+                                             * sizeof (pthread_t));
+        if (pool->threads == NULL)
+        {
+            pool->thread_count = 0;
+            pool_destroy(pool);
+            trap_raise(EXIT_RESOURCE_ERROR, EMSG_POOL_CREATE);
+        }
+        for (i = 0; i < pool->thread_count; i++)
+        {
+            /* Die schon gestarteten Threads wieder beenden */
+            if (pthread_create(&pool->threads[i], NULL, worker_main, pool) != 0)
+            {
+                pool->thread_count = i;
+                pool_destroy(pool);
+                trap_raise(EXIT_RESOURCE_ERROR, EMSG_POOL_CREATE);
+            }
+        }
+    }
+    trap_own(pool, release_pool);
+
+    return pool;
+}
+
+extern void pool_submit(POOL *pool, POOL_JOB *job, POOL_TASK task, void *arg)
+{
+    job->task = task;
+    job->arg = arg;
+    job->done = false;
+    job->status = EXIT_SUCCESS;
+    job->message = NULL;
+    job->next = NULL;
+
+    /* Ohne Threads den Auftrag sofort ausführen */
+    if (pool->thread_count == 0)
+    {
+        task(arg);
+        job->done = true;
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    if (pool->tail == NULL)
+    {
+        pool->head = job;
+    }
+    else
+    {
+        pool->tail->next = job;
+    }
+    pool->tail = job;
+    pthread_cond_signal(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+extern void pool_wait(POOL *pool, POOL_JOB *job)
+{
+    if (pool->thread_count == 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pool->mutex);
+    while (!job->done)
+    {
+        pthread_cond_wait(&pool->job_done, &pool->mutex);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    if (job->status != EXIT_SUCCESS)
+    {
+        trap_raise(job->status, job->message);
+    }
+}
+
+extern void pool_destroy(POOL *pool)
+{
+    int i;
+
+    trap_disown(pool);
+    pthread_mutex_lock(&pool->mutex);
+    pool->shutdown = true;
+    pthread_cond_broadcast(&pool->job_available);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < pool->thread_count; i++)
+    {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->job_available);
+    pthread_cond_destroy(&pool->job_done);
+    free(pool->threads);
+    free(pool);
+}
+
+static void *worker_main(void *arg)
+{
+    POOL *pool = (POOL *) arg;
+
+    pthread_mutex_lock(&pool->mutex);
+    for (;;)
+    {
+        POOL_JOB *job;
+
+        while (pool->head == NULL && !pool->shutdown)
+        {
+            pthread_cond_wait(&pool->job_available, &pool->mutex);
+        }
+
+        /* Erst beenden, wenn die Warteschlange leer ist */
+        if (pool->head == NULL)
+        {
+            break;
+        }
+
+        job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL)
+        {
+            pool->tail = NULL;
+        }
+
+        pthread_mutex_unlock(&pool->mutex);
+        run_job(job);
+        pthread_mutex_lock(&pool->mutex);
+
+        job->done = true;
+        pthread_cond_broadcast(&pool->job_done);
+    }
+    pthread_mutex_unlock(&pool->mutex);
+
+    return NULL;
+}
+
+static void release_pool(void *pool)
+{
+    POOL *self = (POOL *) pool;
+
+    pthread_mutex_lock(&self->mutex);
+    self->head = NULL;
+    self->tail = NULL;
+    pthread_mutex_unlock(&self->mutex);
+    pool_destroy(self);
+}
+
+static void run_job(POOL_JOB *job)
+{
+    TRAP trap;
+
+    trap_set(&trap);
+    if (setjmp(trap.target) == 0)
+    {
+        job->task(job->arg);
+    }
+    job->status = trap_clear(&trap);
+    job->message = trap.message;
+}
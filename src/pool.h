@@ -0,0 +1,116 @@
+/**
+ * @file
+ * In diesem Modul wird ein Thread-Pool realisiert. Aufträge werden in der
+ * Reihenfolge ihrer Übergabe von einer festen Anzahl von Threads
+ * abgearbeitet. Der Aufrufer kann auf das Ende einzelner Aufträge warten.
+ * Meldet ein Auftrag einen Fehler (trap_raise), fängt ihn die Fehlerfalle
+ * seines Threads; pool_wait meldet ihn dann im wartenden Thread erneut.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef POOL_H
+#define POOL_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Funktion, die einen Auftrag ausführt
+ */
+typedef void (*POOL_TASK)(void *arg);
+
+/**
+ * Ein Auftrag an den Thread-Pool. Der Speicher gehört dem Aufrufer und muss
+ * gültig bleiben, bis pool_wait für den Auftrag zurückgekehrt ist.
+ */
+typedef struct POOL_JOB
+{
+    /** auszuführende Funktion */
+    POOL_TASK task;
+
+    /** Argument der Funktion */
+    void *arg;
+
+    /** true, sobald der Auftrag ausgeführt wurde */
+    bool done;
+
+    /** EXIT_*-Code eines Fehlers im Auftrag, sonst EXIT_SUCCESS */
+    int status;
+
+    /** Meldung zum Fehler, NULL wenn keiner auftrat */
+    const char *message;
+
+    /** nächster Auftrag in der Warteschlange (intern) */
+    struct POOL_JOB *next;
+} POOL_JOB;
+
+/**
+ * Thread-Pool (Aufbau nur im Modul bekannt)
+ */
+typedef struct POOL POOL;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Liefert die Anzahl der verfügbaren Prozessorkerne.
+ *
+ * @return  Anzahl der Kerne, mindestens 1
+ */
+extern int pool_cpu_count(void);
+
+/**
+ * Erzeugt einen Thread-Pool. Bei nur einem Thread werden die Aufträge
+ * direkt beim Übergeben im aufrufenden Thread ausgeführt. Meldet einen
+ * Fehler (trap_raise, EXIT_RESOURCE_ERROR), wenn der Pool oder seine
+ * Threads nicht angelegt werden konnten. Ist im Thread
+ * eine Fehlerfalle gesetzt, gibt sie den Pool nach einem Fehler frei und
+ * verwirft dabei die noch nicht begonnenen Aufträge.
+ *
+ * @param threads   Anzahl der Threads
+ * @return          der neue Thread-Pool
+ */
+extern POOL *pool_create(int threads);
+
+/**
+ * Übergibt einen Auftrag an den Thread-Pool.
+ *
+ * @param pool      Thread-Pool
+ * @param job       Speicher für die Verwaltung des Auftrags
+ * @param task      auszuführende Funktion
+ * @param arg       Argument der Funktion
+ */
+extern void pool_submit(POOL *pool, POOL_JOB *job, POOL_TASK task, void *arg);
+
+/**
+ * Wartet, bis der Auftrag ausgeführt wurde. Ist dabei ein Fehler
+ * aufgetreten, wird er im aufrufenden Thread erneut gemeldet.
+ *
+ * @param pool      Thread-Pool
+ * @param job       Auftrag, der zuvor mit pool_submit übergeben wurde
+ */
+extern void pool_wait(POOL *pool, POOL_JOB *job);
+
+/**
+ * Arbeitet alle übergebenen Aufträge ab, beendet die Threads und gibt den
+ * Thread-Pool frei.
+ *
+ * @param pool      freizugebender Thread-Pool
+ */
+extern void pool_destroy(POOL *pool);
+
+/* ------------------------------------------------------------------------- */
+#endif /* POOL_H */
@@ -0,0 +1,482 @@
+/**
+ * @file
+ * In diesem Modul wird ein tabellengesteuerter Entropiekodierer nach dem
+ * Verfahren der asymmetrischen Zahlensysteme (tANS) realisiert.
+ *
+ * Die Häufigkeiten werden auf TANS_TABLE_SIZE normiert und die Symbole
+ * entsprechend ihrer normierten Häufigkeit über die Zustände verteilt. Zwei
+ * Zustände kodieren abwechselnd die geraden und ungeraden Zeichen, damit
+ * der Dekodierer zwei unabhängige Tabellenzugriffe je Durchlauf hat. Der
+ * Kodierer arbeitet die Zeichen von hinten nach vorn ab und schreibt die
+ * Bits in umgekehrter Reihenfolge, so dass der Dekodierer vorwärts liest.
+ *
+ * Aufbau der kodierten Daten: Anzahl der vorkommenden Symbole minus 1
+ * (1 Byte), je Symbol das Symbol (1 Byte) und seine normierte Häufigkeit
+ * (2 Byte, höchstwertiges zuerst), dann die Endzustände beider Kodierer
+ * (je TANS_TABLE_LOG Bit) und die Bits der Zeichen.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "huffman_common.h"
+#include "io.h"
+#include "tans.h"
+#include "trap.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Anzahl der Zustände */
+#define TANS_TABLE_SIZE (1 << TANS_TABLE_LOG)
+
+/** Anzahl der abwechselnd verwendeten Zustände */
+#define TANS_STATES 2
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Eintrag der Dekodiertabelle für einen Zustand
+ */
+typedef struct
+{
+    /** Basis des Folgezustands, zu der die gelesenen Bits addiert werden */
+    uint16_t base;
+
+    /** dekodiertes Symbol */
+    unsigned char symbol;
+
+    /** Anzahl der zu lesenden Bits */
+    unsigned char bits;
+} TANS_DECODE_ENTRY;
+
+/**
+ * Tabellen des Kodierers
+ */
+typedef struct
+{
+    /** Folgezustände, je Symbol zusammenhängend */
+    uint16_t next_state[TANS_TABLE_SIZE];
+
+    /** Je Symbol: aus dem Zustand die Anzahl der Bits bestimmen (16.16) */
+    uint32_t delta_bits[TANS_SYMBOLS];
+
+    /** Je Symbol: Verschiebung in next_state */
+    int32_t delta_state[TANS_SYMBOLS];
+} TANS_ENCODE_TABLE;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Normiert die Häufigkeiten auf die Summe TANS_TABLE_SIZE. Jedes
+ * vorkommende Symbol erhält mindestens 1.
+ *
+ * @param freq      Häufigkeit je Symbol
+ * @param norm      normierte Häufigkeit je Symbol (Ausgabe)
+ */
+static void normalize(const uint64_t freq[], uint16_t norm[]);
+
+/**
+ * Verteilt die Symbole entsprechend ihrer normierten Häufigkeit über die
+ * Zustände.
+ *
+ * @param norm      normierte Häufigkeit je Symbol
+ * @param symbols   Symbol je Zustand (Ausgabe)
+ */
+static void spread_symbols(const uint16_t norm[], unsigned char symbols[]);
+
+/**
+ * Baut die Tabellen des Kodierers auf.
+ *
+ * @param norm      normierte Häufigkeit je Symbol
+ * @param table     aufzubauende Tabellen (Ausgabe)
+ */
+static void build_encode_table(const uint16_t norm[], TANS_ENCODE_TABLE *table);
+
+/**
+ * Baut die Dekodiertabelle auf.
+ *
+ * @param norm      normierte Häufigkeit je Symbol
+ * @param table     aufzubauende Tabelle (Ausgabe)
+ */
+static void build_decode_table(const uint16_t norm[],
+                               TANS_DECODE_ENTRY table[]);
+
+/**
+ * Liefert die Position des höchstwertigen gesetzten Bits, 0 für 0.
+ *
+ * @param value     Zahl
+ * @return          Position des Bits
+ */
+static int highest_bit(uint32_t value);
+
+/**
+ * Reserviert Speicher oder meldet einen Fehler (trap_raise), wenn nicht
+ * genügend Speicher vorhanden ist.
+ *
+ * @param size  Anzahl der Bytes
+ * @return      reservierter Speicher
+ */
+static void *allocate(size_t size);
+
+
+/* ============================================================================
+ * Funktionsdefinitionen
+ * ========================================================================= */
+
+extern uint64_t tans_estimate_bits(const uint64_t freq[TANS_SYMBOLS])
+{
+    uint16_t norm[TANS_SYMBOLS];
+    double bits = 8 + TANS_STATES * TANS_TABLE_LOG;
+    int s;
+
+    normalize(freq, norm);
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        if (norm[s] > 0)
+        {
+            bits += 24 + (double) freq[s]
+                    * (TANS_TABLE_LOG - log2((double) norm[s]));
+        }
+    }
+
+    return (uint64_t) bits;
+}
+
+extern void tans_encode(const unsigned char data[], size_t size,
+                        const uint64_t freq[TANS_SYMBOLS], WRITER *out)
+{
+    uint16_t norm[TANS_SYMBOLS];
+    TANS_ENCODE_TABLE *table;
+    uint32_t state[TANS_STATES] = {TANS_TABLE_SIZE, TANS_TABLE_SIZE};
+    uint32_t *emitted;
+    int used = 0;
+    size_t i;
+    int s;
+
+    normalize(freq, norm);
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        used += norm[s] > 0;
+    }
+    writer_write_char(out, (unsigned char) (used - 1));
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        if (norm[s] > 0)
+        {
+            writer_write_char(out, (unsigned char) s);
+            writer_write_char(out, (unsigned char) (norm[s] >> 8));
+            writer_write_char(out, (unsigned char) norm[s]);
+        }
+    }
+
+    table = (TANS_ENCODE_TABLE *) allocate(sizeof (TANS_ENCODE_TABLE));
+    build_encode_table(norm, table);
+
+    /*
+     * Von hinten nach vorn kodieren. Die Bits jedes Zeichens werden an
+     * seiner Position abgelegt (Wert in Bit 8-31, Anzahl in Bit 0-7) und
+     * danach vorwärts geschrieben.
+     */
+    emitted = (uint32_t *) allocate(size * sizeof (uint32_t));
+    for (i = size; i-- > 0; )
+    {
+        uint32_t *x = &state[i & 1];
+        unsigned char symbol = data[i];
+        uint32_t bits = (*x + table->delta_bits[symbol]) >> 16;
+
+        emitted[i] = (*x & (((uint32_t) 1 << bits) - 1)) << 8 | bits;
+        *x = table->next_state[(int32_t) (*x >> bits)
+                               + table->delta_state[symbol]];
+    }
+
+    for (s = 0; s < TANS_STATES; s++)
+    {
+        writer_write_bits(out, state[s] - TANS_TABLE_SIZE, TANS_TABLE_LOG);
+    }
+    for (i = 0; i < size; i++)
+    {
+        writer_write_bits(out, emitted[i] >> 8, (int) (emitted[i] & 0xFF));
+    }
+    writer_flush_bits(out);
+
+    free(emitted);
+    free(table);
+}
+
+extern bool tans_decode(const unsigned char src[], size_t src_size,
+                        unsigned char dst[], size_t size)
+{
+    uint16_t norm[TANS_SYMBOLS] = {0};
+    TANS_DECODE_ENTRY table[TANS_TABLE_SIZE];
+    uint32_t state[TANS_STATES];
+    const unsigned char *next;
+    const unsigned char *end = src + src_size;
+    uint64_t bits = 0;
+    int count = 0;
+    uint32_t total = 0;
+    size_t used;
+    size_t i;
+    int s;
+
+    /* Normierte Häufigkeiten lesen und prüfen */
+    if (src_size < 1)
+    {
+        return false;
+    }
+    used = (size_t) src[0] + 1;
+    if (src_size < 1 + 3 * used)
+    {
+        return false;
+    }
+    for (i = 0; i < used; i++)
+    {
+        const unsigned char *entry = src + 1 + 3 * i;
+        uint16_t value = (uint16_t) (entry[1] << 8 | entry[2]);
+
+        if (value == 0 || value > TANS_TABLE_SIZE || norm[entry[0]] != 0)
+        {
+            return false;
+        }
+        norm[entry[0]] = value;
+        total += value;
+    }
+    if (total != TANS_TABLE_SIZE)
+    {
+        return false;
+    }
+    build_decode_table(norm, table);
+
+    /*
+     * Die Bits stehen linksbündig im Akkumulator. Ein Durchlauf liest
+     * höchstens TANS_STATES * TANS_TABLE_LOG Bits, deshalb genügt es, den
+     * Akkumulator je Durchlauf einmal aufzufüllen. Hinter dem Ende werden
+     * 0-Bits gelesen; count wird dann negativ.
+     */
+    next = src + 1 + 3 * used;
+#define REFILL() \
+    if (end - next >= 8) \
+    { \
+        uint64_t word = (uint64_t) next[0] << 56 | (uint64_t) next[1] << 48 \
+                | (uint64_t) next[2] << 40 | (uint64_t) next[3] << 32 \
+                | (uint64_t) next[4] << 24 | (uint64_t) next[5] << 16 \
+                | (uint64_t) next[6] << 8 | (uint64_t) next[7]; \
+        bits |= word >> count; \
+        next += (63 - count) >> 3; \
+        count |= 56; \
+    } \
+    else \
+    { \
+        while (count <= 56 && next < end) \
+        { \
+            bits |= (uint64_t) *next++ << (56 - count); \
+            count += 8; \
+        } \
+    }
+#define READ_BITS(N) \
+    ((uint32_t) ((bits >> (63 - (N))) >> 1))
+#define CONSUME(N) \
+    do { bits <<= (N); count -= (N); } while (0)
+
+    REFILL();
+    for (s = 0; s < TANS_STATES; s++)
+    {
+        state[s] = READ_BITS(TANS_TABLE_LOG);
+        CONSUME(TANS_TABLE_LOG);
+    }
+
+    for (i = 0; size - i >= TANS_STATES; i += TANS_STATES)
+    {
+        const TANS_DECODE_ENTRY *e0 = &table[state[0]];
+        const TANS_DECODE_ENTRY *e1 = &table[state[1]];
+
+        REFILL();
+        dst[i] = e0->symbol;
+        dst[i + 1] = e1->symbol;
+        state[0] = e0->base + READ_BITS(e0->bits);
+        CONSUME(e0->bits);
+        state[1] = e1->base + READ_BITS(e1->bits);
+        CONSUME(e1->bits);
+    }
+    if (i < size)
+    {
+        REFILL();
+        dst[i] = table[state[0]].symbol;
+        CONSUME(table[state[0]].bits);
+    }
+#undef REFILL
+#undef READ_BITS
+#undef CONSUME
+
+    return count >= 0;
+}
+
+/* ----------------------------------------------------------------------------
+ * Tabellen
+ * ------------------------------------------------------------------------- */
+
+static void normalize(const uint64_t freq[], uint16_t norm[])
+{
+    uint64_t total = 0;
+    int32_t sum = 0;
+    int s;
+
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        total += freq[s];
+    }
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        norm[s] = 0;
+        if (freq[s] > 0)
+        {
+            uint64_t scaled = (freq[s] * TANS_TABLE_SIZE + total / 2) / total;
+
+            norm[s] = (uint16_t) (scaled > 0 ? scaled : 1);
+            sum += norm[s];
+        }
+    }
+
+    /*
+     * Rundungsfehler beim jeweils häufigsten Symbol ausgleichen, dort
+     * verändert eine Stelle die Länge der kodierten Daten am wenigsten.
+     */
+    while (sum != TANS_TABLE_SIZE)
+    {
+        int largest = -1;
+
+        for (s = 0; s < TANS_SYMBOLS; s++)
+        {
+            if ((sum < TANS_TABLE_SIZE || norm[s] > 1)
+                    && (largest < 0 || norm[s] > norm[largest]))
+            {
+                largest = s;
+            }
+        }
+        if (sum < TANS_TABLE_SIZE)
+        {
+            norm[largest]++;
+            sum++;
+        }
+        else
+        {
+            norm[largest]--;
+            sum--;
+        }
+    }
+}
+
+static void spread_symbols(const uint16_t norm[], unsigned char symbols[])
+{
+    /* Ungerade Schrittweite: jeder Zustand wird genau einmal erreicht */
+    const int step = (TANS_TABLE_SIZE >> 1) + (TANS_TABLE_SIZE >> 3) + 3;
+    int pos = 0;
+    int s;
+    int k;
+
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        for (k = 0; k < norm[s]; k++)
+        {
+            symbols[pos] = (unsigned char) s;
+            pos = (pos + step) & (TANS_TABLE_SIZE - 1);
+        }
+    }
+}
+
+static void build_encode_table(const uint16_t norm[], TANS_ENCODE_TABLE *table)
+{
+    unsigned char symbols[TANS_TABLE_SIZE];
+    int start[TANS_SYMBOLS];
+    int cumul = 0;
+    int s;
+    int u;
+
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        int max_bits = TANS_TABLE_LOG - highest_bit(norm[s] > 0
+                                                   ? norm[s] - 1u : 0);
+
+        start[s] = cumul;
+        table->delta_bits[s] = ((uint32_t) max_bits << 16)
+                - ((uint32_t) norm[s] << max_bits);
+        table->delta_state[s] = cumul - norm[s];
+        cumul += norm[s];
+    }
+
+    spread_symbols(norm, symbols);
+    for (u = 0; u < TANS_TABLE_SIZE; u++)
+    {
+        table->next_state[start[symbols[u]]++] =
+                (uint16_t) (TANS_TABLE_SIZE + u);
+    }
+}
+
+static void build_decode_table(const uint16_t norm[],
+                               TANS_DECODE_ENTRY table[])
+{
+    unsigned char symbols[TANS_TABLE_SIZE];
+    uint32_t next[TANS_SYMBOLS];
+    int s;
+    int u;
+
+    for (s = 0; s < TANS_SYMBOLS; s++)
+    {
+        next[s] = norm[s];
+    }
+
+    spread_symbols(norm, symbols);
+    for (u = 0; u < TANS_TABLE_SIZE; u++)
+    {
+        uint32_t x = next[symbols[u]]++;
+        int bits = TANS_TABLE_LOG - highest_bit(x);
+
+        table[u].symbol = symbols[u];
+        table[u].bits = (unsigned char) bits;
+        table[u].base = (uint16_t) ((x << bits) - TANS_TABLE_SIZE);
+    }
+}
+
+static int highest_bit(uint32_t value)
+{
+    int bit = 0;
+
+    while (value >>= 1)
+    {
+        bit++;
+    }
+
+    return bit;
+}
+
+static void *allocate(size_t size)
+{
+    void *memory = malloc(size > 0 ? size : 1);
+
+    if (memory == NULL)
+    {
+        trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+    }
+
+    return memory;
+}
@@ -0,0 +1,77 @@
+/**
+ * @file
+ * In diesem Modul wird ein tabellengesteuerter Entropiekodierer nach dem
+ * Verfahren der asymmetrischen Zahlensysteme (tANS) realisiert. Anders als
+ * ein Huffman-Code kann er Symbolen auch Bruchteile von Bits zuordnen und
+ * komprimiert deshalb sehr ungleiche Verteilungen besser.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef TANS_H
+#define TANS_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stddef.h>
+
+#include "huffman_common.h"
+#include "io.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/**
+ * Anzahl der unterschiedlichen Symbole (alle Werte eines Bytes)
+ */
+#define TANS_SYMBOLS 256
+
+/**
+ * Zweierlogarithmus der Anzahl der Zustände
+ */
+#define TANS_TABLE_LOG 11
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Schätzt die Länge der mit tans_encode kodierten Daten.
+ *
+ * @param freq      Häufigkeit je Symbol, mindestens ein Symbol kommt vor
+ * @return          geschätzte Länge in Bit
+ */
+extern uint64_t tans_estimate_bits(const uint64_t freq[TANS_SYMBOLS]);
+
+/**
+ * Kodiert die Zeichen: die normierten Häufigkeiten, dann den Bitstrom.
+ *
+ * @param data      zu kodierende Daten
+ * @param size      Anzahl der Zeichen, mindestens 1
+ * @param freq      Häufigkeit je Symbol in data
+ * @param out       Ausgabestrom
+ */
+extern void tans_encode(const unsigned char data[], size_t size,
+                        const uint64_t freq[TANS_SYMBOLS], WRITER *out);
+
+/**
+ * Dekodiert Zeichen, die mit tans_encode kodiert wurden.
+ *
+ * @param src       kodierte Daten
+ * @param src_size  Anzahl der kodierten Zeichen
+ * @param dst       dekodierte Zeichen (Ausgabe)
+ * @param size      Anzahl der zu dekodierenden Zeichen
+ * @return          false, wenn die kodierten Daten ungültig sind
+ */
+extern bool tans_decode(const unsigned char src[], size_t src_size,
+                        unsigned char dst[], size_t size);
+
+/* ------------------------------------------------------------------------- */
+#endif /* TANS_H */
@@ -0,0 +1,146 @@
+/**
+ * @file
+ * In diesem Modul wird die Fehlerfalle der Threads realisiert.
+ *
+ * Jeder Thread hat einen eigenen Zeiger auf seine zuletzt gesetzte Falle;
+ * Fallen verschiedener Threads sind damit unabhängig voneinander. Die
+ * Ressourcen einer Falle bilden einen Stapel, der bei einem Fehler von oben
+ * abgebaut wird: Später angelegte Ressourcen (etwa ein Thread-Pool) werden
+ * vor früher angelegten (etwa dem Speicher seiner Aufträge) freigegeben.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "huffman_common.h"
+#include "trap.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Anfängliche Anzahl der Einträge der Ressourcen einer Falle */
+#define MIN_TRAP_OWNED 32
+
+/** Fehlermeldung bei fehlendem Speicher */
+#define EMSG_OUT_OF_MEMORY "Nicht genuegend Speicher vorhanden."
+
+
+/* ============================================================================
+ * Globale Variablen
+ * ========================================================================= */
+
+/** Zuletzt gesetzte Falle des aktuellen Threads, NULL wenn keine */
+static __thread TRAP *current_trap = NULL;
+
+
+/* ============================================================================
+ * Funktions-Definitionen
+ * ========================================================================= */
+
+extern void trap_set(TRAP *trap)
+{
+    trap->caller = current_trap;
+    trap->status = EXIT_SUCCESS;
+    trap->message = NULL;
+    trap->owned = NULL;
+    trap->owned_count = 0;
+    trap->owned_capacity = 0;
+    current_trap = trap;
+}
+
+extern int trap_clear(TRAP *trap)
+{
+    /*
+     * Jeder Eintrag wird vor dem Freigeben entfernt, damit ein trap_disown
+     * in der Freigabefunktion ihn nicht mehr findet.
+     */
+    while (trap->owned_count > 0)
+    {
+        TRAP_RESOURCE *entry = &trap->owned[--trap->owned_count];
+
+        entry->release(entry->resource);
+    }
+    free(trap->owned);
+    trap->owned = NULL;
+    trap->owned_capacity = 0;
+    current_trap = trap->caller;
+
+    return trap->status;
+}
+
+extern void trap_raise(int status, const char *message)
+{
+    TRAP *trap = current_trap;
+
+    if (trap == NULL)
+    {
+        fprintf(stderr, "[ERROR]: %s\n", message);
+        exit(status);
+    }
+    trap->status = status;
+    trap->message = message;
+    longjmp(trap->target, 1);
+}
+
+extern void trap_own(void *resource, TRAP_RELEASE release)
+{
+    TRAP *trap = current_trap;
+
+    if (trap == NULL)
+    {
+        return;
+    }
+
+    if (trap->owned_count == trap->owned_capacity)
+    {
+        size_t capacity = (trap->owned_capacity > 0)
+                ? 2 * trap->owned_capacity : MIN_TRAP_OWNED;
+        TRAP_RESOURCE *owned = (TRAP_RESOURCE *) realloc(trap->owned,
+                capacity * sizeof (TRAP_RESOURCE));
+
+        /* Eine Ressource, die die Falle nicht aufnehmen kann, gleich freigeben */
+        if (owned == NULL)
+        {
+            release(resource);
+            trap_raise(EXIT_RESOURCE_ERROR, EMSG_OUT_OF_MEMORY);
+        }
+        trap->owned = owned;
+        trap->owned_capacity = capacity;
+    }
+    trap->owned[trap->owned_count].resource = resource;
+    trap->owned[trap->owned_count].release = release;
+    trap->owned_count++;
+}
+
+extern void trap_disown(void *resource)
+{
+    TRAP *trap = current_trap;
+    size_t i;
+
+    if (trap == NULL || resource == NULL)
+    {
+        return;
+    }
+
+    /* Meist ist es die zuletzt übergebene Ressource */
+    for (i = trap->owned_count; i > 0; i--)
+    {
+        if (trap->owned[i - 1].resource == resource)
+        {
+            memmove(&trap->owned[i - 1], &trap->owned[i],
+                    (trap->owned_count - i) * sizeof (TRAP_RESOURCE));
+            trap->owned_count--;
+            return;
+        }
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * @file
+ * In diesem Modul wird die Fehlerfalle der Threads realisiert. Ist im
+ * aktuellen Thread eine Falle gesetzt, bricht ein Fehler (trap_raise) nicht
+ * das Programm ab, sondern kehrt mit longjmp zur Funktion zurück, die die
+ * Falle gesetzt hat. Die bis dahin der Falle übergebenen Ressourcen werden
+ * dort in umgekehrter Reihenfolge freigegeben.
+ *
+ * Verwendung:
+ *
+ *     TRAP trap;
+ *
+ *     trap_set(&trap);
+ *     if (setjmp(trap.target) == 0)
+ *     {
+ *         ... Aufrufe, die trap_raise aufrufen können ...
+ *     }
+ *     if (trap_clear(&trap) != EXIT_SUCCESS)
+ *     {
+ *         ... Fehler trap.status mit der Meldung trap.message behandeln ...
+ *     }
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+#ifndef TRAP_H
+#define TRAP_H
+/* ------------------------------------------------------------------------- */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <setjmp.h>
+#include <stddef.h>
+
+#include "huffman_common.h"
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Funktion, die eine Ressource nach einem Fehler freigibt. Sie darf selbst
+ * keinen Fehler melden.
+ */
+typedef void (*TRAP_RELEASE)(void *resource);
+
+/**
+ * Eine Ressource, die bei einem Fehler freigegeben wird
+ */
+typedef struct
+{
+    /** die Ressource */
+    void *resource;
+
+    /** Funktion, die sie freigibt */
+    TRAP_RELEASE release;
+} TRAP_RESOURCE;
+
+/**
+ * Fehlerfalle. Der Speicher gehört dem Aufrufer und muss gültig bleiben,
+ * bis trap_clear aufgerufen wurde.
+ */
+typedef struct TRAP
+{
+    /** Rücksprungziel */
+    jmp_buf target;
+
+    /** Falle, die vorher im Thread gesetzt war, oder NULL */
+    struct TRAP *caller;
+
+    /** EXIT_*-Code des Fehlers, EXIT_SUCCESS wenn keiner auftrat */
+    int status;
+
+    /** Meldung zum Fehler, NULL wenn keiner auftrat */
+    const char *message;
+
+    /** Ressourcen, die bei einem Fehler freigegeben werden */
+    TRAP_RESOURCE *owned;
+
+    /** Anzahl der Einträge in owned */
+    size_t owned_count;
+
+    /** Anzahl der Einträge, für die owned Platz hat */
+    size_t owned_capacity;
+} TRAP;
+
+
+/* ============================================================================
+ * Funktions-Prototypen
+ * ========================================================================= */
+
+/**
+ * Setzt die Falle im aktuellen Thread. Unmittelbar danach muss der
+ * Aufrufer setjmp(trap->target) aufrufen.
+ *
+ * @param trap      zu setzende Falle
+ */
+extern void trap_set(TRAP *trap);
+
+/**
+ * Entfernt die Falle wieder und stellt die vorher gesetzte Falle her.
+ * Nach einem Fehler werden die noch übergebenen Ressourcen in umgekehrter
+ * Reihenfolge ihrer Übergabe freigegeben.
+ *
+ * @param trap      zuletzt gesetzte Falle des Threads
+ * @return          trap->status
+ */
+extern int trap_clear(TRAP *trap);
+
+/**
+ * Meldet einen Fehler. Ist eine Falle gesetzt, kehrt die Funktion zu ihr
+ * zurück, sonst gibt sie die Meldung aus und beendet das Programm mit dem
+ * Code status.
+ *
+ * @param status    EXIT_*-Code des Fehlers
+ * @param message   Meldung zum Fehler (eine Zeichenkettenkonstante)
+ */
+extern void trap_raise(int status, const char *message);
+
+/**
+ * Übergibt eine Ressource an die Falle des aktuellen Threads, die sie bei
+ * einem Fehler freigibt. Ohne Falle geschieht nichts.
+ *
+ * @param resource  die Ressource
+ * @param release   Funktion, die sie freigibt
+ */
+extern void trap_own(void *resource, TRAP_RELEASE release);
+
+/**
+ * Nimmt eine Ressource wieder aus der Falle des aktuellen Threads, etwa
+ * weil sie regulär freigegeben wird. Ohne Falle oder für eine nicht
+ * übergebene Ressource geschieht nichts.
+ *
+ * @param resource  die Ressource
+ */
+extern void trap_disown(void *resource);
+
+/* ------------------------------------------------------------------------- */
+#endif /* TRAP_H */
@@ -0,0 +1,1046 @@
+/**
+ * @file
+ * Testfälle für das Komprimieren und Dekomprimieren. Erzeugte Daten vieler
+ * Größen und Verteilungen werden auf allen Wegen (Speicherbereiche und
+ * Dateien, ein und mehrere Threads, mit Prüfsummen, Wörterbuch und
+ * Ausschnitten) komprimiert und wieder dekomprimiert; das Ergebnis muss
+ * genau der Eingabe entsprechen. Was auf einem Weg komprimiert wurde, wird
+ * auch auf dem jeweils anderen dekomprimiert.
+ *
+ * Die Leistungstests messen als Maßstab in derselben Messung, wie lange das
+ * Kopieren derselben Daten mit memcpy dauert, und erlauben je Level ein
+ * festes Vielfaches davon. So gelten sie auf jeder Maschine, ohne
+ * gespeicherte Mindestwerte.
+ *
+ * @author Ulrike Griefahn
+ * @date 2026-10-17
+ */
+
+/* ============================================================================
+ * Includes
+ * ========================================================================= */
+
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <unistd.h>
+
+#include "huffman_common.h"
+#include "io.h"
+#include "huffman.h"
+
+
+/* ============================================================================
+ * Symbolische Konstanten
+ * ========================================================================= */
+
+/** Größe der Daten für den Leistungstest */
+#define PERF_SIZE (2 * 1024 * 1024)
+
+/** Anzahl der Messungen, von denen die schnellste zählt */
+#define PERF_RUNS 3
+
+/** Größe der nicht komprimierbaren Daten für testIncompressibleSpeed */
+#define STORED_SIZE (16 * 1024 * 1024)
+
+/**
+ * Höchstens so viel länger als das Kopieren derselben Daten mit memcpy darf
+ * das Komprimieren nicht komprimierbarer Daten dauern. Der Wert ist für die
+ * Testübersetzung ohne Optimierung und mit Coverage bemessen; eine
+ * LZ77-Zerlegung derselben Daten dauert ein Vielfaches davon.
+ */
+#define STORED_MAX_COPY_RATIO 200.0
+
+/** Vorlage für die Namen temporärer Dateien */
+#define TEMP_TEMPLATE "/tmp/huffman_test_XXXXXX"
+
+/** Anzahl der Levels */
+#define LEVEL_COUNT 7
+
+/**
+ * Höchstens so viel länger als das Kopieren derselben Daten mit memcpy darf
+ * das Dekomprimieren im Leistungstest dauern. Wie die Werte für das
+ * Komprimieren ist er für die Testübersetzung ohne Optimierung und mit
+ * Coverage bemessen, mit etwa dem Dreifachen der gemessenen Zeit als
+ * Abstand für Schwankungen.
+ */
+#define PERF_MAX_DECOMPRESS_RATIO 1500.0
+
+/**
+ * Höchstens so viel länger als das Kopieren derselben Daten mit memcpy darf
+ * das Komprimieren im Leistungstest je Level (ab 1) dauern; höhere Levels
+ * suchen länger nach Wiederholungen.
+ */
+static const double PERF_MAX_COMPRESS_RATIO[LEVEL_COUNT] = {
+    5000.0, 5000.0, 5000.0, 8000.0, 10000.0, 16000.0, 40000.0
+};
+
+
+/* ============================================================================
+ * Datentypen
+ * ========================================================================= */
+
+/**
+ * Verteilung der Zeichen in erzeugten Daten
+ */
+typedef enum
+{
+    /** gleichverteilte Zufallszahlen, nicht komprimierbar */
+    UNIFORM,
+
+    /** wenige häufige und viele seltene Zeichen (geometrisch verteilt) */
+    SKEWED,
+
+    /** Wörter aus einem kleinen Wortschatz mit Leerzeichen und Zeilen */
+    TEXT,
+
+    /** Wiederholungen zufälliger Zeichen mit zufälliger Länge */
+    RUNS,
+
+    /** ein einziges, wiederholtes Zeichen */
+    SINGLE,
+
+    /** alle 256 Zeichen gleich oft in fester Reihenfolge */
+    ALL_SYMBOLS,
+
+    /** Anzahl der Verteilungen */
+    DISTRIBUTION_COUNT
+} DISTRIBUTION;
+
+/**
+ * Temporäre Datei, die beim Verlassen des Gültigkeitsbereichs gelöscht
+ * wird
+ */
+class TempFile
+{
+public:
+    TempFile() : name(TEMP_TEMPLATE)
+    {
+        int fd = mkstemp(&name[0]);
+
+        CPPUNIT_ASSERT_MESSAGE("temporaere Datei", fd >= 0);
+        close(fd);
+    }
+
+    ~TempFile()
+    {
+        unlink(name.c_str());
+    }
+
+    /** Name für die Funktionen des Moduls huffman */
+    char *c_name()
+    {
+        return &name[0];
+    }
+
+private:
+    std::string name;
+};
+
+/** Daten im Speicher */
+typedef std::vector<unsigned char> BYTES;
+
+/** Kopf eines Blocks: unkomprimierte und komprimierte Länge */
+typedef std::pair<uint32_t, uint32_t> BLOCK_SIZES;
+
+
+/* ============================================================================
+ * Hilfsfunktionen
+ * ========================================================================= */
+
+/**
+ * Liefert die nächste Zahl eines Pseudozufallsgenerators (xorshift32).
+ *
+ * @param state     Zustand des Generators, nicht 0
+ * @return          Zufallszahl
+ */
+static uint32_t next_random(uint32_t *state)
+{
+    uint32_t x = *state;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return x;
+}
+
+/**
+ * Erzeugt reproduzierbare Testdaten.
+ *
+ * @param distribution  Verteilung der Zeichen
+ * @param size          Anzahl der Zeichen
+ * @param seed          Startwert des Zufallsgenerators
+ * @return              erzeugte Daten
+ */
+static BYTES generate(DISTRIBUTION distribution, size_t size, uint32_t seed)
+{
+    static const char *words[] =
+    {
+        "der", "die", "das", "und", "Block", "Huffman", "Codetabelle",
+        "komprimiert", "Datei", "Zeichen", "wird", "mit", "einem", "nicht",
+        "Laenge", "Bitstrom", "schnell", "Wiederholung", "0x1F", "2026"
+    };
+    const size_t word_count = sizeof (words) / sizeof (words[0]);
+    uint32_t state = seed * 2654435761u + 1;
+    BYTES data;
+
+    data.reserve(size);
+    while (data.size() < size)
+    {
+        uint32_t r = next_random(&state);
+
+        switch (distribution)
+        {
+        case UNIFORM:
+            data.push_back((unsigned char) r);
+            break;
+
+        case SKEWED:
+        {
+            unsigned char symbol = 'A';
+
+            while ((r & 1) != 0 && symbol < 'A' + 30)
+            {
+                symbol++;
+                r >>= 1;
+            }
+            data.push_back(symbol);
+            break;
+        }
+
+        case TEXT:
+        {
+            const char *word = words[r % word_count];
+
+            data.insert(data.end(), word, word + strlen(word));
+            data.push_back((r >> 16) % 12 == 0 ? '\n' : ' ');
+            break;
+        }
+
+        case RUNS:
+            data.insert(data.end(), 1 + (r >> 8) % 300, (unsigned char) r);
+            break;
+
+        case SINGLE:
+            data.push_back('a');
+            break;
+
+        default:
+            data.push_back((unsigned char) (data.size() * 167));
+            break;
+        }
+    }
+    data.resize(size);
+
+    return data;
+}
+
+/**
+ * Schreibt Daten in eine Datei.
+ *
+ * @param filename  Name der Datei
+ * @param data      zu schreibende Daten
+ */
+static void write_file(const char filename[], const BYTES &data)
+{
+    std::ofstream file(filename, std::ios::binary);
+
+    file.write((const char *) (data.empty() ? NULL : &data[0]),
+               (std::streamsize) data.size());
+    CPPUNIT_ASSERT_MESSAGE(filename, file.good());
+}
+
+/**
+ * Liest eine Datei vollständig.
+ *
+ * @param filename  Name der Datei
+ * @return          Inhalt der Datei
+ */
+static BYTES read_file(const char filename[])
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+
+    CPPUNIT_ASSERT_MESSAGE(filename, file.good());
+    content << file.rdbuf();
+    std::string text = content.str();
+
+    return BYTES(text.begin(), text.end());
+}
+
+/**
+ * Komprimiert Daten mit compress_buffer.
+ *
+ * @param data      unkomprimierte Daten
+ * @param options   Einstellungen
+ * @return          komprimierte Daten
+ */
+static BYTES pack_buffer(const BYTES &data, const HUFFMAN_OPTIONS *options)
+{
+    BYTES packed(compress_bound(data.size(), options));
+    size_t size = 0;
+
+    CPPUNIT_ASSERT_EQUAL((int) EXIT_SUCCESS,
+                         compress_buffer(data.empty() ? NULL : &data[0],
+                                         data.size(), &packed[0],
+                                         packed.size(), &size, options));
+    CPPUNIT_ASSERT(size <= packed.size());
+    packed.resize(size);
+
+    return packed;
+}
+
+/**
+ * Dekomprimiert Daten mit decompressed_size und decompress_buffer.
+ *
+ * @param packed    komprimierte Daten
+ * @return          dekomprimierte Daten
+ */
+static BYTES unpack_buffer(const BYTES &packed)
+{
+    uint64_t expected = 0;
+    size_t size = 0;
+    BYTES data;
+
+    CPPUNIT_ASSERT_EQUAL((int) EXIT_SUCCESS,
+                         decompressed_size(&packed[0], packed.size(),
+                                           &expected));
+    data.resize((size_t) expected + 1);
+    CPPUNIT_ASSERT_EQUAL((int) EXIT_SUCCESS,
+                         decompress_buffer(&packed[0], packed.size(),
+                                           &data[0], data.size(), &size));
+    CPPUNIT_ASSERT_EQUAL((uint64_t) size, expected);
+    data.resize(size);
+
+    return data;
+}
+
+/**
+ * Komprimiert Daten über Dateien mit compress_with_options.
+ *
+ * @param data      unkomprimierte Daten
+ * @param options   Einstellungen
+ * @return          Inhalt der komprimierten Datei
+ */
+static BYTES pack_file(const BYTES &data, const HUFFMAN_OPTIONS *options)
+{
+    TempFile in;
+    TempFile out;
+
+    write_file(in.c_name(), data);
+    compress_with_options(in.c_name(), out.c_name(), options);
+
+    return read_file(out.c_name());
+}
+
+/**
+ * Dekomprimiert Daten über Dateien mit decompress_with_options.
+ *
+ * @param packed    Inhalt der komprimierten Datei
+ * @param options   Einstellungen
+ * @return          Inhalt der dekomprimierten Datei
+ */
+static BYTES unpack_file(const BYTES &packed, const HUFFMAN_OPTIONS *options)
+{
+    TempFile in;
+    TempFile out;
+
+    write_file(in.c_name(), packed);
+    decompress_with_options(in.c_name(), out.c_name(), options);
+
+    return read_file(out.c_name());
+}
+
+/**
+ * Liest die Blockköpfe komprimierter Daten bis zum Ende der Blöcke.
+ *
+ * @param packed    komprimierte Daten
+ * @return          Längen je Block
+ */
+static std::vector<BLOCK_SIZES> read_block_sizes(const BYTES &packed)
+{
+    std::vector<BLOCK_SIZES> blocks;
+    size_t pos = 3;
+
+    /* Hinter "HC" und der Version: je Block zwei Längen (big endian) */
+    for (;;)
+    {
+        uint32_t value[2] = {0, 0};
+        int k;
+        int i;
+
+        for (k = 0; k < 2; k++)
+        {
+            CPPUNIT_ASSERT(pos + 4 <= packed.size());
+            for (i = 0; i < 4; i++)
+            {
+                value[k] = (value[k] << 8) | packed[pos++];
+            }
+            if (value[0] == 0)
+            {
+                return blocks;
+            }
+        }
+        blocks.push_back(BLOCK_SIZES(value[0], value[1]));
+        pos += value[1];
+    }
+}
+
+/**
+ * Komprimiert Daten auf beiden Wegen und prüft, dass jedes Ergebnis auf
+ * beiden Wegen wieder genau die Daten ergibt.
+ *
+ * @param data      unkomprimierte Daten
+ * @param options   Einstellungen
+ * @param label     Beschreibung der Daten für Fehlermeldungen
+ */
+static void check_round_trip(const BYTES &data, const HUFFMAN_OPTIONS *options,
+                             const std::string &label)
+{
+    BYTES from_buffer = pack_buffer(data, options);
+    BYTES from_file = pack_file(data, options);
+
+    CPPUNIT_ASSERT_MESSAGE(label + ", Speicher -> Speicher",
+                           unpack_buffer(from_buffer) == data);
+    CPPUNIT_ASSERT_MESSAGE(label + ", Speicher -> Datei",
+                           unpack_file(from_buffer, options) == data);
+    CPPUNIT_ASSERT_MESSAGE(label + ", Datei -> Speicher",
+                           unpack_buffer(from_file) == data);
+    CPPUNIT_ASSERT_MESSAGE(label + ", Datei -> Datei",
+                           unpack_file(from_file, options) == data);
+}
+
+/**
+ * Beschreibt Testdaten für Fehlermeldungen.
+ *
+ * @param distribution  Verteilung der Zeichen
+ * @param size          Anzahl der Zeichen
+ * @param options       Einstellungen
+ * @return              Beschreibung
+ */
+static std::string describe(DISTRIBUTION distribution, size_t size,
+                            const HUFFMAN_OPTIONS *options)
+{
+    std::ostringstream text;
+
+    text << "Verteilung " << (int) distribution << ", " << size
+         << " Bytes, Level " << options->level << ", Block "
+         << options->block_size << ", " << options->threads << " Threads"
+         << (options->checksum ? ", Pruefsummen" : "");
+
+    return text.str();
+}
+
+/**
+ * Liefert die Zeit einer monotonen Uhr.
+ *
+ * @return  Zeit in Sekunden
+ */
+static double now_seconds(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/**
+ * Misst, wie lange das Kopieren von Daten mit memcpy in einen bereits
+ * benutzten Zielbereich dauert (schnellste von PERF_RUNS Messungen). Als
+ * Maßstab in derselben Messung macht es Zeiten vergleichbar, unabhängig von
+ * der Maschine.
+ *
+ * @param data      zu kopierende Daten
+ * @return          Zeit in Sekunden
+ */
+static double copy_seconds(const BYTES &data)
+{
+    BYTES target(data.size(), 0);
+    double best = 0.0;
+    int run;
+
+    for (run = 0; run < PERF_RUNS; run++)
+    {
+        double start = now_seconds();
+
+        memcpy(&target[0], &data[0], data.size());
+        if (best == 0.0 || now_seconds() - start < best)
+        {
+            best = now_seconds() - start;
+        }
+    }
+    CPPUNIT_ASSERT(target == data);
+
+    return best;
+}
+
+
+/* ============================================================================
+ * Testfälle
+ * ========================================================================= */
+
+/**
+ * Testfälle für Komprimieren und Dekomprimieren
+ */
+class HuffmanTest : public CPPUNIT_NS::TestFixture
+{
+    CPPUNIT_TEST_SUITE(HuffmanTest);
+    CPPUNIT_TEST(testEmpty);
+    CPPUNIT_TEST(testRepeatedByte);
+    CPPUNIT_TEST(testAllSymbols);
+    CPPUNIT_TEST(testBufferBoundaries);
+    CPPUNIT_TEST(testDistributions);
+    CPPUNIT_TEST(testLevels);
+    CPPUNIT_TEST(testRepeatedRandom);
+    CPPUNIT_TEST(testIncompressibleSpeed);
+    CPPUNIT_TEST(testBlocksAndThreads);
+    CPPUNIT_TEST(testChecksums);
+    CPPUNIT_TEST(testCorruptedChecksum);
+    CPPUNIT_TEST(testSmallDestination);
+    CPPUNIT_TEST(testRange);
+    CPPUNIT_TEST(testSmallBlocks);
+    CPPUNIT_TEST(testSmallStoredBlocks);
+    CPPUNIT_TEST(testDictionary);
+    CPPUNIT_TEST(testBatchErrors);
+    CPPUNIT_TEST(testThroughput);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp()
+    {
+        init_options(&options);
+        options.threads = 2;
+    }
+
+    void tearDown()
+    {
+        unload_dictionaries();
+    }
+
+private:
+    /** Einstellungen des Testfalls */
+    HUFFMAN_OPTIONS options;
+
+    /**
+     * Prüft Daten einer Verteilung in mehreren Größen.
+     *
+     * @param distribution  Verteilung der Zeichen
+     * @param sizes         Größen
+     * @param count         Anzahl der Größen
+     */
+    void check_sizes(DISTRIBUTION distribution, const size_t sizes[],
+                     size_t count)
+    {
+        size_t i;
+
+        for (i = 0; i < count; i++)
+        {
+            check_round_trip(generate(distribution, sizes[i], (uint32_t) i),
+                             &options,
+                             describe(distribution, sizes[i], &options));
+        }
+    }
+
+    /** Leere Eingabe */
+    void testEmpty()
+    {
+        BYTES empty;
+        uint64_t size = 1;
+        BYTES packed = pack_buffer(empty, &options);
+
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_SUCCESS,
+                             decompressed_size(&packed[0], packed.size(),
+                                               &size));
+        CPPUNIT_ASSERT_EQUAL((uint64_t) 0, size);
+        check_round_trip(empty, &options, "leer");
+    }
+
+    /** Ein einziges, wiederholtes Zeichen */
+    void testRepeatedByte()
+    {
+        const size_t sizes[] =
+        {
+            1, 2, 3, 100, BUF_SIZE, HUFFMAN_STD_BLOCK_SIZE + 1
+        };
+
+        check_sizes(SINGLE, sizes, sizeof (sizes) / sizeof (sizes[0]));
+    }
+
+    /** Alle 256 Zeichen, gleich oft und zufällig */
+    void testAllSymbols()
+    {
+        const size_t sizes[] = {256, 257, 4096, 100000};
+
+        check_sizes(ALL_SYMBOLS, sizes, sizeof (sizes) / sizeof (sizes[0]));
+        check_sizes(UNIFORM, sizes, sizeof (sizes) / sizeof (sizes[0]));
+    }
+
+    /** Größen um die Puffer des Lesens und Schreibens */
+    void testBufferBoundaries()
+    {
+        const size_t sizes[] =
+        {
+            BUF_SIZE - 1, BUF_SIZE, BUF_SIZE + 1,
+            2 * BUF_SIZE - 1, 2 * BUF_SIZE, 2 * BUF_SIZE + 1,
+            PIPELINE_BUF_SIZE - 1, PIPELINE_BUF_SIZE, PIPELINE_BUF_SIZE + 1
+        };
+
+        check_sizes(TEXT, sizes, sizeof (sizes) / sizeof (sizes[0]));
+        check_sizes(SKEWED, sizes, sizeof (sizes) / sizeof (sizes[0]));
+    }
+
+    /** Alle Verteilungen in kleinen und mittleren Größen */
+    void testDistributions()
+    {
+        const size_t sizes[] = {1, 7, 63, 64, 255, 256, 257, 1000, 65536,
+                                300000};
+        int distribution;
+
+        for (distribution = 0; distribution < DISTRIBUTION_COUNT;
+             distribution++)
+        {
+            check_sizes((DISTRIBUTION) distribution, sizes,
+                        sizeof (sizes) / sizeof (sizes[0]));
+        }
+    }
+
+    /** Alle Levels */
+    void testLevels()
+    {
+        const size_t sizes[] = {5000, 200000};
+
+        for (options.level = 1; options.level <= LEVEL_COUNT; options.level++)
+        {
+            check_sizes(TEXT, sizes, sizeof (sizes) / sizeof (sizes[0]));
+            check_sizes(SKEWED, sizes, sizeof (sizes) / sizeof (sizes[0]));
+            check_sizes(RUNS, sizes, sizeof (sizes) / sizeof (sizes[0]));
+        }
+    }
+
+    /**
+     * Wiederholte Zufallsdaten: einzeln nicht komprimierbar, die LZ77-Zerlegung
+     * findet aber die Wiederholungen, deshalb wird nicht gespeichert
+     */
+    void testRepeatedRandom()
+    {
+        BYTES copy = generate(UNIFORM, 32768, 11);
+        BYTES data;
+        int i;
+
+        for (i = 0; i < 4; i++)
+        {
+            data.insert(data.end(), copy.begin(), copy.end());
+        }
+        for (options.level = 1; options.level <= LEVEL_COUNT; options.level++)
+        {
+            std::ostringstream label;
+            size_t packed_size = pack_buffer(data, &options).size();
+
+            label << "Level " << options.level << ": " << packed_size
+                  << " Byte";
+            CPPUNIT_ASSERT_MESSAGE(label.str(),
+                                   packed_size < copy.size() + copy.size() / 10);
+            check_round_trip(data, &options, label.str());
+        }
+    }
+
+    /**
+     * Nicht komprimierbare Daten werden auf allen Levels gespeichert und
+     * kosten nur ein Vielfaches des Kopierens, keine LZ77-Zerlegung
+     */
+    void testIncompressibleSpeed()
+    {
+        BYTES data = generate(UNIFORM, STORED_SIZE, 19);
+        double copy = copy_seconds(data);
+
+        options.threads = 1;
+        for (options.level = 1; options.level <= LEVEL_COUNT; options.level++)
+        {
+            std::ostringstream label;
+            double best = 0.0;
+            size_t packed_size = 0;
+            int run;
+
+            for (run = 0; run < PERF_RUNS; run++)
+            {
+                double start = now_seconds();
+
+                packed_size = pack_buffer(data, &options).size();
+                if (best == 0.0 || now_seconds() - start < best)
+                {
+                    best = now_seconds() - start;
+                }
+            }
+            label << "Level " << options.level << ": " << best * 1000.0
+                  << " ms, Kopieren " << copy * 1000.0 << " ms";
+            CPPUNIT_ASSERT_MESSAGE(label.str(), packed_size
+                                   <= compress_bound(data.size(), &options));
+            CPPUNIT_ASSERT_MESSAGE(label.str(), packed_size
+                                   > data.size() - data.size() / 100);
+            CPPUNIT_ASSERT_MESSAGE(label.str(),
+                                   best <= STORED_MAX_COPY_RATIO * copy);
+        }
+    }
+
+    /** Kleine Blöcke mit Blockverzeichnis, ein und mehrere Threads */
+    void testBlocksAndThreads()
+    {
+        const size_t sizes[] = {4095, 4096, 4097, 300000};
+        const uint32_t block_sizes[] = {1024, 4096, 65536};
+        const int thread_counts[] = {1, 4};
+        size_t b;
+        size_t t;
+
+        for (b = 0; b < sizeof (block_sizes) / sizeof (block_sizes[0]); b++)
+        {
+            for (t = 0; t < sizeof (thread_counts) / sizeof (thread_counts[0]);
+                 t++)
+            {
+                options.block_size = block_sizes[b];
+                options.threads = thread_counts[t];
+                check_sizes(TEXT, sizes, sizeof (sizes) / sizeof (sizes[0]));
+                check_sizes(UNIFORM, sizes, sizeof (sizes) / sizeof (sizes[0]));
+            }
+        }
+    }
+
+    /** Prüfsummen je Block */
+    void testChecksums()
+    {
+        const size_t sizes[] = {1, 300, 70000};
+        int distribution;
+
+        options.checksum = true;
+        options.block_size = 16384;
+        for (distribution = 0; distribution < DISTRIBUTION_COUNT;
+             distribution++)
+        {
+            check_sizes((DISTRIBUTION) distribution, sizes,
+                        sizeof (sizes) / sizeof (sizes[0]));
+        }
+    }
+
+    /** Ein veränderter Blockinhalt wird mit Prüfsumme erkannt */
+    void testCorruptedChecksum()
+    {
+        BYTES data = generate(TEXT, 50000, 3);
+        BYTES packed;
+        BYTES unpacked(data.size());
+        size_t size = 0;
+
+        options.checksum = true;
+        packed = pack_buffer(data, &options);
+
+        /* Ein Bit im Blockinhalt hinter Dateikopf und Blockkopf kippen */
+        packed[packed.size() / 2] ^= 0x10;
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_DC_ERROR,
+                             decompress_buffer(&packed[0], packed.size(),
+                                               &unpacked[0], unpacked.size(),
+                                               &size));
+    }
+
+    /**
+     * compress_buffer schreibt direkt in den Zielbereich und nie über
+     * dessen Ende hinaus; ein zu kleiner Zielbereich wird beim Komprimieren
+     * und Dekomprimieren als EXIT_DST_TOO_SMALL gemeldet
+     */
+    void testSmallDestination()
+    {
+        BYTES data = generate(TEXT, 300000, 17);
+        BYTES packed = pack_buffer(data, &options);
+        BYTES target(packed.size() + 1, 0xA5);
+        BYTES unpacked(data.size() - 1);
+        size_t size = 0;
+
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_SUCCESS,
+                             compress_buffer(&data[0], data.size(), &target[0],
+                                             packed.size(), &size, &options));
+        CPPUNIT_ASSERT_EQUAL(packed.size(), size);
+        CPPUNIT_ASSERT(std::equal(packed.begin(), packed.end(),
+                                  target.begin()));
+        CPPUNIT_ASSERT_EQUAL((unsigned char) 0xA5, target[packed.size()]);
+
+        target.assign(packed.size(), 0xA5);
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_DST_TOO_SMALL,
+                             compress_buffer(&data[0], data.size(), &target[0],
+                                             packed.size() - 1, &size,
+                                             &options));
+        CPPUNIT_ASSERT_EQUAL((unsigned char) 0xA5, target[packed.size() - 1]);
+
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_DST_TOO_SMALL,
+                             decompress_buffer(&packed[0], packed.size(),
+                                               &unpacked[0], unpacked.size(),
+                                               &size));
+    }
+
+    /** Ausschnitte mit Blockverzeichnis, auch über Blockgrenzen */
+    void testRange()
+    {
+        const uint64_t ranges[][2] =
+        {
+            {0, UINT64_MAX}, {0, 1}, {4095, 2}, {5000, 20000},
+            {99990, 100}, {100000, 10}, {200000, 10}, {12345, 0}
+        };
+        BYTES data = generate(TEXT, 100000, 5);
+        BYTES packed;
+        size_t i;
+
+        options.block_size = 4096;
+        packed = pack_file(data, &options);
+        for (i = 0; i < sizeof (ranges) / sizeof (ranges[0]); i++)
+        {
+            uint64_t offset = ranges[i][0];
+            uint64_t end = (ranges[i][1] > data.size() - offset)
+                    ? data.size() : offset + ranges[i][1];
+            BYTES expected;
+            std::ostringstream label;
+
+            if (offset < data.size())
+            {
+                expected.assign(data.begin() + (long) offset,
+                                data.begin() + (long) end);
+            }
+            options.range_offset = offset;
+            options.range_length = ranges[i][1];
+            label << "Ausschnitt " << offset << ":" << ranges[i][1];
+            CPPUNIT_ASSERT_MESSAGE(label.str(),
+                                   unpack_file(packed, &options) == expected);
+        }
+    }
+
+    /**
+     * Kleine Blöcke übernehmen die Codetabelle ihres Vorgängers bzw. haben
+     * eine kurze Tabelle: kaum länger als ein großer Block und weiterhin
+     * einzeln dekodierbar
+     */
+    void testSmallBlocks()
+    {
+        BYTES data = generate(SKEWED, 200000, 9);
+        BYTES packed;
+        BYTES expected(data.begin() + 50000, data.begin() + 60000);
+        std::ostringstream label;
+        size_t large_size;
+        size_t small_size;
+
+        options.level = 1;
+        large_size = pack_buffer(data, &options).size();
+        options.block_size = 4096;
+        options.threads = 4;
+        small_size = pack_buffer(data, &options).size();
+        label << "4 KiB-Bloecke: " << small_size << " statt " << large_size
+              << " Byte";
+        CPPUNIT_ASSERT_MESSAGE(label.str(),
+                               small_size < large_size + large_size / 25);
+        check_round_trip(data, &options, "Bloecke mit 4 KiB");
+
+        packed = pack_file(data, &options);
+        options.range_offset = 50000;
+        options.range_length = 10000;
+        CPPUNIT_ASSERT(unpack_file(packed, &options) == expected);
+        options.threads = 1;
+        CPPUNIT_ASSERT(unpack_file(packed, &options) == expected);
+    }
+
+    /**
+     * Kleine Blöcke, die nicht komprimierbar sind, werden einzeln in der
+     * gewählten Blockgröße gespeichert, auch zwischen komprimierbaren
+     */
+    void testSmallStoredBlocks()
+    {
+        BYTES data = generate(UNIFORM, 300000, 13);
+        BYTES random = generate(UNIFORM, 32768, 14);
+        BYTES mixed = generate(TEXT, 32768, 15);
+        std::vector<BLOCK_SIZES> blocks;
+        size_t i;
+
+        options.block_size = 32768;
+        options.checksum = true;
+        blocks = read_block_sizes(pack_buffer(data, &options));
+        CPPUNIT_ASSERT_EQUAL((size_t) 10, blocks.size());
+        for (i = 0; i < blocks.size(); i++)
+        {
+            uint32_t raw = (i + 1 < blocks.size())
+                    ? 32768 : (uint32_t) (data.size() - 9 * 32768);
+
+            CPPUNIT_ASSERT_EQUAL(raw, blocks[i].first);
+            CPPUNIT_ASSERT_EQUAL(raw + 6, blocks[i].second);
+        }
+        check_round_trip(data, &options, "Zufall in 32 KiB-Bloecken");
+
+        /* Text, Zufall, Text: nur der zweite Block wird gespeichert */
+        mixed.insert(mixed.end(), random.begin(), random.end());
+        data = generate(TEXT, 65536, 16);
+        mixed.insert(mixed.end(), data.begin(), data.end());
+        blocks = read_block_sizes(pack_buffer(mixed, &options));
+        CPPUNIT_ASSERT_EQUAL((size_t) 4, blocks.size());
+        CPPUNIT_ASSERT_EQUAL((uint32_t) 32768 + 6, blocks[1].second);
+        for (i = 0; i < blocks.size(); i++)
+        {
+            CPPUNIT_ASSERT_EQUAL((uint32_t) 32768, blocks[i].first);
+            CPPUNIT_ASSERT(i == 1 || blocks[i].second < 32768 / 2);
+        }
+        check_round_trip(mixed, &options, "Text und Zufall in 32 KiB-Bloecken");
+    }
+
+    /** Wörterbuch aus Beispielen für viele kleine Dateien */
+    void testDictionary()
+    {
+        TempFile samples[4];
+        char *sample_names[4];
+        TempFile dictionary;
+        size_t plain_size = 0;
+        size_t dictionary_size = 0;
+        uint32_t id;
+        int i;
+
+        for (i = 0; i < 4; i++)
+        {
+            write_file(samples[i].c_name(), generate(TEXT, 2000, (uint32_t) i));
+            sample_names[i] = samples[i].c_name();
+        }
+        id = train_dictionary(sample_names, 4, dictionary.c_name(), &options);
+        CPPUNIT_ASSERT_EQUAL(id, load_dictionary(dictionary.c_name()));
+
+        for (i = 0; i < 20; i++)
+        {
+            BYTES data = generate(TEXT, 100 + 40 * (size_t) i,
+                                  (uint32_t) (100 + i));
+
+            options.dictionary = 0;
+            plain_size += pack_buffer(data, &options).size();
+            options.dictionary = id;
+            dictionary_size += pack_buffer(data, &options).size();
+            check_round_trip(data, &options, "Woerterbuch");
+        }
+        CPPUNIT_ASSERT(dictionary_size < plain_size);
+
+        /* Auch Zeichen, die in den Beispielen fehlen, lassen sich kodieren */
+        check_round_trip(generate(ALL_SYMBOLS, 1000, 1), &options,
+                         "Woerterbuch, alle Zeichen");
+    }
+
+    /**
+     * Eine fehlende, unlesbare bzw. beschädigte Datei im Stapelbetrieb bricht
+     * nur ihren eigenen Auftrag ab; ihre Ausgabe wird gelöscht, die übrigen
+     * Dateien werden vollständig bearbeitet.
+     */
+    void testBatchErrors()
+    {
+        TempFile in[3];
+        TempFile packed[3];
+        TempFile out[3];
+        char *in_names[3];
+        char *packed_names[3];
+        char *out_names[3];
+        BYTES data[3];
+        BYTES truncated;
+        std::string missing = std::string(in[1].c_name()) + ".fehlt";
+        std::string directory = TEMP_TEMPLATE;
+        int i;
+
+        for (i = 0; i < 3; i++)
+        {
+            data[i] = generate(TEXT, 100000 + 1000 * (size_t) i, (uint32_t) i);
+            write_file(in[i].c_name(), data[i]);
+            in_names[i] = in[i].c_name();
+            packed_names[i] = packed[i].c_name();
+            out_names[i] = out[i].c_name();
+        }
+        in_names[1] = &missing[0];
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_IO_ERROR,
+                             compress_batch(in_names, packed_names, 3,
+                                            &options));
+
+        /* Ein Verzeichnis lässt sich öffnen, erst das Lesen schlägt fehl */
+        CPPUNIT_ASSERT(mkdtemp(&directory[0]) != NULL);
+        in_names[1] = &directory[0];
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_IO_ERROR,
+                             compress_batch(in_names, out_names, 3, &options));
+        rmdir(directory.c_str());
+        CPPUNIT_ASSERT_MESSAGE("Ausgabe zum Verzeichnis geloescht",
+                               access(out_names[1], F_OK) != 0);
+
+        /* Eine abgeschnittene Datei endet mitten in einem Block */
+        truncated = read_file(packed_names[0]);
+        truncated.resize(truncated.size() / 2);
+        write_file(packed_names[1], truncated);
+        CPPUNIT_ASSERT_EQUAL((int) EXIT_DC_ERROR,
+                             decompress_batch(packed_names, out_names, 3,
+                                              &options));
+        CPPUNIT_ASSERT(data[0] == read_file(out_names[0]));
+        CPPUNIT_ASSERT(data[2] == read_file(out_names[2]));
+        CPPUNIT_ASSERT_MESSAGE("unvollstaendige Ausgabe geloescht",
+                               access(out_names[1], F_OK) != 0);
+    }
+
+    /**
+     * Komprimieren und Dekomprimieren von Text und nicht komprimierbaren
+     * Daten auf allen Levels dauern höchstens ein festes Vielfaches des
+     * Kopierens derselben Daten in derselben Messung
+     */
+    void testThroughput()
+    {
+        const DISTRIBUTION distributions[] = {TEXT, UNIFORM};
+        size_t d;
+
+        options.threads = 1;
+        for (d = 0; d < sizeof (distributions) / sizeof (distributions[0]);
+             d++)
+        {
+            BYTES data = generate(distributions[d], PERF_SIZE, 7);
+            double copy = copy_seconds(data);
+
+            for (options.level = 1; options.level <= LEVEL_COUNT;
+                 options.level++)
+            {
+                std::ostringstream label;
+                double best_compress = 0.0;
+                double best_decompress = 0.0;
+                int run;
+
+                for (run = 0; run < PERF_RUNS; run++)
+                {
+                    double start = now_seconds();
+                    BYTES packed = pack_buffer(data, &options);
+                    double middle = now_seconds();
+                    BYTES unpacked = unpack_buffer(packed);
+                    double end = now_seconds();
+
+                    CPPUNIT_ASSERT(unpacked == data);
+                    if (best_compress == 0.0 || middle - start < best_compress)
+                    {
+                        best_compress = middle - start;
+                    }
+                    if (best_decompress == 0.0
+                            || end - middle < best_decompress)
+                    {
+                        best_decompress = end - middle;
+                    }
+                }
+                label << "Verteilung " << distributions[d] << ", Level "
+                      << options.level << ": Komprimieren "
+                      << best_compress * 1000.0 << " ms, Dekomprimieren "
+                      << best_decompress * 1000.0 << " ms, Kopieren "
+                      << copy * 1000.0 << " ms";
+                CPPUNIT_ASSERT_MESSAGE(label.str(), best_compress
+                        <= PERF_MAX_COMPRESS_RATIO[options.level - 1] * copy);
+                CPPUNIT_ASSERT_MESSAGE(label.str(), best_decompress
+                        <= PERF_MAX_DECOMPRESS_RATIO * copy);
+            }
+        }
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(HuffmanTest);
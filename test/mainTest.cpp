@@ -5,6 +5,7 @@
 #include <cppunit/extensions/TestFactoryRegistry.h>
 #include <cppunit/CompilerOutputter.h>
 #include <cppunit/XmlOutputter.h>
+#include <fstream>
 
 using namespace CPPUNIT_NS;
 